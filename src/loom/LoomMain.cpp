@@ -10,9 +10,12 @@
 #include <string>
 #include "loom/config/ConfigReader.cpp"
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/BranchBoundOptimizer.h"
 #include "loom/optim/CombOptimizer.h"
 #include "loom/optim/GreedyOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
+#include "loom/optim/PortfolioOptimizer.h"
+#include "loom/optim/Tracer.h"
 #include "shared/rendergraph/Penalties.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "util/geo/PolyLine.h"
@@ -21,27 +24,12 @@
 
 using namespace loom;
 
-// _____________________________________________________________________________
-int main(int argc, char** argv) {
-  // initialize randomness
-  srand(time(NULL) + rand());
-
-  config::Config cfg;
-
-  config::ConfigReader cr;
-  cr.read(&cfg, argc, argv);
-
-  LOGTO(DEBUG, std::cerr) << "Reading graph...";
-  shared::rendergraph::RenderGraph g(5, 1, 5);
-
-  if (cfg.fromDot) {
-    g.readFromDot(&std::cin);
-  } else {
-    g.readFromJson(&std::cin);
-  }
-
-  LOGTO(DEBUG, std::cerr) << "Optimizing...";
+using loom::optim::OptResStats;
+using shared::rendergraph::Penalties;
+using shared::rendergraph::RenderGraph;
 
+// _____________________________________________________________________________
+Penalties penalties(const config::Config& cfg, const RenderGraph& g) {
   double maxCrossPen =
       g.maxDeg() * std::max(cfg.crossPenMultiSameSeg,
                             std::max(cfg.crossPenMultiDiffSeg,
@@ -51,60 +39,102 @@ int main(int argc, char** argv) {
                                            cfg.stationSeparationWeight);
 
   // TODO move this into configuration, at least partially
-  shared::rendergraph::Penalties pens{maxCrossPen,
-                                      maxSepPen,
-                                      cfg.crossPenMultiSameSeg,
-                                      cfg.crossPenMultiDiffSeg,
-                                      cfg.separationPenWeight,
-                                      cfg.stationCrossWeightSameSeg,
-                                      cfg.stationCrossWeightDiffSeg,
-                                      cfg.stationSeparationWeight,
-                                      true,
-                                      true};
-  loom::optim::OptResStats stats;
+  return Penalties{maxCrossPen,
+                   maxSepPen,
+                   cfg.crossPenMultiSameSeg,
+                   cfg.crossPenMultiDiffSeg,
+                   cfg.separationPenWeight,
+                   cfg.stationCrossWeightSameSeg,
+                   cfg.stationCrossWeightDiffSeg,
+                   cfg.stationSeparationWeight,
+                   true,
+                   true};
+}
+
+// _____________________________________________________________________________
+OptResStats optimize(const config::Config& cfg, RenderGraph* g) {
+  LOGTO(DEBUG, std::cerr) << "Optimizing...";
+
+  Penalties pens = penalties(cfg, *g);
+  OptResStats stats;
 
   if (cfg.optimMethod == "ilp-naive") {
     optim::ILPOptimizer ilpOptim(&cfg, pens);
-    stats = ilpOptim.optimize(&g);
+    stats = ilpOptim.optimize(g);
   } else if (cfg.optimMethod == "ilp") {
     optim::ILPEdgeOrderOptimizer ilpEoOptim(&cfg, pens);
-    stats = ilpEoOptim.optimize(&g);
+    stats = ilpEoOptim.optimize(g);
   } else if (cfg.optimMethod == "comb") {
     optim::CombOptimizer ilpCombiOptim(&cfg, pens);
-    stats = ilpCombiOptim.optimize(&g);
+    stats = ilpCombiOptim.optimize(g);
   } else if (cfg.optimMethod == "exhaust") {
     optim::ExhaustiveOptimizer exhausOptim(&cfg, pens);
-    stats = exhausOptim.optimize(&g);
+    stats = exhausOptim.optimize(g);
   } else if (cfg.optimMethod == "hillc") {
     optim::HillClimbOptimizer hillcOptim(&cfg, pens, false);
-    stats = hillcOptim.optimize(&g);
+    stats = hillcOptim.optimize(g);
   } else if (cfg.optimMethod == "hillc-random") {
     optim::HillClimbOptimizer hillcOptim(&cfg, pens, true);
-    stats = hillcOptim.optimize(&g);
+    stats = hillcOptim.optimize(g);
   } else if (cfg.optimMethod == "anneal") {
     optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, false);
-    stats = annealOptim.optimize(&g);
+    stats = annealOptim.optimize(g);
   } else if (cfg.optimMethod == "anneal-random") {
     optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, true);
-    stats = annealOptim.optimize(&g);
+    stats = annealOptim.optimize(g);
   } else if (cfg.optimMethod == "greedy") {
     optim::GreedyOptimizer greedyOptim(&cfg, pens, false);
-    stats = greedyOptim.optimize(&g);
+    stats = greedyOptim.optimize(g);
   } else if (cfg.optimMethod == "greedy-lookahead") {
     optim::GreedyOptimizer greedyOptim(&cfg, pens, true);
-    stats = greedyOptim.optimize(&g);
+    stats = greedyOptim.optimize(g);
+  } else if (cfg.optimMethod == "bnb") {
+    optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
+    stats = bnbOptim.optimize(g);
+  } else if (cfg.optimMethod == "portfolio") {
+    optim::PortfolioOptimizer portfolioOptim(&cfg, pens);
+    stats = portfolioOptim.optimize(g);
   } else if (cfg.optimMethod == "null") {
     optim::NullOptimizer nullOptim(&cfg, pens);
-    stats = nullOptim.optimize(&g);
+    stats = nullOptim.optimize(g);
   } else {
     LOG(ERROR) << "Unknown optimization method " << cfg.optimMethod
                << std::endl;
     exit(1);
   }
 
+  return stats;
+}
+
+// _____________________________________________________________________________
+void writeCompStats(std::ostream* out, size_t graph, const OptResStats& stats) {
+  for (const auto& cs : stats.compStats) {
+    (*out) << graph << "," << cs.comp << "," << cs.numNodes << ","
+           << cs.numEdges << "," << cs.maxCard << "," << cs.solSp << ","
+           << cs.method << "," << cs.time << ",";
+    if (cs.gap >= 0) (*out) << cs.gap;
+    (*out) << "\n";
+  }
+}
+
+// _____________________________________________________________________________
+void write(const config::Config& cfg, const RenderGraph& g,
+           const OptResStats& stats) {
+  optim::TraceSpan span("io", "write");
   util::geo::output::GeoGraphJsonOutput out;
 
   if (cfg.writeStats) {
+    util::json::Array compGaps, compTimes;
+    for (const auto& cs : stats.compStats) {
+      // the gap is left out if it is unknown
+      util::json::Dict comp = {{"component", cs.comp}};
+      if (cs.gap >= 0) comp["gap"] = cs.gap;
+      compGaps.push_back(comp);
+
+      compTimes.push_back(
+          util::json::Dict{{"component", cs.comp}, {"time", cs.time}});
+    }
+
     util::json::Dict jsonStats = {
         {"statistics",
          util::json::Dict{
@@ -141,11 +171,74 @@ int main(int argc, char** argv) {
              {"best_num_diff_seg_crossings", stats.diffSegCrossings},
              {"best_num_separations", stats.separations},
              {"line_graph_simplification_time", stats.simplificationTime},
+             {"optgraph_comp_optimality_gaps", compGaps},
+             {"optgraph_comp_solve_times", compTimes},
              {"best_score", stats.score}}}};
     out.printLatLng(g, std::cout, jsonStats);
   } else {
     out.printLatLng(g, std::cout);
   }
+}
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  // initialize randomness
+  srand(time(NULL) + rand());
+
+  config::Config cfg;
+
+  config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  if (!cfg.tracePath.empty()) optim::Tracer::enable();
+
+  std::ofstream compStats;
+  if (!cfg.compStatsPath.empty()) {
+    compStats.open(cfg.compStatsPath);
+    compStats << "graph,component,nodes,edges,max_card,solution_space_size,"
+              << "method,solve_time,gap\n";
+  }
+
+  if (cfg.streamGraphs) {
+    // each graph is optimized and written before the next one is read, so
+    // only a single graph is held in memory at any time
+    size_t i = 0;
+    while ((std::cin >> std::ws).peek() != EOF) {
+      LOGTO(DEBUG, std::cerr) << "Reading graph " << i << "...";
+      RenderGraph g(5, 1, 5);
+      {
+        optim::TraceSpan span("io", "read");
+        g.readFromJson(&std::cin);
+      }
+
+      const auto& stats = optimize(cfg, &g);
+      if (compStats.is_open()) writeCompStats(&compStats, i, stats);
+      write(cfg, g, stats);
+      std::cout << std::endl;
+      i++;
+    }
+  } else {
+    LOGTO(DEBUG, std::cerr) << "Reading graph...";
+    RenderGraph g(5, 1, 5);
+
+    {
+      optim::TraceSpan span("io", "read");
+      if (cfg.fromDot) {
+        g.readFromDot(&std::cin);
+      } else {
+        g.readFromJson(&std::cin);
+      }
+    }
+
+    const auto& stats = optimize(cfg, &g);
+    if (compStats.is_open()) writeCompStats(&compStats, 0, stats);
+    write(cfg, g, stats);
+  }
+
+  if (!cfg.tracePath.empty()) {
+    std::ofstream f(cfg.tracePath);
+    optim::Tracer::writeChromeTrace(&f);
+  }
 
   return (0);
 }
@@ -0,0 +1,526 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "3rdparty/json.hpp"
+#include "loom/_config.h"
+
+// Runs the loom binary with every optimization method on a set of datasets
+// and records its statistics and peak memory usage as JSON. Each run is a
+// separate process, so memory usage and crashes are isolated per run.
+
+using nlohmann::json;
+
+static const std::vector<std::string> METHODS{
+    "ilp-naive", "ilp", "comb", "exhaust", "hillc", "hillc-random", "anneal",
+    "anneal-random", "greedy", "greedy-lookahead", "bnb", "portfolio", "null"};
+
+// methods whose result does not depend on randomness or timing, their scores
+// must not increase at all
+static const std::set<std::string> DETERMINISTIC{"greedy", "greedy-lookahead",
+                                                 "null"};
+
+// line cardinalities of the synthetic graphs
+static const std::vector<size_t> SYNTH_CARDS{8, 16, 32};
+
+struct Dataset {
+  std::string name;
+  std::string path;
+  bool tmp;
+};
+
+struct BenchConfig {
+  std::string loomPath;
+  std::string outputPath;
+  std::string baselinePath;
+  std::vector<std::string> methods;
+  std::vector<std::pair<std::string, bool>> inputs;
+  bool synth = true;
+  int timeBudgetMs = 10000;
+  int timeout = 600;
+  double tolerance = 1.25;
+};
+
+// _____________________________________________________________________________
+void help(const char* bin) {
+  std::cout << std::setfill(' ') << std::left << "loomBench (part of LOOM) "
+            << VERSION_FULL << "\n\n"
+            << "Usage: " << bin << " [options]\n\n"
+            << "Allowed options:\n\n"
+            << std::setw(41) << "  -h [ --help ]"
+            << "show this help message\n"
+            << std::setw(41) << "  --loom arg"
+            << "loom binary, defaults to the one next to this\n"
+            << std::setw(41) << " "
+            << " binary\n"
+            << std::setw(41) << "  -m [ --optim-methods ] arg (=all)"
+            << "Comma-separated optimization methods to run\n"
+            << std::setw(41) << "  -i [ --input ] arg"
+            << "Dataset file or directory (lat/lng coordinates),\n"
+            << std::setw(41) << " "
+            << " defaults to ../examples\n"
+            << std::setw(41) << "  -w [ --input-web-merc ] arg"
+            << "Dataset file or directory (web mercator coords),\n"
+            << std::setw(41) << " "
+            << " defaults to ../src/loom/tests/datasets\n"
+            << std::setw(41) << "  --no-synth"
+            << "Don't run the synthetic high-cardinality graphs\n"
+            << std::setw(41) << "  --time-budget-ms arg (=10000)"
+            << "Time budget of each loom run (milliseconds)\n"
+            << std::setw(41) << "  --timeout arg (=600)"
+            << "Kill a loom run after this many seconds\n"
+            << std::setw(41) << "  -o [ --output ] arg"
+            << "Write results to this file, default is stdout\n"
+            << std::setw(41) << "  -c [ --compare ] arg"
+            << "Compare results against this baseline, exit\n"
+            << std::setw(41) << " "
+            << " with 1 on regressions\n"
+            << std::setw(41) << "  --tolerance arg (=1.25)"
+            << "Allowed factor for time and memory increases,\n"
+            << std::setw(41) << " "
+            << " and for score increases of methods which are\n"
+            << std::setw(41) << " "
+            << " randomized or depend on the time budget\n";
+}
+
+// _____________________________________________________________________________
+std::vector<std::string> split(const std::string& s, char c) {
+  std::vector<std::string> ret;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, c)) {
+    if (!item.empty()) ret.push_back(item);
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+void readConfig(BenchConfig* cfg, int argc, char** argv) {
+  struct option ops[] = {{"help", no_argument, 0, 'h'},
+                         {"loom", required_argument, 0, 1},
+                         {"optim-methods", required_argument, 0, 'm'},
+                         {"input", required_argument, 0, 'i'},
+                         {"input-web-merc", required_argument, 0, 'w'},
+                         {"no-synth", no_argument, 0, 2},
+                         {"time-budget-ms", required_argument, 0, 3},
+                         {"timeout", required_argument, 0, 4},
+                         {"output", required_argument, 0, 'o'},
+                         {"compare", required_argument, 0, 'c'},
+                         {"tolerance", required_argument, 0, 5},
+                         {0, 0, 0, 0}};
+
+  int c;
+  while ((c = getopt_long(argc, argv, ":hm:i:w:o:c:", ops, 0)) != -1) {
+    switch (c) {
+      case 'h':
+        help(argv[0]);
+        exit(0);
+      case 1:
+        cfg->loomPath = optarg;
+        break;
+      case 'm':
+        cfg->methods = split(optarg, ',');
+        break;
+      case 'i':
+        cfg->inputs.push_back({optarg, false});
+        break;
+      case 'w':
+        cfg->inputs.push_back({optarg, true});
+        break;
+      case 2:
+        cfg->synth = false;
+        break;
+      case 3:
+        cfg->timeBudgetMs = atoi(optarg);
+        break;
+      case 4:
+        cfg->timeout = atoi(optarg);
+        break;
+      case 'o':
+        cfg->outputPath = optarg;
+        break;
+      case 'c':
+        cfg->baselinePath = optarg;
+        break;
+      case 5:
+        cfg->tolerance = atof(optarg);
+        break;
+      case ':':
+        std::cerr << argv[optind - 1];
+        std::cerr << " requires an argument" << std::endl;
+        exit(1);
+      case '?':
+        std::cerr << argv[optind - 1];
+        std::cerr << " option unknown" << std::endl;
+        exit(1);
+    }
+  }
+
+  if (cfg->loomPath.empty()) {
+    std::string bin = argv[0];
+    size_t pos = bin.rfind('/');
+    cfg->loomPath = bin.substr(0, pos == std::string::npos ? 0 : pos + 1);
+    cfg->loomPath += "loom";
+  }
+
+  if (cfg->methods.empty()) cfg->methods = METHODS;
+
+  if (cfg->inputs.empty()) {
+    cfg->inputs.push_back({"../examples", false});
+    cfg->inputs.push_back({"../src/loom/tests/datasets", true});
+  }
+}
+
+// _____________________________________________________________________________
+std::string writeTmp(const json& j) {
+  char name[] = "/tmp/loombench-XXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0) throw std::runtime_error("Could not create temporary file");
+  close(fd);
+
+  std::ofstream f(name);
+  f << j;
+  return name;
+}
+
+// _____________________________________________________________________________
+void toLatLng(json* coords) {
+  // single point
+  if (coords->size() && (*coords)[0].is_number()) {
+    double x = (*coords)[0], y = (*coords)[1];
+    const double r = 6378137.0;
+    (*coords)[0] = x / r * 180.0 / M_PI;
+    (*coords)[1] = (2.0 * atan(exp(y / r)) - M_PI / 2.0) * 180.0 / M_PI;
+    return;
+  }
+  for (auto& c : *coords) toLatLng(&c);
+}
+
+// _____________________________________________________________________________
+void addDataset(const std::string& path, bool webMerc,
+                std::vector<Dataset>* ret) {
+  DIR* dir = opendir(path.c_str());
+  if (dir) {
+    std::vector<std::string> files;
+    while (dirent* ent = readdir(dir)) {
+      std::string name = ent->d_name;
+      if (name.size() > 5 && name.substr(name.size() - 5) == ".json") {
+        files.push_back(path + "/" + name);
+      }
+    }
+    closedir(dir);
+
+    // stable dataset order, independent of the directory listing
+    std::sort(files.begin(), files.end());
+    for (const auto& f : files) addDataset(f, webMerc, ret);
+    return;
+  }
+
+  if (!webMerc) {
+    ret->push_back({path, path, false});
+    return;
+  }
+
+  // loom expects lat/lng coordinates
+  std::ifstream f(path);
+  if (!f.good()) throw std::runtime_error("Could not read " + path);
+  json j;
+  f >> j;
+  for (auto& feature : j["features"]) {
+    toLatLng(&feature["geometry"]["coordinates"]);
+  }
+  ret->push_back({path, writeTmp(j), true});
+}
+
+// _____________________________________________________________________________
+json synthGraph(size_t card, size_t len, size_t seed) {
+  // A trunk of len edges which is traversed by card lines, each over a random
+  // interval. At both ends of its interval, a line leaves the trunk to the left
+  // or to the right, over a side edge which is shared with all other lines
+  // leaving to the same side at the same trunk node.
+  std::mt19937 rng(seed);
+
+  std::vector<size_t> from(card), to(card);
+  std::vector<bool> leftFrom(card), leftTo(card);
+  for (size_t l = 0; l < card; l++) {
+    from[l] = rng() % len;
+    to[l] = from[l] + 1 + rng() % (len - from[l]);
+    leftFrom[l] = rng() % 2;
+    leftTo[l] = rng() % 2;
+  }
+
+  auto pt = [](double x, double y) { return json::array({x, y}); };
+  auto line = [](size_t l) {
+    return json{{"id", "L" + std::to_string(l)},
+                {"label", "L" + std::to_string(l)},
+                {"color", "000000"}};
+  };
+
+  json feats = json::array();
+
+  for (size_t i = 0; i <= len; i++) {
+    for (const auto& nd : {std::make_pair("t", 0.0), std::make_pair("l", 0.01),
+                           std::make_pair("r", -0.01)}) {
+      feats.push_back(
+          {{"type", "Feature"},
+           {"geometry",
+            {{"type", "Point"}, {"coordinates", pt(0.01 * i, nd.second)}}},
+           {"properties", {{"id", nd.first + std::to_string(i)}}}});
+    }
+  }
+
+  auto edg = [&](const std::string& fr, const std::string& to, json frPt,
+                 json toPt, json lines) {
+    if (lines.empty()) return;
+    feats.push_back(
+        {{"type", "Feature"},
+         {"geometry",
+          {{"type", "LineString"}, {"coordinates", json::array({frPt, toPt})}}},
+         {"properties",
+          {{"from", fr},
+           {"to", to},
+           {"id", fr + "-" + to},
+           {"lines", lines}}}});
+  };
+
+  for (size_t i = 0; i <= len; i++) {
+    json trunk = json::array(), left = json::array(), right = json::array();
+    for (size_t l = 0; l < card; l++) {
+      if (from[l] <= i && i < to[l]) trunk.push_back(line(l));
+      if (from[l] == i) (leftFrom[l] ? left : right).push_back(line(l));
+      if (to[l] == i) (leftTo[l] ? left : right).push_back(line(l));
+    }
+
+    std::string t = "t" + std::to_string(i);
+    edg(t, "t" + std::to_string(i + 1), pt(0.01 * i, 0), pt(0.01 * (i + 1), 0),
+        trunk);
+    edg(t, "l" + std::to_string(i), pt(0.01 * i, 0), pt(0.01 * i, 0.01), left);
+    edg(t, "r" + std::to_string(i), pt(0.01 * i, 0), pt(0.01 * i, -0.01),
+        right);
+  }
+
+  return {{"type", "FeatureCollection"}, {"features", feats}};
+}
+
+// _____________________________________________________________________________
+json run(const BenchConfig& cfg, const Dataset& ds, const std::string& method) {
+  json ret{{"dataset", ds.name}, {"method", method}, {"ok", false}};
+
+  int out[2];
+  if (pipe(out) != 0) throw std::runtime_error("Could not create pipe");
+
+  auto start = std::chrono::steady_clock::now();
+
+  pid_t pid = fork();
+  if (pid < 0) throw std::runtime_error("Could not fork");
+
+  if (pid == 0) {
+    int in = open(ds.path.c_str(), O_RDONLY);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (in < 0 || devNull < 0) _exit(127);
+    dup2(in, 0);
+    dup2(out[1], 1);
+    dup2(devNull, 2);
+    close(out[0]);
+
+    // kept across exec, kills loom once the timeout is reached
+    alarm(cfg.timeout);
+
+    std::string budget = std::to_string(cfg.timeBudgetMs);
+    execl(cfg.loomPath.c_str(), cfg.loomPath.c_str(), "-m", method.c_str(),
+          "--write-stats", "--time-budget-ms", budget.c_str(), (char*)0);
+    _exit(127);
+  }
+
+  close(out[1]);
+
+  std::string output;
+  char buf[1 << 16];
+  ssize_t n;
+  while ((n = read(out[0], buf, sizeof(buf))) > 0) output.append(buf, n);
+  close(out[0]);
+
+  int status;
+  struct rusage usage;
+  wait4(pid, &status, 0, &usage);
+
+  double wallTime = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  ret["wall_time"] = wallTime;
+  ret["peak_rss_kb"] = usage.ru_maxrss;
+
+  if (WIFSIGNALED(status)) {
+    ret["error"] = "killed by signal " + std::to_string(WTERMSIG(status));
+    return ret;
+  }
+
+  if (WEXITSTATUS(status) != 0) {
+    ret["error"] = "exited with " + std::to_string(WEXITSTATUS(status));
+    return ret;
+  }
+
+  json res = json::parse(output, nullptr, false);
+  if (res.is_discarded() || !res.count("properties") ||
+      !res["properties"].count("statistics")) {
+    ret["error"] = "no statistics in output";
+    return ret;
+  }
+
+  const auto& stats = res["properties"]["statistics"];
+
+  ret["ok"] = true;
+  ret["simplification_time"] = stats["line_graph_simplification_time"];
+  ret["solve_time"] = stats["avg_solve_time"];
+  ret["comp_solve_times"] = stats["optgraph_comp_solve_times"];
+  ret["solution_space_size"] = stats["optgraph_solution_space_size"];
+  ret["score"] = stats["best_score"];
+  ret["same_seg_crossings"] = stats["best_num_same_seg_crossings"];
+  ret["diff_seg_crossings"] = stats["best_num_diff_seg_crossings"];
+  ret["separations"] = stats["best_num_separations"];
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+bool exceeds(const json& cur, const json& base, const std::string& key,
+             double tolerance, double minDiff) {
+  if (!cur.count(key) || !base.count(key)) return false;
+  double c = cur[key], b = base[key];
+  return c > b * tolerance && c - b > minDiff;
+}
+
+// _____________________________________________________________________________
+size_t compare(const json& res, const json& baseline, double tolerance) {
+  size_t regressions = 0;
+
+  for (const auto& cur : res["runs"]) {
+    const json* base = 0;
+    for (const auto& b : baseline["runs"]) {
+      if (b["dataset"] == cur["dataset"] && b["method"] == cur["method"]) {
+        base = &b;
+        break;
+      }
+    }
+
+    if (!base) continue;
+
+    std::vector<std::string> issues;
+
+    if ((*base)["ok"] && !cur["ok"]) {
+      issues.push_back("failed: " + cur["error"].get<std::string>());
+    } else if ((*base)["ok"] && cur["ok"]) {
+      // randomized and time-budgeted methods may find a worse ordering in
+      // a single run without any regression in the code
+      bool exact = DETERMINISTIC.count(cur["method"].get<std::string>());
+      if (exceeds(cur, *base, "score", exact ? 1 : tolerance, 0)) {
+        issues.push_back("score " + (*base)["score"].dump() + " -> " +
+                         cur["score"].dump());
+      }
+
+      // small absolute differences are considered noise
+      if (exceeds(cur, *base, "solve_time", tolerance, 10)) {
+        issues.push_back("solve time " + (*base)["solve_time"].dump() +
+                         " ms -> " + cur["solve_time"].dump() + " ms");
+      }
+
+      if (exceeds(cur, *base, "peak_rss_kb", tolerance, 1024)) {
+        issues.push_back("peak RSS " + (*base)["peak_rss_kb"].dump() +
+                         " kB -> " + cur["peak_rss_kb"].dump() + " kB");
+      }
+    }
+
+    for (const auto& issue : issues) {
+      std::cerr << "REGRESSION " << cur["method"].get<std::string>() << " on "
+                << cur["dataset"].get<std::string>() << ": " << issue
+                << std::endl;
+    }
+
+    regressions += issues.size();
+  }
+
+  return regressions;
+}
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  BenchConfig cfg;
+  readConfig(&cfg, argc, argv);
+
+  std::vector<Dataset> datasets;
+  for (const auto& in : cfg.inputs) addDataset(in.first, in.second, &datasets);
+
+  if (cfg.synth) {
+    for (size_t card : SYNTH_CARDS) {
+      datasets.push_back({"synth-trunk-card-" + std::to_string(card),
+                          writeTmp(synthGraph(card, 12, card)), true});
+    }
+  }
+
+  json res{{"loom_version", VERSION_FULL},
+           {"time_budget_ms", cfg.timeBudgetMs},
+           {"runs", json::array()}};
+
+  for (const auto& ds : datasets) {
+    for (const auto& method : cfg.methods) {
+      std::cerr << method << " on " << ds.name << "... " << std::flush;
+      json r = run(cfg, ds, method);
+      if (r["ok"]) {
+        std::cerr << r["solve_time"] << " ms, score " << r["score"]
+                  << std::endl;
+      } else {
+        std::cerr << r["error"].get<std::string>() << std::endl;
+      }
+      res["runs"].push_back(r);
+    }
+  }
+
+  for (const auto& ds : datasets) {
+    if (ds.tmp) unlink(ds.path.c_str());
+  }
+
+  if (cfg.outputPath.empty()) {
+    std::cout << res.dump(2) << std::endl;
+  } else {
+    std::ofstream f(cfg.outputPath);
+    f << res.dump(2) << std::endl;
+  }
+
+  if (!cfg.baselinePath.empty()) {
+    std::ifstream f(cfg.baselinePath);
+    if (!f.good()) {
+      std::cerr << "Could not read baseline " << cfg.baselinePath << std::endl;
+      return 1;
+    }
+    json baseline;
+    f >> baseline;
+
+    size_t regressions = compare(res, baseline, cfg.tolerance);
+    std::cerr << regressions << " regression(s) against " << cfg.baselinePath
+              << std::endl;
+    if (regressions) return 1;
+  }
+
+  return 0;
+}
@@ -48,7 +48,9 @@ void ConfigReader::help(const char* bin) const {
             << std::setw(41) << " "
             << " comb, exhaust, hillc, hillc-random, anneal,\n"
             << std::setw(41) << " "
-            << " anneal-random, greedy, greedy-lookahead, null\n"
+            << " anneal-random, greedy, greedy-lookahead, bnb,\n"
+            << std::setw(41) << " "
+            << " portfolio, null\n"
             << std::setw(41) << "  --same-seg-cross-pen arg (=4)"
             << "Penalty for same-segment crossings\n"
             << std::setw(41) << "  --diff-seg-cross-pen arg (=1)"
@@ -64,10 +66,24 @@ void ConfigReader::help(const char* bin) const {
             << "Misc:\n"
             << std::setw(41) << "  -D [ --from-dot ]"
             << "input is in dot format\n"
+            << std::setw(41) << "  --stream"
+            << "Input is a sequence of graphs (e.g. components\n"
+            << std::setw(41) << " "
+            << " written by topo), optimize and write each one\n"
+            << std::setw(41) << " "
+            << " before the next is read\n"
             << std::setw(41) << "  --output-stats"
             << "Print stats to stdout\n"
             << std::setw(41) << "  --write-stats"
             << "Write stats to output\n"
+            << std::setw(41) << "  --optim-threads arg (=0)"
+            << "Number of threads used to optimize independent\n"
+            << std::setw(41) << " "
+            << " components, 0 means number of cores\n"
+            << std::setw(41) << "  --optim-cache-dir arg"
+            << "Existing directory to cache component orderings\n"
+            << std::setw(41) << " "
+            << " in, no caching if empty\n"
             << std::setw(41) << "  --ilp-solver arg (=gurobi)"
             << "Preferred ILP solver, either glpk, cbc, or gurobi.\n"
             << std::setw(41) << " "
@@ -78,10 +94,46 @@ void ConfigReader::help(const char* bin) const {
             << " 0 means solver default\n"
             << std::setw(41) << "  --ilp-time-limit arg (=-1)"
             << "ILP solve time limit (seconds), -1 for infinite\n"
+            << std::setw(41) << "  --ilp-no-warm-start"
+            << "Don't pass the hill climbing ordering as an\n"
+            << std::setw(41) << " "
+            << " initial solution to the ILP solver\n"
+            << std::setw(41) << "  --ilp-lazy-crossings"
+            << "Only add crossing constraints to the ILP once\n"
+            << std::setw(41) << " "
+            << " they are violated, solve repeatedly\n"
+            << std::setw(41) << "  --bnb-time-limit arg (=60)"
+            << "Branch and bound time limit per component\n"
+            << std::setw(41) << " "
+            << " (seconds), -1 for infinite\n"
+            << std::setw(41) << "  --portfolio-time-limit arg (=60)"
+            << "Time limit of the portfolio race per component\n"
+            << std::setw(41) << " "
+            << " (seconds), -1 for infinite\n"
+            << std::setw(41) << "  --time-budget-ms arg (=-1)"
+            << "Total optimization time budget (milliseconds),\n"
+            << std::setw(41) << " "
+            << " take the best orderings found so far once it is\n"
+            << std::setw(41) << " "
+            << " used up, -1 for infinite\n"
+            << std::setw(41) << "  --max-bridge-card arg (=3)"
+            << "Solve both sides of bridge edges with at most\n"
+            << std::setw(41) << " "
+            << " this many lines separately, 0 disables, at\n"
+            << std::setw(41) << " "
+            << " most 8\n"
             << std::setw(41) << "  --dbg-output-path arg (=.)"
             << "Path used for debug output\n"
             << std::setw(41) << "  --output-optgraph"
-            << "Output optimization graph to debug path\n";
+            << "Output optimization graph to debug path\n"
+            << std::setw(41) << "  --trace-path arg"
+            << "Write a trace of the optimization phases to\n"
+            << std::setw(41) << " "
+            << " this file, as Chrome trace-event JSON\n"
+            << std::setw(41) << "  --comp-stats-path arg"
+            << "Write per-component statistics to this file, as\n"
+            << std::setw(41) << " "
+            << " CSV\n";
 }
 
 // _____________________________________________________________________________
@@ -107,6 +159,17 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       {"dbg-output-path", required_argument, 0, 14},
       {"output-optgraph", required_argument, 0, 15},
       {"write-stats", no_argument, 0, 16},
+      {"optim-threads", required_argument, 0, 17},
+      {"bnb-time-limit", required_argument, 0, 18},
+      {"optim-cache-dir", required_argument, 0, 19},
+      {"ilp-no-warm-start", no_argument, 0, 20},
+      {"ilp-lazy-crossings", no_argument, 0, 21},
+      {"portfolio-time-limit", required_argument, 0, 22},
+      {"time-budget-ms", required_argument, 0, 23},
+      {"stream", no_argument, 0, 24},
+      {"trace-path", required_argument, 0, 25},
+      {"comp-stats-path", required_argument, 0, 26},
+      {"max-bridge-card", required_argument, 0, 27},
       {0, 0, 0, 0}};
 
   int c;
@@ -169,6 +232,46 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 16:
         cfg->writeStats = true;
         break;
+      case 17:
+        cfg->optimThreads = atoi(optarg);
+        break;
+      case 18:
+        cfg->bnbTimeLimit = atoi(optarg);
+        break;
+      case 19:
+        cfg->optimCacheDir = optarg;
+        break;
+      case 20:
+        cfg->ilpWarmStart = false;
+        break;
+      case 21:
+        cfg->ilpLazyCrossings = true;
+        break;
+      case 22:
+        cfg->portfolioTimeLimit = atoi(optarg);
+        break;
+      case 23:
+        cfg->timeBudgetMs = atoi(optarg);
+        break;
+      case 24:
+        cfg->streamGraphs = true;
+        break;
+      case 25:
+        cfg->tracePath = optarg;
+        break;
+      case 26:
+        cfg->compStatsPath = optarg;
+        break;
+      case 27:
+        // both sides of the bridge are reconciled by trying all orderings
+        // of its lines
+        if (atoi(optarg) < 0 || atoi(optarg) > 8) {
+          std::cerr << "--max-bridge-card must be between 0 and 8"
+                    << std::endl;
+          exit(1);
+        }
+        cfg->maxBridgeCard = atoi(optarg);
+        break;
       case 'D':
         cfg->fromDot = true;
         break;
@@ -187,4 +290,10 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
         break;
     }
   }
+
+  if (cfg->streamGraphs && cfg->fromDot) {
+    // streaming reads one JSON graph after the other
+    std::cerr << "--stream cannot be combined with --from-dot" << std::endl;
+    exit(1);
+  }
 }
@@ -14,11 +14,15 @@ struct Config {
   std::string name;
   std::string outputPath;
   std::string dbgPath;
+  std::string tracePath;
+  std::string compStatsPath;
 
   std::string optimMethod = "comb";
   std::string MPSOutputPath;
+  std::string optimCacheDir;
 
   size_t optimRuns = 1;
+  size_t optimThreads = 0;
 
   bool outOptGraph = false;
 
@@ -28,9 +32,19 @@ struct Config {
 
   bool untangleGraph = true;
   bool fromDot = false;
+  bool streamGraphs = false;
 
   int ilpTimeLimit = -1;
   int ilpNumThreads = 0;
+  bool ilpWarmStart = true;
+  bool ilpLazyCrossings = false;
+
+  int bnbTimeLimit = 60;
+  int portfolioTimeLimit = 60;
+
+  int timeBudgetMs = -1;
+
+  size_t maxBridgeCard = 3;
 
   double crossPenMultiSameSeg = 4;
   double crossPenMultiDiffSeg = 1;
@@ -0,0 +1,269 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <vector>
+#include "loom/optim/BranchBoundOptimizer.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+using loom::optim::BnBState;
+using loom::optim::BranchBoundOptimizer;
+using loom::optim::OptEdge;
+using loom::optim::OptNode;
+using loom::optim::OptOrderCfg;
+using loom::optim::OptResStats;
+using shared::rendergraph::HierarOrderCfg;
+using util::factorial;
+
+// up to this number of orderings per edge, the orderings are sorted by their
+// lower bound before branching
+const static double MAX_SORTED_CHILDREN = 5040;
+
+// _____________________________________________________________________________
+double BranchBoundOptimizer::optimizeComp(OptGraph* og,
+                                          const std::set<OptNode*>& g,
+                                          HierarOrderCfg* hc, size_t depth,
+                                          OptResStats& stats) const {
+  UNUSED(og);
+  LOGTO(DEBUG, std::cerr) << prefix(depth)
+                          << "(BranchBoundOptimizer) Optimizing component with "
+                          << g.size() << " nodes.";
+
+  T_START(1);
+
+  BnBState s;
+
+  // the local optimum is the initial upper bound
+  climb(g, &s.best);
+  s.bestScore = 0;
+  for (auto n : g) s.bestScore += score(n, s.best);
+
+  s.cur = s.best;
+  s.assigned.resize(s.cur.size(), false);
+  for (auto n : g) {
+    s.open[n] = n->getDeg();
+    s.bound[n] = 0;
+  }
+
+  s.visited = 0;
+  // the race may already be over after climbing
+  s.aborted = raceOver();
+  s.hasDeadline = _cfg->bnbTimeLimit >= 0;
+  s.deadline = std::chrono::steady_clock::now() +
+               std::chrono::seconds(std::max(0, _cfg->bnbTimeLimit));
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "Initial upper bound is "
+                          << s.bestScore;
+
+  if (s.bestScore > 0 && !s.aborted) {
+    s.order = getAssignOrder(g);
+    branch(&s, 0, 0);
+  }
+
+  if (s.aborted && raceOver()) {
+    LOGTO(DEBUG, std::cerr) << prefix(depth) << "Race is over, best score "
+                            << "found is " << s.bestScore;
+  } else if (s.aborted) {
+    LOGTO(WARN, std::cerr) << prefix(depth) << "Time limit of "
+                           << _cfg->bnbTimeLimit
+                           << "s reached, best score found is "
+                           << s.bestScore << ", but it might not be optimal.";
+  } else {
+    LOGTO(DEBUG, std::cerr) << prefix(depth) << "Found optimal score "
+                            << s.bestScore << " after visiting " << s.visited
+                            << " search nodes.";
+    stats.gap = 0;
+    raceSolved();
+  }
+
+  writeHierarch(&s.best, hc);
+
+  return T_STOP(1);
+}
+
+// _____________________________________________________________________________
+std::vector<OptEdge*> BranchBoundOptimizer::getAssignOrder(
+    const std::set<OptNode*>& g) const {
+  std::vector<OptEdge*> edges, ret;
+  std::map<const OptNode*, size_t> open;
+
+  for (auto n : g) {
+    open[n] = n->getDeg();
+    for (auto e : n->getAdjList())
+      if (n == e->getFrom()) edges.push_back(e);
+  }
+
+  std::vector<bool> taken(edges.size(), false);
+
+  // greedily take the edge which closes most nodes, then the one which is
+  // adjacent to most assigned edges, then the one with the most lines. Nodes
+  // are closed early this way, so their exact score enters the bound early
+  for (size_t i = 0; i < edges.size(); i++) {
+    size_t best = 0;
+    std::tuple<size_t, size_t, size_t> bestKey{0, 0, 0};
+    bool found = false;
+
+    for (size_t j = 0; j < edges.size(); j++) {
+      if (taken[j]) continue;
+      auto fr = edges[j]->getFrom();
+      auto to = edges[j]->getTo();
+
+      std::tuple<size_t, size_t, size_t> key{
+          (open[fr] == 1) + (open[to] == 1),
+          (fr->getDeg() - open[fr]) + (to->getDeg() - open[to]),
+          edges[j]->pl().getCardinality()};
+
+      if (!found || key > bestKey) {
+        best = j;
+        bestKey = key;
+        found = true;
+      }
+    }
+
+    taken[best] = true;
+    open[edges[best]->getFrom()]--;
+    open[edges[best]->getTo()]--;
+    ret.push_back(edges[best]);
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void BranchBoundOptimizer::branch(BnBState* s, size_t d, double lb) const {
+  if (s->aborted) return;
+
+  if (d == s->order.size()) {
+    // all nodes are closed, the bound is the exact score
+    if (lb < s->bestScore) {
+      s->bestScore = lb;
+      s->best = s->cur;
+    }
+    return;
+  }
+
+  ++s->visited;
+
+  // reading the clock is cheap compared to bounding all children below
+  if ((s->hasDeadline && std::chrono::steady_clock::now() > s->deadline) ||
+      raceOver()) {
+    s->aborted = true;
+    return;
+  }
+
+  auto e = s->order[d];
+  size_t card = e->pl().getCardinality();
+  auto perm = s->cur.perm(e);
+  auto fr = e->getFrom();
+  auto to = e->getTo();
+
+  double frBound = s->bound[fr];
+  double toBound = s->bound[to];
+
+  std::sort(perm, perm + card, std::greater<uint16_t>());
+
+  if (factorial(card) <= MAX_SORTED_CHILDREN) {
+    // try the most promising orderings first
+    std::vector<std::pair<double, std::vector<uint16_t>>> children;
+    do {
+      double inc = boundInc(*s, e);
+      if (lb + inc < s->bestScore)
+        children.push_back({inc, std::vector<uint16_t>(perm, perm + card)});
+    } while (std::next_permutation(perm, perm + card, std::greater<uint16_t>()));
+
+    std::stable_sort(children.begin(), children.end(),
+                     [](const std::pair<double, std::vector<uint16_t>>& a,
+                        const std::pair<double, std::vector<uint16_t>>& b) {
+                       return a.first < b.first;
+                     });
+
+    for (const auto& child : children) {
+      if (lb + child.first >= s->bestScore || s->aborted) break;
+      std::copy(child.second.begin(), child.second.end(), perm);
+
+      assign(s, e);
+      branch(s, d + 1, lb + child.first);
+
+      s->assigned[s->cur.getId(e)] = false;
+      s->open[fr]++;
+      s->open[to]++;
+      s->bound[fr] = frBound;
+      s->bound[to] = toBound;
+    }
+  } else {
+    do {
+      double inc = boundInc(*s, e);
+      if (lb + inc >= s->bestScore) continue;
+
+      assign(s, e);
+      branch(s, d + 1, lb + inc);
+
+      s->assigned[s->cur.getId(e)] = false;
+      s->open[fr]++;
+      s->open[to]++;
+      s->bound[fr] = frBound;
+      s->bound[to] = toBound;
+    } while (!s->aborted && std::next_permutation(perm, perm + card,
+                                                  std::greater<uint16_t>()));
+  }
+}
+
+// _____________________________________________________________________________
+double BranchBoundOptimizer::boundInc(const BnBState& s, OptEdge* e) const {
+  double ret = 0;
+
+  for (auto n : {e->getFrom(), e->getTo()}) {
+    if (s.open.at(n) == 1) {
+      // e closes n
+      ret += score(n, s.cur) - s.bound.at(n);
+      continue;
+    }
+
+    for (auto eb : n->getAdjList()) {
+      if (eb == e || !s.assigned[s.cur.getId(eb)]) continue;
+      ret += pairBound(n, e, eb, s.cur);
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void BranchBoundOptimizer::assign(BnBState* s, OptEdge* e) const {
+  for (auto n : {e->getFrom(), e->getTo()}) {
+    if (s->open[n] == 1) {
+      s->bound[n] = score(n, s->cur);
+    } else {
+      for (auto eb : n->getAdjList()) {
+        if (eb == e || !s->assigned[s->cur.getId(eb)]) continue;
+        s->bound[n] += pairBound(n, e, eb, s->cur);
+      }
+    }
+    s->open[n]--;
+  }
+
+  s->assigned[s->cur.getId(e)] = true;
+}
+
+// _____________________________________________________________________________
+double BranchBoundOptimizer::pairBound(OptNode* n, OptEdge* ea, OptEdge* eb,
+                                       const OptOrderCfg& cfg) const {
+  if (!n->pl().node) return 0;
+
+  auto ab = _optScorer.getNumCrossSeps(n, ea, eb, cfg);
+  auto ba = _optScorer.getNumCrossSeps(n, eb, ea, cfg);
+
+  // same segment crossings are counted from both sides, diff segment
+  // crossings are never negative and left out
+  double ret = ((ab.first.first + ba.first.first) / 2) *
+               _optScorer.getCrossingPenSameSeg(n);
+
+  if (_optScorer.optimizeSep())
+    ret += (ab.second + ba.second) * _optScorer.getSeparationPen(n);
+
+  return ret;
+}
@@ -0,0 +1,77 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
+#define LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
+
+#include <chrono>
+#include <vector>
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/HillClimbOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// state of the branch and bound search on a single component
+struct BnBState {
+  // edges in the order in which they are assigned
+  std::vector<OptEdge*> order;
+
+  // edge id -> true if the edge has already been assigned
+  std::vector<bool> assigned;
+
+  // node -> number of unassigned adjacent edges, and lower bound on the
+  // score of the node
+  std::map<const OptNode*, size_t> open;
+  std::map<const OptNode*, double> bound;
+
+  OptOrderCfg cur, best;
+  double bestScore;
+
+  size_t visited;
+  bool aborted;
+  std::chrono::steady_clock::time_point deadline;
+  bool hasDeadline;
+};
+
+// Exact optimizer which assigns the orderings of the edges one by one and
+// prunes every partial assignment whose lower bound is not better than the
+// best full ordering found so far. The lower bound of a node is its exact
+// score once all adjacent edges are assigned, and otherwise the same segment
+// crossings (and separations) between its assigned edges. The search starts
+// from the hill climbing optimum.
+class BranchBoundOptimizer : public HillClimbOptimizer {
+ public:
+  BranchBoundOptimizer(const config::Config* cfg,
+                       const shared::rendergraph::Penalties& pens)
+      : HillClimbOptimizer(cfg, pens, false){};
+
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const { return "bnb"; }
+
+ private:
+  std::vector<OptEdge*> getAssignOrder(const std::set<OptNode*>& g) const;
+
+  void branch(BnBState* s, size_t d, double lb) const;
+
+  // lower bound increase if e is assigned with its current ordering
+  double boundInc(const BnBState& s, OptEdge* e) const;
+
+  // lower bound of n contributed by the assigned edges ea and eb
+  double pairBound(OptNode* n, OptEdge* ea, OptEdge* eb,
+                   const OptOrderCfg& cfg) const;
+
+  // assign e with its current ordering
+  void assign(BnBState* s, OptEdge* e) const;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
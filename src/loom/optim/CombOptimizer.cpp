@@ -2,13 +2,20 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <exception>
 #include <fstream>
+#include <limits>
+#include <numeric>
 #include <thread>
+#include <unordered_map>
 
 #include "loom/optim/CombOptimizer.h"
 #include "loom/optim/OptGraph.h"
+#include "loom/optim/Tracer.h"
 #include "shared/rendergraph/OrderCfg.h"
 #include "util/String.h"
 #include "util/geo/Geo.h"
@@ -17,8 +24,57 @@
 #include "util/log/Log.h"
 
 using loom::optim::CombOptimizer;
+using loom::optim::OptEdge;
+using loom::optim::OptGraph;
+using loom::optim::OptNode;
+using loom::optim::OptNodePL;
+using loom::optim::OptOrderCfg;
+using loom::optim::TraceSpan;
 using shared::rendergraph::HierarOrderCfg;
 
+// _____________________________________________________________________________
+static double logSolSp(const OptEdge* e) {
+  return std::lgamma(e->pl().getCardinality() + 1.0);
+}
+
+// _____________________________________________________________________________
+static OptEdge* copySide(const std::set<OptNode*>& side, OptEdge* bridge,
+                         OptGraph* sub, std::set<OptNode*>* nds) {
+  // copy the nodes of side and all edges between them into sub, the bridge
+  // ends in a node without a line node, which is never scored. Returns the
+  // copy of the bridge.
+  std::unordered_map<const OptNode*, OptNode*> ndMap;
+  for (auto n : side) ndMap[n] = sub->addNd(n->pl());
+
+  auto far = side.count(bridge->getFrom()) ? bridge->getTo() : bridge->getFrom();
+  ndMap[far] = sub->addNd(OptNodePL(far->pl().p));
+
+  std::unordered_map<const OptEdge*, OptEdge*> edgMap;
+  for (auto n : side) {
+    for (auto e : n->getAdjList()) {
+      if (edgMap.count(e)) continue;
+      edgMap[e] =
+          sub->addEdg(ndMap[e->getFrom()], ndMap[e->getTo()], e->pl());
+    }
+  }
+
+  ndMap[far]->pl().circOrdering.push_back(bridge);
+
+  for (auto& nd : ndMap) {
+    auto& pl = nd.second->pl();
+    std::vector<OptEdge*> circ;
+    pl.circOrderMap.clear();
+    for (auto e : pl.circOrdering) {
+      pl.circOrderMap[edgMap[e]] = circ.size();
+      circ.push_back(edgMap[e]);
+    }
+    pl.circOrdering = circ;
+    nds->insert(nd.second);
+  }
+
+  return edgMap[bridge];
+}
+
 // _____________________________________________________________________________
 double CombOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                                    HierarOrderCfg* hc, size_t depth,
@@ -31,16 +87,288 @@ double CombOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                           << " nodes, max card " << maxC << ", sol space size "
                           << solSp;
 
+  const Optimizer* opt;
+
   if (maxC == 1) {
-    return _nullOpt.optimizeComp(og, g, hc, depth + 1, stats);
-  } else if (solSp < 500) {
-    return _exhausOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    opt = &_nullOpt;
+  } else if (solSp < 500 * numThreads()) {
+    // the exhaustive search scales with the number of threads
+    opt = &_exhausOpt;
   } else {
-    if (_forceILP) return _ilpOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    // forcing the ILP also means solving the component as a whole
+    std::set<OptNode*> side;
+    auto bridge = _forceILP ? 0 : getBridge(g, &side);
+    if (bridge) return optimizeSplit(g, bridge, side, hc, depth, stats);
+
 #if defined GUROBI_FOUND || defined GLPK_FOUND || defined COIN_FOUND
-    return _ilpOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    opt = &_ilpOpt;
 #else
-    return _hillcOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    opt = _forceILP ? static_cast<const Optimizer*>(&_ilpOpt) : &_bnbOpt;
 #endif
   }
+
+  stats.method = opt->getName();
+  return opt->optimizeComp(og, g, hc, depth + 1, stats);
+}
+
+// _____________________________________________________________________________
+OptEdge* CombOptimizer::getBridge(const std::set<OptNode*>& g,
+                                  std::set<OptNode*>* side) const {
+  // Tarjan's bridge search. Each edge is attributed to the DFS subtree of its
+  // lower end, so the solution space sizes of both sides of each bridge are
+  // known once its subtree has been finished. The bridge which splits the
+  // solution space most evenly is taken.
+  if (_cfg->maxBridgeCard == 0) return 0;
+
+  double total = 0;
+  for (auto n : g) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() == n) total += logSolSp(e);
+    }
+  }
+
+  struct Frame {
+    OptNode* n;
+    OptEdge* parent;
+    size_t i;
+  };
+
+  std::unordered_map<const OptNode*, size_t> disc, low;
+  std::unordered_map<const OptNode*, double> below;
+
+  OptEdge* best = 0;
+  OptNode* bestSide = 0;
+  double bestSp = 0;
+
+  std::vector<Frame> stack{{*g.begin(), 0, 0}};
+  disc[*g.begin()] = low[*g.begin()] = 0;
+  below[*g.begin()] = 0;
+
+  while (!stack.empty()) {
+    auto cur = stack.back();
+    if (cur.i < cur.n->getDeg()) {
+      auto e = cur.n->getAdjList()[stack.back().i++];
+      if (e == cur.parent) continue;
+      auto m = e->getOtherNd(cur.n);
+      auto it = disc.find(m);
+      if (it == disc.end()) {
+        size_t id = disc.size();
+        disc[m] = low[m] = id;
+        below[m] = logSolSp(e);
+        stack.push_back({m, e, 0});
+      } else {
+        low[cur.n] = std::min(low[cur.n], it->second);
+        if (it->second < disc[cur.n]) below[cur.n] += logSolSp(e);
+      }
+      continue;
+    }
+
+    stack.pop_back();
+    if (stack.empty()) break;
+
+    auto p = stack.back().n;
+    low[p] = std::min(low[p], low[cur.n]);
+    below[p] += below[cur.n];
+
+    if (low[cur.n] <= disc[p]) continue;
+    if (cur.parent->pl().getCardinality() > _cfg->maxBridgeCard) continue;
+
+    // both sides should be worth solving on their own
+    double sp = std::min(below[cur.n] - logSolSp(cur.parent),
+                         total - below[cur.n]);
+    if (sp > bestSp) {
+      best = cur.parent;
+      bestSide = cur.n;
+      bestSp = sp;
+    }
+  }
+
+  if (!best) return 0;
+
+  std::vector<OptNode*> todo{bestSide};
+  side->insert(bestSide);
+  while (!todo.empty()) {
+    auto n = todo.back();
+    todo.pop_back();
+    for (auto e : n->getAdjList()) {
+      if (e == best) continue;
+      if (side->insert(e->getOtherNd(n)).second) {
+        todo.push_back(e->getOtherNd(n));
+      }
+    }
+  }
+
+  return best;
+}
+
+// _____________________________________________________________________________
+double CombOptimizer::optimizeSplit(const std::set<OptNode*>& g,
+                                    OptEdge* bridge,
+                                    const std::set<OptNode*>& side,
+                                    HierarOrderCfg* hc, size_t depth,
+                                    OptResStats& stats) const {
+  T_START(1);
+
+  TraceSpan span("decompose", "bridge");
+  span.arg("cardinality", bridge->pl().getCardinality());
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(CombOptimizer) Splitting comp "
+                          << "at bridge with cardinality "
+                          << bridge->pl().getCardinality();
+
+  // both sides are optimized in graphs of their own, the original graph is
+  // shared with the other component jobs and left untouched
+  std::set<OptNode*> sides[2];
+  sides[1] = side;
+  for (auto n : g) {
+    if (!side.count(n)) sides[0].insert(n);
+  }
+
+  OptGraph subA(&_scorer), subB(&_scorer);
+  OptGraph* subs[2] = {&subA, &subB};
+  std::set<OptNode*> nds[2];
+  OptEdge* bridges[2];
+
+  for (size_t i = 0; i < 2; i++) {
+    bridges[i] = copySide(sides[i], bridge, subs[i], &nds[i]);
+  }
+
+  HierarOrderCfg res[2];
+  OptResStats sideStats[2] = {stats, stats};
+  std::exception_ptr err[2];
+
+  auto solve = [&](size_t i) {
+    try {
+      optimizeComp(subs[i], nds[i], &res[i], depth + 1, sideStats[i]);
+    } catch (...) {
+      err[i] = std::current_exception();
+    }
+  };
+
+  // the second side is optimized concurrently if there is a thread to spare
+  std::thread thr;
+  if (claimThreads(1)) {
+    const CompRace* budget = jobBudget();
+    thr = std::thread([&, budget]() {
+      setJobBudget(budget);
+      solve(1);
+    });
+  }
+
+  solve(0);
+
+  if (thr.joinable()) {
+    thr.join();
+    releaseThreads(1);
+  } else {
+    solve(1);
+  }
+
+  for (const auto& e : err) {
+    if (e) std::rethrow_exception(e);
+  }
+
+  for (const auto& st : sideStats) {
+    if (st.maxNumRowsPerComp > stats.maxNumRowsPerComp)
+      stats.maxNumRowsPerComp = st.maxNumRowsPerComp;
+    if (st.maxNumColsPerComp > stats.maxNumColsPerComp)
+      stats.maxNumColsPerComp = st.maxNumColsPerComp;
+  }
+
+  stats.method = sideStats[0].method + "+" + sideStats[1].method;
+
+  OptOrderCfg cfgs[2];
+  double scores[2];
+  for (size_t i = 0; i < 2; i++) {
+    if (!readHierarch(res[i], nds[i], &cfgs[i])) {
+      // may happen if the time budget was used up, the ordering is then
+      // left incomplete
+      LOGTO(WARN, std::cerr) << prefix(depth)
+                             << "No ordering found for a side of the bridge!";
+      stats.gap = -1;
+      return T_STOP(1);
+    }
+    scores[i] = compScore(nds[i], cfgs[i]);
+  }
+
+  // The orderings of both copies of the bridge have to be reconciled. Only
+  // the scores at the two ends of the bridge depend on them, take the
+  // ordering for which their sum is smallest.
+  OptNode* ends[2];
+  uint16_t* perms[2];
+  for (size_t i = 0; i < 2; i++) {
+    ends[i] = bridges[i]->getFrom()->pl().node ? bridges[i]->getFrom()
+                                               : bridges[i]->getTo();
+    perms[i] = cfgs[i].perm(bridges[i]);
+  }
+
+  auto endsScore = [&]() {
+    double ret = 0;
+    for (size_t i = 0; i < 2; i++) {
+      ret += _scorer.getCrossingScore(ends[i], cfgs[i]);
+      if (_scorer.optimizeSep())
+        ret += _scorer.getSeparationScore(ends[i], cfgs[i]);
+    }
+    return ret;
+  };
+
+  double splitEnds = endsScore();
+
+  size_t card = bridge->pl().getCardinality();
+  std::vector<uint16_t> cur(card), best;
+  std::iota(cur.begin(), cur.end(), 0);
+  double bestEnds = std::numeric_limits<double>::infinity();
+
+  do {
+    std::copy(cur.begin(), cur.end(), perms[0]);
+    std::copy(cur.begin(), cur.end(), perms[1]);
+    double sc = endsScore();
+    if (sc < bestEnds) {
+      bestEnds = sc;
+      best = cur;
+    }
+  } while (std::next_permutation(cur.begin(), cur.end()));
+
+  std::copy(best.begin(), best.end(), perms[0]);
+  std::copy(best.begin(), best.end(), perms[1]);
+
+  // the ordering of the bridge is written only once
+  HierarOrderCfg merged;
+  writeHierarch(&cfgs[0], &merged);
+  for (auto& part : bridges[1]->pl().lnEdgParts) part.wasCut = true;
+  writeHierarch(&cfgs[1], &merged);
+
+  // sides which were optimized on their own may disagree on the bridge
+  // ordering in ways the reconciliation above cannot fix, polish the merged
+  // ordering by line swaps
+  OptOrderCfg cfg;
+  if (!readHierarch(merged, g, &cfg)) {
+    LOGTO(WARN, std::cerr) << prefix(depth)
+                           << "Merged ordering of bridge sides is incomplete!";
+    stats.gap = -1;
+    return T_STOP(1);
+  }
+  _hillcOpt.improve(g, &cfg);
+
+  // the optimal score of the component is at least the sum of the optimal
+  // scores of both sides, each with a bridge ordering of its own
+  double score = compScore(g, cfg);
+  if (sideStats[0].gap < 0 || sideStats[1].gap < 0) {
+    stats.gap = -1;
+  } else {
+    double bound = scores[0] * (1 - sideStats[0].gap) +
+                   scores[1] * (1 - sideStats[1].gap);
+    stats.gap = score > 0 ? std::max(0.0, (score - bound) / score) : 0;
+  }
+
+  span.arg("gap", stats.gap);
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(CombOptimizer) Merged sides "
+                          << "of bridge, score " << score << " (reconciled "
+                          << scores[0] + scores[1] - splitEnds + bestEnds
+                          << "), gap " << stats.gap;
+
+  writeHierarch(&cfg, hc);
+
+  return T_STOP(1);
 }
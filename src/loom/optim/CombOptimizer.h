@@ -5,7 +5,10 @@
 #ifndef LOOM_OPTIM_COMBOPTIMIZER_H_
 #define LOOM_OPTIM_COMBOPTIMIZER_H_
 
+#include <set>
+#include <string>
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/BranchBoundOptimizer.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
@@ -18,6 +21,9 @@
 namespace loom {
 namespace optim {
 
+// Picks an optimizer per component, depending on its size. Large components
+// are first split at bridge edges of low cardinality, both sides are then
+// optimized separately.
 class CombOptimizer : public Optimizer {
  public:
   CombOptimizer(const config::Config* cfg,
@@ -28,6 +34,7 @@ class CombOptimizer : public Optimizer {
         _exhausOpt(cfg, pens),
         _hillcOpt(cfg, pens, false),
         _annealOpt(cfg, pens, false),
+        _bnbOpt(cfg, pens),
         _forceILP(false){};
 
   CombOptimizer(const config::Config* cfg,
@@ -38,6 +45,7 @@ class CombOptimizer : public Optimizer {
         _exhausOpt(cfg, pens),
         _hillcOpt(cfg, pens, false),
         _annealOpt(cfg, pens, false),
+        _bnbOpt(cfg, pens),
         _forceILP(forceILP){};
 
   double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
@@ -52,8 +60,22 @@ class CombOptimizer : public Optimizer {
   const ExhaustiveOptimizer _exhausOpt;
   const HillClimbOptimizer _hillcOpt;
   const SimulatedAnnealingOptimizer _annealOpt;
+  const BranchBoundOptimizer _bnbOpt;
 
   const bool _forceILP;
+
+  // a bridge of g with a cardinality of at most maxBridgeCard which splits
+  // the solution space of g most evenly, 0 if there is none. The nodes on
+  // one of its sides are written to side.
+  OptEdge* getBridge(const std::set<OptNode*>& g,
+                     std::set<OptNode*>* side) const;
+
+  // optimize both sides of the bridge separately and reconcile the ordering
+  // of the bridge
+  double optimizeSplit(const std::set<OptNode*>& g, OptEdge* bridge,
+                       const std::set<OptNode*>& side,
+                       shared::rendergraph::HierarOrderCfg* hc, size_t depth,
+                       OptResStats& stats) const;
 };
 }  // namespace optim
 }  // namespace loom
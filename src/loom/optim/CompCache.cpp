@@ -0,0 +1,301 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include "loom/optim/CompCache.h"
+#include "loom/optim/OptGraph.h"
+#include "shared/linegraph/Line.h"
+
+using loom::optim::CompCache;
+using loom::optim::OptEdge;
+using loom::optim::OptGraph;
+using loom::optim::OptNode;
+using shared::linegraph::LineEdge;
+using shared::rendergraph::HierarOrderCfg;
+
+// _____________________________________________________________________________
+static void writeStr(std::ostream& os, const std::string& s) {
+  os << s.size() << ':' << s;
+}
+
+// _____________________________________________________________________________
+static bool readStr(std::istream& is, std::string* s) {
+  size_t n;
+  char c;
+  if (!(is >> n >> c) || c != ':') return false;
+  s->resize(n);
+  if (n) is.read(&(*s)[0], n);
+  return static_cast<bool>(is);
+}
+
+// _____________________________________________________________________________
+bool CompCache::get(const std::set<OptNode*>& g, HierarOrderCfg* hc) const {
+  std::string key;
+  std::vector<OptEdge*> edges;
+  if (!canonical(g, &key, &edges)) return false;
+
+  std::ifstream f(getPath(key));
+  if (!f.good()) return false;
+
+  std::string fileKey;
+
+  // protect against hash collisions
+  if (!readStr(f, &fileKey) || fileKey != key) return false;
+
+  size_t num;
+  if (!(f >> num)) return false;
+
+  HierarOrderCfg ret;
+
+  for (size_t i = 0; i < num; i++) {
+    size_t eid, part, card;
+    if (!(f >> eid >> part >> card)) return false;
+    if (eid >= edges.size() || part >= edges[eid]->pl().lnEdgParts.size())
+      return false;
+
+    const auto& lnEdgPart = edges[eid]->pl().lnEdgParts[part];
+    auto& ord = ret[lnEdgPart.lnEdg][lnEdgPart.order];
+    ord.clear();
+
+    for (size_t j = 0; j < card; j++) {
+      std::string id;
+      if (!readStr(f, &id)) return false;
+
+      bool found = false;
+      for (const auto& lo : lnEdgPart.lnEdg->pl().getLines()) {
+        if (lo.line->id() != id) continue;
+        ord.push_back(lnEdgPart.lnEdg->pl().linePos(lo.line));
+        found = true;
+        break;
+      }
+
+      if (!found) return false;
+    }
+  }
+
+  for (const auto& e : ret) {
+    for (const auto& o : e.second) (*hc)[e.first][o.first] = o.second;
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void CompCache::put(const std::set<OptNode*>& g,
+                    const HierarOrderCfg& hc) const {
+  std::string key;
+  std::vector<OptEdge*> edges;
+  if (!canonical(g, &key, &edges)) return;
+
+  std::stringstream entries;
+  size_t num = 0;
+  std::set<std::pair<const LineEdge*, size_t>> covered;
+
+  for (size_t i = 0; i < edges.size(); i++) {
+    const auto& parts = edges[i]->pl().lnEdgParts;
+    for (size_t j = 0; j < parts.size(); j++) {
+      if (parts[j].wasCut) continue;
+
+      auto e = hc.find(parts[j].lnEdg);
+      if (e == hc.end()) continue;
+      auto o = e->second.find(parts[j].order);
+      if (o == e->second.end()) continue;
+
+      covered.insert({parts[j].lnEdg, parts[j].order});
+
+      entries << i << " " << j << " " << o->second.size();
+      for (size_t p : o->second) {
+        entries << " ";
+        writeStr(entries, parts[j].lnEdg->pl().lineOccAtPos(p).line->id());
+      }
+      entries << "\n";
+      num++;
+    }
+  }
+
+  // the optimizer wrote orderings which we cannot attribute to the
+  // component, don't cache what we could not replay
+  size_t total = 0;
+  for (const auto& e : hc) total += e.second.size();
+  if (total != covered.size()) return;
+
+  // write to a temporary file first, so that concurrent readers never see a
+  // partially written file
+  std::string path = getPath(key);
+  std::stringstream tmp;
+  tmp << path << ".tmp." << std::this_thread::get_id();
+
+  {
+    std::ofstream f(tmp.str());
+    if (!f.good()) return;
+    writeStr(f, key);
+    f << "\n" << num << "\n" << entries.str();
+    if (!f.good()) return;
+  }
+
+  std::rename(tmp.str().c_str(), path.c_str());
+}
+
+// _____________________________________________________________________________
+bool CompCache::canonical(const std::set<OptNode*>& g, std::string* key,
+                          std::vector<OptEdge*>* edges) const {
+  // nodes are identified by their position
+  std::vector<OptNode*> nds(g.begin(), g.end());
+  auto posCmp = [](const OptNode* a, const OptNode* b) {
+    return std::make_pair(a->pl().p.getX(), a->pl().p.getY()) <
+           std::make_pair(b->pl().p.getX(), b->pl().p.getY());
+  };
+  std::sort(nds.begin(), nds.end(), posCmp);
+
+  std::map<const OptNode*, size_t> ndIdx;
+  for (size_t i = 0; i < nds.size(); i++) {
+    if (i > 0 && !posCmp(nds[i - 1], nds[i])) return false;
+    ndIdx[nds[i]] = i;
+  }
+
+  // edges are identified by their end nodes and their lines
+  std::vector<std::tuple<size_t, size_t, std::vector<std::string>, OptEdge*>>
+      sorted;
+  for (auto n : nds) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      std::vector<std::string> ids;
+      for (const auto& lo : e->pl().getLines()) ids.push_back(lo.line->id());
+      std::sort(ids.begin(), ids.end());
+      if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) return false;
+
+      size_t a = ndIdx[e->getFrom()];
+      size_t b = ndIdx[e->getTo()];
+      sorted.push_back(
+          std::make_tuple(std::min(a, b), std::max(a, b), ids, e));
+    }
+  }
+
+  std::sort(sorted.begin(), sorted.end());
+
+  std::map<const OptEdge*, size_t> edgIdx;
+  edges->clear();
+  for (size_t i = 0; i < sorted.size(); i++) {
+    if (i > 0 && std::get<0>(sorted[i - 1]) == std::get<0>(sorted[i]) &&
+        std::get<1>(sorted[i - 1]) == std::get<1>(sorted[i]) &&
+        std::get<2>(sorted[i - 1]) == std::get<2>(sorted[i]))
+      return false;
+    edges->push_back(std::get<3>(sorted[i]));
+    edgIdx[std::get<3>(sorted[i])] = i;
+  }
+
+  std::stringstream ss;
+  ss << std::setprecision(17);
+
+  const auto& pens = _scorer->getPens();
+  ss << "optim " << _optim << "\n";
+  ss << "pens " << pens.inStatCrossPenDegTwo << " "
+     << pens.inStatSplitPenDegTwo << " " << pens.sameSegCrossPen << " "
+     << pens.diffSegCrossPen << " " << pens.splitPen << " "
+     << pens.inStatCrossPenSameSeg << " " << pens.inStatCrossPenDiffSeg << " "
+     << pens.inStatSplitPen << " " << pens.crossAdjPen << " "
+     << pens.splitAdjPen << " " << _scorer->optimizeSep() << "\n";
+
+  for (auto n : nds) {
+    ss << "n " << n->pl().p.getX() << " " << n->pl().p.getY() << " "
+       << n->getDeg();
+    if (n->pl().node) {
+      ss << " " << _scorer->getCrossingPenSameSeg(n) << " "
+         << _scorer->getCrossingPenDiffSeg(n) << " "
+         << _scorer->getSeparationPen(n);
+    }
+    ss << " cw";
+    for (auto e : n->pl().circOrdering) ss << " " << edgIdx[e];
+    ss << "\n";
+  }
+
+  for (size_t i = 0; i < edges->size(); i++) {
+    auto e = (*edges)[i];
+    ss << "e " << ndIdx[e->getFrom()] << " " << ndIdx[e->getTo()];
+
+    std::vector<std::pair<std::string, const OptLO*>> los;
+    for (const auto& lo : e->pl().getLines()) los.push_back({lo.line->id(), &lo});
+    std::sort(los.begin(), los.end());
+
+    for (const auto& lo : los) {
+      ss << " l ";
+      writeStr(ss, lo.first);
+      if (lo.second->dir) {
+        ss << " " << lo.second->dir->pl().getGeom()->getX() << " "
+           << lo.second->dir->pl().getGeom()->getY();
+      } else {
+        ss << " -";
+      }
+      std::vector<std::string> rels;
+      for (auto rel : lo.second->relatives) rels.push_back(rel->id());
+      std::sort(rels.begin(), rels.end());
+
+      ss << " r " << rels.size();
+      for (const auto& rel : rels) {
+        ss << " ";
+        writeStr(ss, rel);
+      }
+    }
+
+    for (const auto& part : e->pl().lnEdgParts) {
+      ss << " p " << part.dir << " " << part.order << " " << part.wasCut;
+    }
+    ss << "\n";
+  }
+
+  // connection exceptions, sorted as the adjacency lists are not canonical
+  std::vector<std::string> excs;
+  for (size_t i = 0; i < nds.size(); i++) {
+    auto n = nds[i];
+    if (!n->pl().node) continue;
+    for (auto ea : n->getAdjList()) {
+      for (auto eb : n->getAdjList()) {
+        if (ea == eb) continue;
+        for (const auto& lo : ea->pl().getLines()) {
+          if (!eb->pl().getLineOcc(lo.line)) continue;
+          if (n->pl().node->pl().connOccurs(lo.line,
+                                            OptGraph::getAdjEdg(ea, n),
+                                            OptGraph::getAdjEdg(eb, n)))
+            continue;
+          std::stringstream exc;
+          exc << "x " << i << " " << edgIdx[ea] << " " << edgIdx[eb] << " ";
+          writeStr(exc, lo.line->id());
+          excs.push_back(exc.str());
+        }
+      }
+    }
+  }
+
+  std::sort(excs.begin(), excs.end());
+  for (const auto& exc : excs) ss << exc << "\n";
+
+  *key = ss.str();
+  return true;
+}
+
+// _____________________________________________________________________________
+std::string CompCache::getPath(const std::string& key) const {
+  std::stringstream ss;
+  ss << _dir << "/" << std::hex << std::setw(16) << std::setfill('0')
+     << hash(key) << ".loomcache";
+  return ss.str();
+}
+
+// _____________________________________________________________________________
+uint64_t CompCache::hash(const std::string& s) {
+  // 64 bit FNV-1a, stable across platforms and runs
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
@@ -0,0 +1,59 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_COMPCACHE_H_
+#define LOOM_OPTIM_COMPCACHE_H_
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// On-disk cache of the optimized line orderings of optimization graph
+// components. A component is described by a canonical string which covers
+// everything the ordering depends on (node positions, adjacency, lines,
+// connection exceptions, penalties and the optimizer used), and the cache
+// file is addressed by a hash of that string.
+//
+// The cached value is the ordering written by the optimizer into the
+// component's HierarOrderCfg shard, with lines given by their IDs. On a hit
+// it is replayed into the shard without solving.
+class CompCache {
+ public:
+  CompCache(const std::string& dir, const std::string& optimName,
+            const OptGraphScorer* scorer)
+      : _dir(dir), _optim(optimName), _scorer(scorer) {}
+
+  // replay the cached ordering for g into hc, false on a cache miss
+  bool get(const std::set<OptNode*>& g,
+           shared::rendergraph::HierarOrderCfg* hc) const;
+
+  // store the ordering for g found in hc
+  void put(const std::set<OptNode*>& g,
+           const shared::rendergraph::HierarOrderCfg& hc) const;
+
+ private:
+  std::string _dir;
+  std::string _optim;
+  const OptGraphScorer* _scorer;
+
+  // write the canonical description of g into key and its edges in canonical
+  // order into edges, false if g has no unique canonical form
+  bool canonical(const std::set<OptNode*>& g, std::string* key,
+                 std::vector<OptEdge*>* edges) const;
+
+  std::string getPath(const std::string& key) const;
+
+  static uint64_t hash(const std::string& s);
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_COMPCACHE_H_
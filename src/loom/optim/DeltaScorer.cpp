@@ -0,0 +1,390 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include "loom/optim/DeltaScorer.h"
+#include "shared/linegraph/Line.h"
+
+using loom::optim::DeltaScorer;
+using loom::optim::OptEdge;
+using loom::optim::OptGraph;
+using loom::optim::OptGraphScorer;
+using loom::optim::OptNode;
+using loom::optim::OptOrderCfg;
+using shared::linegraph::Line;
+
+static const size_t NONE = std::numeric_limits<size_t>::max();
+
+// _____________________________________________________________________________
+DeltaScorer::DeltaScorer(const OptGraphScorer* scorer,
+                         const std::set<OptNode*>& g, OptOrderCfg* cfg)
+    : _scorer(scorer), _cfg(cfg), _optSep(scorer->optimizeSep()) {
+  for (auto n : g) {
+    _ndIdx[n] = _nodes.size();
+    _nodes.push_back(NodeData());
+  }
+
+  for (auto n : g) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      _edgeIdx[e] = _edges.size();
+      _edges.push_back(EdgeData());
+      auto& ed = _edges.back();
+      ed.e = e;
+      ed.frNd = _ndIdx.at(e->getFrom());
+      ed.toNd = _ndIdx.at(e->getTo());
+
+      for (const auto& lo : e->pl().getLines()) ed.lines.push_back(lo.line);
+
+      // edge-local line ids are the occurrence indices used by the ordering
+      const auto* perm = cfg->perm(e);
+      ed.ord.resize(ed.lines.size());
+      ed.pos.resize(ed.lines.size());
+      for (size_t p = 0; p < ed.lines.size(); p++) {
+        ed.ord[p] = perm[p];
+        ed.pos[perm[p]] = p;
+      }
+    }
+  }
+
+  for (auto n : g) {
+    auto& nd = _nodes[_ndIdx.at(n)];
+    nd.deg = n->getDeg();
+    nd.active = n->pl().node != 0;
+    nd.numLines = 0;
+    nd.sameSeg = nd.diffSeg = nd.seps = 0;
+
+    if (!nd.active) continue;
+
+    nd.penSame = scorer->getCrossingPenSameSeg(n);
+    nd.penDiff = scorer->getCrossingPenDiffSeg(n);
+    nd.penSep = scorer->getSeparationPen(n);
+
+    const auto& adj = n->getAdjList();
+
+    std::map<const Line*, size_t> lnIdx;
+    for (size_t a = 0; a < nd.deg; a++) {
+      auto e = adj[a];
+      auto& ed = _edges[_edgeIdx.at(e)];
+      nd.edgs.push_back(_edgeIdx.at(e));
+      nd.rev.push_back((e->getFrom() != n) ^ e->pl().lnEdgParts.front().dir);
+      if (e->getFrom() == n) {
+        ed.frSlot = a;
+      } else {
+        ed.toSlot = a;
+      }
+
+      nd.nodeLn.push_back(std::vector<size_t>(ed.lines.size()));
+      for (size_t i = 0; i < ed.lines.size(); i++) {
+        auto it = lnIdx.find(ed.lines[i]);
+        if (it == lnIdx.end()) {
+          it = lnIdx.insert({ed.lines[i], lnIdx.size()}).first;
+          nd.mult.push_back(e->pl().getLines()[i].relatives.size());
+        }
+        nd.nodeLn[a][i] = it->second;
+      }
+    }
+
+    nd.numLines = lnIdx.size();
+    nd.loc.resize(nd.deg * nd.numLines, NONE);
+    for (size_t a = 0; a < nd.deg; a++) {
+      for (size_t i = 0; i < nd.nodeLn[a].size(); i++) {
+        nd.loc[a * nd.numLines + nd.nodeLn[a][i]] = i;
+      }
+    }
+
+    nd.cont.resize(nd.deg * nd.deg * nd.numLines, 0);
+    nd.rank.resize(nd.deg * nd.deg, nd.deg);
+
+    for (size_t a = 0; a < nd.deg; a++) {
+      auto ea = adj[a];
+      const auto& cw = OptGraph::clockwEdges(ea, n);
+      for (size_t i = 0; i < cw.size(); i++) {
+        size_t b = std::find(adj.begin(), adj.end(), cw[i]) - adj.begin();
+        if (b < nd.deg) nd.rank[a * nd.deg + b] = i;
+      }
+
+      for (size_t b = 0; b < nd.deg; b++) {
+        if (a == b) continue;
+        auto eb = adj[b];
+        for (const auto& lnl : lnIdx) {
+          size_t l = lnl.second;
+          if (nd.loc[a * nd.numLines + l] == NONE) continue;
+          if (nd.loc[b * nd.numLines + l] == NONE) continue;
+
+          const auto* eaLo = ea->pl().getLineOcc(lnl.first);
+          const auto* ebLo = eb->pl().getLineOcc(lnl.first);
+
+          if ((eaLo->dir == 0 || ebLo->dir == 0 ||
+               (eaLo->dir == n->pl().node && ebLo->dir != n->pl().node) ||
+               (eaLo->dir != n->pl().node && ebLo->dir == n->pl().node)) &&
+              (n->pl().node->pl().connOccurs(eaLo->line,
+                                             OptGraph::getAdjEdg(ea, n),
+                                             OptGraph::getAdjEdg(eb, n)))) {
+            nd.cont[(a * nd.deg + b) * nd.numLines + l] = 1;
+          }
+        }
+      }
+    }
+
+    initCounts(&nd);
+  }
+}
+
+// _____________________________________________________________________________
+void DeltaScorer::initCounts(NodeData* nd) {
+  nd->sameSeg = nd->diffSeg = nd->seps = 0;
+  if (!nd->active) return;
+
+  for (size_t a = 0; a < nd->deg; a++) {
+    const auto& lns = nd->nodeLn[a];
+    for (size_t i = 0; i < lns.size(); i++) {
+      for (size_t j = i + 1; j < lns.size(); j++) {
+        size_t u = lns[i], v = lns[j];
+        for (size_t b = 0; b < nd->deg; b++) {
+          if (a == b) continue;
+          nd->sameSeg += crossesSame(*nd, a, b, u, v);
+        }
+        if (nd->deg > 2) nd->diffSeg += crossesDiff(*nd, a, u, v);
+      }
+    }
+
+    for (size_t b = 0; b < nd->deg; b++) {
+      if (a == b) continue;
+      const auto& eb = _edges[nd->edgs[b]];
+      for (size_t p = 1; p < eb.ord.size(); p++) {
+        nd->seps += separates(*nd, a, b, nd->nodeLn[b][eb.ord[p - 1]],
+                              nd->nodeLn[b][eb.ord[p]]);
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+size_t DeltaScorer::q(const NodeData& nd, size_t slot, size_t l) const {
+  const auto& ed = _edges[nd.edgs[slot]];
+  size_t p = ed.pos[nd.loc[slot * nd.numLines + l]];
+  return nd.rev[slot] ? ed.ord.size() - 1 - p : p;
+}
+
+// _____________________________________________________________________________
+bool DeltaScorer::conts(const NodeData& nd, size_t a, size_t b,
+                        size_t l) const {
+  return nd.cont[(a * nd.deg + b) * nd.numLines + l];
+}
+
+// _____________________________________________________________________________
+size_t DeltaScorer::crossesSame(const NodeData& nd, size_t a, size_t b,
+                                size_t u, size_t v) const {
+  if (!conts(nd, a, b, u) || !conts(nd, a, b, v)) return 0;
+
+  // seen from the node, the lines cross if they keep their relative order
+  if ((q(nd, a, u) < q(nd, a, v)) != (q(nd, b, u) < q(nd, b, v))) return 0;
+  return nd.mult[u] * nd.mult[v];
+}
+
+// _____________________________________________________________________________
+size_t DeltaScorer::crossesDiff(const NodeData& nd, size_t a, size_t u,
+                                size_t v) const {
+  // number of times u and v cross when leaving a into different edges
+  size_t ret = 0;
+  bool uv = q(nd, a, u) > q(nd, a, v);
+
+  for (size_t b1 = 0; b1 < nd.deg; b1++) {
+    if (b1 == a) continue;
+    for (size_t b2 = 0; b2 < nd.deg; b2++) {
+      if (b2 == a || b2 == b1) continue;
+      if (nd.rank[a * nd.deg + b1] >= nd.rank[a * nd.deg + b2]) continue;
+      if (uv && conts(nd, a, b1, u) && conts(nd, a, b2, v)) ret++;
+      if (!uv && conts(nd, a, b1, v) && conts(nd, a, b2, u)) ret++;
+    }
+  }
+
+  return ret * nd.mult[u] * nd.mult[v];
+}
+
+// _____________________________________________________________________________
+bool DeltaScorer::separates(const NodeData& nd, size_t a, size_t b, size_t s,
+                            size_t t) const {
+  // s and t are neighbors in b
+  if (!conts(nd, a, b, s) || !conts(nd, a, b, t)) return false;
+  size_t qs = q(nd, a, s);
+  size_t qt = q(nd, a, t);
+  return (qs > qt ? qs - qt : qt - qs) > 1;
+}
+
+// _____________________________________________________________________________
+DeltaScorer::Counts DeltaScorer::localCounts(size_t e, size_t p1, size_t p2,
+                                             size_t ndId, size_t a) const {
+  // all counts at node ndId which may change if the lines at p1 < p2 on edge e
+  // (in slot a) are swapped
+  Counts c{0, 0, 0};
+  const auto& nd = _nodes[ndId];
+  if (!nd.active) return c;
+
+  const auto& ed = _edges[e];
+  size_t x = nd.nodeLn[a][ed.ord[p1]];
+  size_t y = nd.nodeLn[a][ed.ord[p2]];
+
+  // the line pairs whose relative order on e is changed by the swap
+  std::vector<std::pair<size_t, size_t>> pairs{{x, y}};
+  for (size_t p = p1 + 1; p < p2; p++) {
+    size_t z = nd.nodeLn[a][ed.ord[p]];
+    pairs.push_back({x, z});
+    pairs.push_back({z, y});
+  }
+
+  for (const auto& pr : pairs) {
+    for (size_t b = 0; b < nd.deg; b++) {
+      if (b == a) continue;
+      c.sameSeg += crossesSame(nd, a, b, pr.first, pr.second);
+      c.sameSeg += crossesSame(nd, b, a, pr.first, pr.second);
+    }
+    if (nd.deg > 2) c.diffSeg += crossesDiff(nd, a, pr.first, pr.second);
+  }
+
+  // separations in the sequence of e, only the neighborhoods of p1 and p2 change
+  std::vector<size_t> nbs;
+  for (size_t p : {p1, p2}) {
+    if (p > 0) nbs.push_back(p - 1);
+    if (p + 1 < ed.ord.size()) nbs.push_back(p);
+  }
+  std::sort(nbs.begin(), nbs.end());
+  nbs.erase(std::unique(nbs.begin(), nbs.end()), nbs.end());
+
+  for (size_t b = 0; b < nd.deg; b++) {
+    if (b == a) continue;
+    for (size_t p : nbs) {
+      c.seps += separates(nd, b, a, nd.nodeLn[a][ed.ord[p]],
+                          nd.nodeLn[a][ed.ord[p + 1]]);
+    }
+  }
+
+  // separations in the sequences of the other edges, only the neighbors of x
+  // and y are affected
+  for (size_t b = 0; b < nd.deg; b++) {
+    if (b == a) continue;
+    const auto& eb = _edges[nd.edgs[b]];
+    std::vector<size_t> nbsB;
+    for (size_t l : {x, y}) {
+      size_t loc = nd.loc[b * nd.numLines + l];
+      if (loc == NONE) continue;
+      size_t p = eb.pos[loc];
+      if (p > 0) nbsB.push_back(p - 1);
+      if (p + 1 < eb.ord.size()) nbsB.push_back(p);
+    }
+    std::sort(nbsB.begin(), nbsB.end());
+    nbsB.erase(std::unique(nbsB.begin(), nbsB.end()), nbsB.end());
+
+    for (size_t p : nbsB) {
+      c.seps += separates(nd, a, b, nd.nodeLn[b][eb.ord[p]],
+                          nd.nodeLn[b][eb.ord[p + 1]]);
+    }
+  }
+
+  return c;
+}
+
+// _____________________________________________________________________________
+void DeltaScorer::swapPos(size_t e, size_t p1, size_t p2) {
+  auto& ed = _edges[e];
+  std::swap(ed.ord[p1], ed.ord[p2]);
+  ed.pos[ed.ord[p1]] = p1;
+  ed.pos[ed.ord[p2]] = p2;
+}
+
+// _____________________________________________________________________________
+double DeltaScorer::score(const NodeData& nd, const Counts& c) const {
+  if (!nd.active) return 0;
+  double ret = (c.sameSeg / 2) * nd.penSame + c.diffSeg * nd.penDiff;
+  if (_optSep) ret += c.seps * nd.penSep;
+  return ret;
+}
+
+// _____________________________________________________________________________
+double DeltaScorer::nodeDelta(size_t ndId, const Counts& o,
+                              const Counts& n) const {
+  const auto& nd = _nodes[ndId];
+  Counts cur{nd.sameSeg, nd.diffSeg, nd.seps};
+  Counts next{nd.sameSeg - o.sameSeg + n.sameSeg,
+              nd.diffSeg - o.diffSeg + n.diffSeg, nd.seps - o.seps + n.seps};
+  return score(nd, next) - score(nd, cur);
+}
+
+// _____________________________________________________________________________
+void DeltaScorer::apply(size_t ndId, const Counts& o, const Counts& n) {
+  auto& nd = _nodes[ndId];
+  nd.sameSeg += n.sameSeg - o.sameSeg;
+  nd.diffSeg += n.diffSeg - o.diffSeg;
+  nd.seps += n.seps - o.seps;
+}
+
+// _____________________________________________________________________________
+double DeltaScorer::getScore() const {
+  double ret = 0;
+  for (const auto& nd : _nodes) {
+    ret += score(nd, {nd.sameSeg, nd.diffSeg, nd.seps});
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+double DeltaScorer::getScore(const OptNode* n) const {
+  const auto& nd = _nodes[_ndIdx.at(n)];
+  return score(nd, {nd.sameSeg, nd.diffSeg, nd.seps});
+}
+
+// _____________________________________________________________________________
+void DeltaScorer::reload(const OptEdge* e) {
+  auto& ed = _edges[_edgeIdx.at(e)];
+  const auto* perm = _cfg->perm(e);
+  for (size_t p = 0; p < ed.ord.size(); p++) {
+    ed.ord[p] = perm[p];
+    ed.pos[perm[p]] = p;
+  }
+
+  initCounts(&_nodes[ed.frNd]);
+  initCounts(&_nodes[ed.toNd]);
+}
+
+// _____________________________________________________________________________
+double DeltaScorer::getSwapDelta(const OptEdge* e, size_t p1, size_t p2) {
+  if (p1 == p2) return 0;
+  if (p1 > p2) std::swap(p1, p2);
+
+  size_t ei = _edgeIdx.at(e);
+  const auto& ed = _edges[ei];
+
+  Counts frOld = localCounts(ei, p1, p2, ed.frNd, ed.frSlot);
+  Counts toOld = localCounts(ei, p1, p2, ed.toNd, ed.toSlot);
+  swapPos(ei, p1, p2);
+  Counts frNew = localCounts(ei, p1, p2, ed.frNd, ed.frSlot);
+  Counts toNew = localCounts(ei, p1, p2, ed.toNd, ed.toSlot);
+  swapPos(ei, p1, p2);
+
+  return nodeDelta(ed.frNd, frOld, frNew) + nodeDelta(ed.toNd, toOld, toNew);
+}
+
+// _____________________________________________________________________________
+void DeltaScorer::swap(const OptEdge* e, size_t p1, size_t p2) {
+  if (p1 == p2) return;
+  if (p1 > p2) std::swap(p1, p2);
+
+  size_t ei = _edgeIdx.at(e);
+  const auto& ed = _edges[ei];
+
+  Counts frOld = localCounts(ei, p1, p2, ed.frNd, ed.frSlot);
+  Counts toOld = localCounts(ei, p1, p2, ed.toNd, ed.toSlot);
+  swapPos(ei, p1, p2);
+  Counts frNew = localCounts(ei, p1, p2, ed.frNd, ed.frSlot);
+  Counts toNew = localCounts(ei, p1, p2, ed.toNd, ed.toSlot);
+
+  apply(ed.frNd, frOld, frNew);
+  apply(ed.toNd, toOld, toNew);
+
+  auto perm = _cfg->perm(e);
+  std::swap(perm[p1], perm[p2]);
+}
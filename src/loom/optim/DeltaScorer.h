@@ -0,0 +1,134 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_DELTASCORER_H_
+#define LOOM_OPTIM_DELTASCORER_H_
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+
+namespace loom {
+namespace optim {
+
+// Compiled scoring kernel for a single component. The line continuations,
+// clockwise ranks and edge-local line ids of every node are precomputed once
+// into flat tables, and the ordering of every edge is kept together with its
+// position-inverse, so no line occurrence lookups or temporary orderings are
+// needed while scoring.
+//
+// The crossing and separation counts of all nodes are kept cached for the
+// current ordering and are updated incrementally under transpositions of two
+// lines on an edge. Only line pairs whose relative order actually changes are
+// re-examined, so a single move costs O(card * deg) instead of
+// O(card^2 * deg^2) for a full re-scoring of both end nodes. Orderings changed
+// from the outside can be re-read per edge.
+//
+// The resulting scores are identical to the ones of OptGraphScorer.
+class DeltaScorer {
+ public:
+  DeltaScorer(const OptGraphScorer* scorer, const std::set<OptNode*>& g,
+              OptOrderCfg* cfg);
+
+  // total score of the component under the current ordering
+  double getScore() const;
+
+  // score of node n under the current ordering
+  double getScore(const OptNode* n) const;
+
+  // re-read the ordering of e from the underlying ordering after it was
+  // changed from the outside, the counts of both end nodes are recomputed
+  void reload(const OptEdge* e);
+
+  // score change if the lines at positions p1 and p2 on e were swapped
+  double getSwapDelta(const OptEdge* e, size_t p1, size_t p2);
+
+  // swap the lines at positions p1 and p2 on e, also in the underlying
+  // ordering
+  void swap(const OptEdge* e, size_t p1, size_t p2);
+
+ private:
+  struct EdgeData {
+    const OptEdge* e;
+    // edge-local line id -> line
+    std::vector<const shared::linegraph::Line*> lines;
+    // position -> edge-local line id
+    std::vector<size_t> ord;
+    // edge-local line id -> position
+    std::vector<size_t> pos;
+    // node index and slot at the from and to node
+    size_t frNd, frSlot, toNd, toSlot;
+  };
+
+  struct NodeData {
+    size_t deg;
+    size_t numLines;
+    bool active;
+
+    // per slot: the edge index and whether the edge runs reversed as seen
+    // from this node
+    std::vector<size_t> edgs;
+    std::vector<bool> rev;
+
+    // [slot * numLines + node-local line id] -> edge-local line id
+    std::vector<size_t> loc;
+
+    // [(slotA * deg + slotB) * numLines + node-local line id] -> 1 if the line
+    // continues from slotA into slotB
+    std::vector<char> cont;
+
+    // [slotA * deg + slotB] -> clockwise rank of slotB as seen from slotA
+    std::vector<size_t> rank;
+
+    // [slot] -> edge-local line id -> node-local line id
+    std::vector<std::vector<size_t>> nodeLn;
+
+    // node-local line id -> number of lines collapsed into it, crossings are
+    // weighted by the product of the multiplicities of both lines
+    std::vector<size_t> mult;
+
+    double penSame, penDiff, penSep;
+
+    // cached counts, same segment crossings are counted twice
+    long sameSeg, diffSeg, seps;
+  };
+
+  struct Counts {
+    long sameSeg, diffSeg, seps;
+  };
+
+  const OptGraphScorer* _scorer;
+  OptOrderCfg* _cfg;
+  bool _optSep;
+
+  std::vector<EdgeData> _edges;
+  std::vector<NodeData> _nodes;
+  std::unordered_map<const OptEdge*, size_t> _edgeIdx;
+  std::unordered_map<const OptNode*, size_t> _ndIdx;
+
+  size_t q(const NodeData& nd, size_t slot, size_t l) const;
+  bool conts(const NodeData& nd, size_t a, size_t b, size_t l) const;
+
+  size_t crossesSame(const NodeData& nd, size_t a, size_t b, size_t u,
+                     size_t v) const;
+  size_t crossesDiff(const NodeData& nd, size_t a, size_t u, size_t v) const;
+  bool separates(const NodeData& nd, size_t a, size_t b, size_t s,
+                 size_t t) const;
+
+  void initCounts(NodeData* nd);
+
+  Counts localCounts(size_t e, size_t p1, size_t p2, size_t nd,
+                     size_t slot) const;
+  void swapPos(size_t e, size_t p1, size_t p2);
+
+  double score(const NodeData& nd, const Counts& c) const;
+  double nodeDelta(size_t nd, const Counts& o, const Counts& n) const;
+  void apply(size_t nd, const Counts& o, const Counts& n);
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_DELTASCORER_H_
@@ -3,9 +3,18 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+#include "loom/optim/DeltaScorer.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "shared/linegraph/Line.h"
+#include "util/Misc.h"
 #include "util/log/Log.h"
 
 using namespace loom;
@@ -13,6 +22,10 @@ using namespace optim;
 using loom::optim::ExhaustiveOptimizer;
 using shared::linegraph::Line;
 using shared::rendergraph::HierarOrderCfg;
+using util::factorial;
+
+// solution space size from which the search is spread over multiple threads
+const static double MIN_PAR_SOL_SP = 5000;
 
 // _____________________________________________________________________________
 double ExhaustiveOptimizer::optimizeComp(OptGraph* og,
@@ -20,104 +33,207 @@ double ExhaustiveOptimizer::optimizeComp(OptGraph* og,
                                          HierarOrderCfg* hc, size_t depth,
                                          OptResStats& stats) const {
   UNUSED(og);
-  UNUSED(stats);
   LOGTO(DEBUG, std::cerr) << prefix(depth)
                           << "(ExhaustiveOptimizer) Optimizing component with "
                           << g.size() << " nodes.";
 
   T_START(1);
 
-  OptOrderCfg best, cur, null;
-  double bestScore = DBL_MAX;
-
-  // fixed order list of optim graph edges
-  std::vector<OptEdge*> edges;
-
-  for (auto n : g)
-    for (auto e : n->getAdjList())
-      if (n == e->getFrom()) edges.push_back(e);
+  OptOrderCfg init;
 
   // this guarantees that all the orderings are sorted, which we need for
   // std::next_permutation below!
-  initialConfig(g, &null, true);
-  cur = null;
-
-  double iters = 0;
-  double last = 0;
-  bool running = true;
-
-  double curScore = _optScorer.getCrossingScore(g, cur);
-  if (_optScorer.optimizeSep())
-    curScore += _optScorer.getSeparationScore(g, cur);
-
-  bestScore = curScore;
-  best = cur;
+  initialConfig(g, &init, true);
 
   double solSp = solutionSpaceSize(g);
+  size_t numThreads = solSp < MIN_PAR_SOL_SP ? 1 : this->numThreads();
 
-  // don't try if it is pointless, assuming we can make 100.000
-  // iterations per second
-  if ((solSp / 50000) > (60 * 60 * 6)) {
+  // don't try if it is pointless, assuming we can make 50.000
+  // iterations per second and thread
+  if ((solSp / (50000 * numThreads)) > (60 * 60 * 6)) {
     std::stringstream ss;
     ss << "Exhaustive search would take too long (over "
-       << ((solSp / 50000) / (60 * 60))
-       << " hours even assuming we can check 50.000 configurations per second";
+       << ((solSp / (50000 * numThreads)) / (60 * 60))
+       << " hours even assuming we can check 50.000 configurations per second"
+       << " on each of " << numThreads << " threads";
     throw std::runtime_error(ss.str());
   }
 
-  double itTime = 0;
+  // other components may be optimized concurrently, only use the threads
+  // they leave over
+  if (numThreads > 1) numThreads = claimThreads(numThreads - 1) + 1;
 
-  while (true) {
-    T_START(iter);
-    if (bestScore == 0) {
-      LOGTO(DEBUG, std::cerr)
-          << prefix(depth) << "Found optimal score 0 prematurely after "
-          << iters << " iterations!";
-      writeHierarch(&best, hc);
-      return 0;
+  // The orderings are enumerated like an odometer, edge 0 changes fastest.
+  // The orderings of the edges [split, size) form the prefix of a job, each
+  // job enumerates all orderings of the edges [0, split). Jobs are generated
+  // in enumeration order, so the job id also gives the enumeration order.
+  size_t split = init.size();
+  double numJobs = 1;
+  if (numThreads > 1) {
+    while (split > 0 && numJobs < numThreads * 16) {
+      split--;
+      numJobs *= factorial(init.card(split));
     }
+  }
 
-    iters++;
-
-    if (fabs((iters - last) - 10000) < 1) {
-      LOGTO(DEBUG, std::cerr)
-          << prefix(depth) << "@ " << iters << "/" << solSp << " ("
-          << int(((1.0 * iters) / (1.0 * solSp)) * 100) << "%, "
-          << (10000 / (itTime / 1000)) << " its/s)";
-      last = iters;
-      itTime = 0;
+  // nodes whose adjacent edges all belong to the prefix have a constant score
+  // within a job, which gives a lower bound for the job
+  std::vector<OptNode*> fixedNds, freeNds;
+  for (auto n : g) {
+    bool fixed = split < init.size();
+    for (auto e : n->getAdjList()) {
+      if (init.getId(e) < split) fixed = false;
+    }
+    if (fixed) {
+      fixedNds.push_back(n);
+    } else {
+      freeNds.push_back(n);
     }
+  }
+
+  OptOrderCfg jobPrefix = init;
+  size_t nextJob = 0;
+  bool jobsLeft = true;
+
+  OptOrderCfg best;
+  double bestScore = DBL_MAX;
+  size_t bestJob = std::numeric_limits<size_t>::max();
+
+  // the global best score, used as a bound by all threads
+  std::atomic<double> bound(DBL_MAX);
 
-    for (size_t i = 0; i < edges.size(); i++) {
-      if (std::next_permutation(cur[edges[i]].begin(), cur[edges[i]].end())) {
-        break;
-      } else if (i == edges.size() - 1) {
-        running = false;
+  // the first job in which a score of 0 was found, no later job can do better
+  std::atomic<size_t> zeroJob(std::numeric_limits<size_t>::max());
+
+  std::atomic<size_t> iters(0);
+  std::mutex mtx;
+
+  auto worker = [&]() {
+    OptOrderCfg cur = init;
+
+    // node scores are only recomputed for the end nodes of changed edges
+    DeltaScorer delta(&_optScorer, g, &cur);
+
+    while (true) {
+      size_t job;
+
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!jobsLeft || zeroJob != std::numeric_limits<size_t>::max()) return;
+
+        job = nextJob++;
+        for (size_t i = split; i < cur.size(); i++) {
+          std::copy(jobPrefix.perm(i), jobPrefix.perm(i) + jobPrefix.card(i),
+                    cur.perm(i));
+        }
+
+        jobsLeft = false;
+        for (size_t i = split; i < jobPrefix.size(); i++) {
+          if (std::next_permutation(jobPrefix.perm(i),
+                                    jobPrefix.perm(i) + jobPrefix.card(i),
+                                    std::greater<uint16_t>())) {
+            jobsLeft = true;
+            break;
+          }
+        }
       }
-    }
 
-    if (!running) break;
+      for (size_t i = split; i < cur.size(); i++) delta.reload(cur.getEdge(i));
+
+      double fixedScore = 0;
+      for (auto n : fixedNds) fixedScore += delta.getScore(n);
 
-    if (_optScorer.optimizeSep())
-      curScore = _optScorer.getTotalScore(g, cur);
-    else
-      curScore = _optScorer.getCrossingScore(g, cur);
+      // no ordering in this job can be strictly better than the best one
+      if (fixedScore > bound) continue;
 
-    if (curScore < bestScore) {
-      bestScore = curScore;
-      best = cur;
+      double jobBest = DBL_MAX;
+      OptOrderCfg jobBestCfg;
+
+      while (true) {
+        double curScore = fixedScore;
+        double b = std::min<double>(jobBest, bound);
+
+        for (auto n : freeNds) {
+          curScore += delta.getScore(n);
+          // cannot be an improvement anymore
+          if (curScore > b) break;
+        }
+
+        if (curScore < jobBest) {
+          jobBest = curScore;
+          jobBestCfg = cur;
+
+          double glob = bound;
+          while (curScore < glob && !bound.compare_exchange_weak(glob, curScore))
+            ;
+
+          if (jobBest == 0) {
+            size_t z = zeroJob;
+            while (job < z && !zeroJob.compare_exchange_weak(z, job))
+              ;
+          }
+        }
+
+        size_t it = ++iters;
+        if (it % 100000 == 0) {
+          LOGTO(DEBUG, std::cerr)
+              << prefix(depth) << "@ " << it << "/" << solSp << " ("
+              << int(((1.0 * it) / (1.0 * solSp)) * 100) << "%)";
+        }
+
+        // an earlier job already found an optimal ordering
+        if (zeroJob <= job) break;
+
+        bool running = false;
+        for (size_t i = 0; i < split; i++) {
+          // the line occurrences are sorted by descending line, so a sorted
+          // ordering is descending in the occurrence indices
+          // also a wrap-around back to the first ordering changes the edge
+          running = std::next_permutation(
+              cur.perm(i), cur.perm(i) + cur.card(i), std::greater<uint16_t>());
+          delta.reload(cur.getEdge(i));
+          if (running) break;
+        }
+
+        if (!running) break;
+      }
+
+      if (jobBest == DBL_MAX) continue;
+
+      std::lock_guard<std::mutex> lock(mtx);
+      // on ties, prefer the ordering enumerated first
+      if (jobBest < bestScore || (jobBest == bestScore && job < bestJob)) {
+        bestScore = jobBest;
+        bestJob = job;
+        best = jobBestCfg;
+      }
     }
-    itTime += T_STOP(iter);
+  };
+
+  if (numThreads < 2) {
+    worker();
+  } else {
+    std::vector<std::thread> thrds;
+    for (size_t i = 0; i < numThreads; i++) thrds.push_back(std::thread(worker));
+    for (auto& thr : thrds) thr.join();
+    releaseThreads(numThreads - 1);
   }
 
   LOGTO(DEBUG, std::cerr) << prefix(depth) << "Found optimal score "
                           << bestScore << " after " << iters << " iterations!";
 
   writeHierarch(&best, hc);
+  stats.gap = 0;
 
   return T_STOP(1);
 }
 
+// _____________________________________________________________________________
+double ExhaustiveOptimizer::score(OptNode* n, const OptOrderCfg& cfg) const {
+  if (_optScorer.optimizeSep()) return _optScorer.getTotalScore(n, cfg);
+  return _optScorer.getCrossingScore(n, cfg);
+}
+
 // _____________________________________________________________________________
 void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
                                         OptOrderCfg* cfg) const {
@@ -127,52 +243,22 @@ void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
 // _____________________________________________________________________________
 void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
                                         OptOrderCfg* cfg, bool sorted) const {
-  for (OptNode* n : g) {
-    for (OptEdge* e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-      (*cfg)[e] = std::vector<const Line*>(e->pl().getCardinality());
-      size_t p = 0;
-      for (size_t i = 0; i < e->pl().getLines().size(); i++) {
-        (*cfg)[e][p] = e->pl().getLines()[i].line;
-        p++;
-      }
+  *cfg = OptOrderCfg(g);
 
-      if (sorted) {
-        std::sort((*cfg)[e].begin(), (*cfg)[e].end());
-      } else {
-        std::random_shuffle((*cfg)[e].begin(), (*cfg)[e].end());
-      }
-    }
+  // a generator of its own for each call, jobs may run this concurrently
+  std::mt19937 rng;
+  if (!sorted) {
+    std::random_device rd;
+    rng.seed(rd());
   }
-}
-
-// _____________________________________________________________________________
-void ExhaustiveOptimizer::writeHierarch(OptOrderCfg* cfg,
-                                        HierarOrderCfg* hc) const {
-  for (auto ep : *cfg) {
-    auto e = ep.first;
-
-    for (auto lnEdgPart : e->pl().lnEdgParts) {
-      if (lnEdgPart.wasCut) continue;
-      for (auto r : ep.second) {
-        // get the corresponding route occurance in the opt graph edge
-        // TODO: replace this as soon as a lookup function is present in OptLO
-        OptLO optRO;
-        for (auto ro : e->pl().getLines()) {
-          if (r == ro.line) optRO = ro;
-        }
 
-        for (auto rel : optRO.relatives) {
-          // retrieve the original line pos
-          size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
-          if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
-            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].insert(
-                (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].begin(), p);
-          } else {
-            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].push_back(p);
-          }
-        }
-      }
+  for (size_t i = 0; i < cfg->size(); i++) {
+    if (sorted) {
+      // sorted by ascending line
+      std::sort(cfg->perm(i), cfg->perm(i) + cfg->card(i),
+                std::greater<uint16_t>());
+    } else {
+      std::shuffle(cfg->perm(i), cfg->perm(i) + cfg->card(i), rng);
     }
   }
 }
@@ -31,8 +31,7 @@ class ExhaustiveOptimizer : public Optimizer {
   void initialConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg) const;
   void initialConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg,
                      bool sorted) const;
-  void writeHierarch(OptOrderCfg* cfg,
-                     shared::rendergraph::HierarOrderCfg* c) const;
+  double score(OptNode* n, const OptOrderCfg& cfg) const;
 };
 }  // namespace optim
 }  // namespace loom
@@ -37,20 +37,31 @@ double GreedyOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
 // _____________________________________________________________________________
 void GreedyOptimizer::getFlatConfig(const std::set<OptNode*>& g,
                                    OptOrderCfg* cfg) const {
-  const OptEdge* e = 0;
-  SettledEdgs settled;
-
-  while ((e = getNextEdge(g, &settled))) {
-    Cmp left, right;
-
-    // build cmp function for left
-    for (const auto& lo1 : e->pl().getLines()) {
-      for (const auto& lo2 : e->pl().getLines()) {
-        if (lo1.line == lo2.line) continue;
-        left[{lo1.line, lo2.line}] =
-            guess(lo1.line, lo2.line, e, e->getFrom(), *cfg);
-        right[{lo1.line, lo2.line}] =
-            guess(lo1.line, lo2.line, e, e->getTo(), *cfg);
+  *cfg = OptOrderCfg(g);
+
+  SettledEdgs settled(cfg->size(), false);
+  GreedyFrontier frontier;
+  frontier.pos.resize(cfg->size(), 0);
+
+  Cmp left, right;
+
+  const OptEdge* e = getInitialEdge(g);
+
+  while (e) {
+    const auto& lines = e->pl().getLines();
+    size_t card = lines.size();
+
+    left.assign(card * card, {false, 0});
+    right.assign(card * card, {false, 0});
+
+    // build cmp functions for left and right
+    for (size_t i = 0; i < card; i++) {
+      for (size_t j = 0; j < card; j++) {
+        if (i == j) continue;
+        left[i * card + j] = guess(lines[i].line, lines[j].line, e,
+                                   e->getFrom(), *cfg, settled);
+        right[i * card + j] =
+            guess(lines[i].line, lines[j].line, e, e->getTo(), *cfg, settled);
       }
     }
 
@@ -58,50 +69,49 @@ void GreedyOptimizer::getFlatConfig(const std::set<OptNode*>& g,
     double costRight = 0;
 
     // which one is cheaper?
-    for (const auto& lo1 : e->pl().getLines()) {
-      for (const auto& lo2 : e->pl().getLines()) {
-        if (lo1.line == lo2.line) continue;
-        if (left[{lo1.line, lo2.line}].first ==
-            right[{lo1.line, lo2.line}].first) {
-          costLeft += right[{lo1.line, lo2.line}].second;
-          costRight += left[{lo1.line, lo2.line}].second;
-        }
+    for (size_t i = 0; i < card * card; i++) {
+      if (i / card == i % card) continue;
+      if (left[i].first == right[i].first) {
+        costLeft += right[i].second;
+        costRight += left[i].second;
       }
     }
 
-    // build cmp function for right
+    auto perm = cfg->perm(e);
 
-    LineCmp cmp({}, false);
     if (costLeft < costRight) {
-      cmp = LineCmp(left, false);
+      std::sort(perm, perm + card, LineCmp(left, card, false));
     } else {
-      cmp = LineCmp(right, true);
+      std::sort(perm, perm + card, LineCmp(right, card, true));
     }
 
-    // fill lines into empty config
-    for (const auto& lo : e->pl().getLines()) {
-      (*cfg)[e].push_back(lo.line);
-    }
-
-    std::sort((*cfg)[e].begin(), (*cfg)[e].end(), cmp);
+    settled[cfg->getId(e)] = true;
+    frontier.edgs.push(e);
 
-    settled.insert(e);
+    e = getNextEdge(*cfg, settled, &frontier);
   }
 }
 
 // _____________________________________________________________________________
-const OptEdge* GreedyOptimizer::getNextEdge(const std::set<OptNode*>& g,
-                                            SettledEdgs* settled) const {
-  if (settled->size() == 0) return getInitialEdge(g);
-
-  // else, use some unsettled edge adjacent to the settled set
-  for (auto eid : *settled) {
-    for (auto adj : eid->getFrom()->getAdjList()) {
-      if (!settled->count(adj)) return adj;
-    }
-    for (auto adj : eid->getTo()->getAdjList()) {
-      if (!settled->count(adj)) return adj;
+const OptEdge* GreedyOptimizer::getNextEdge(const OptOrderCfg& cfg,
+                                            const SettledEdgs& settled,
+                                            GreedyFrontier* frontier) const {
+  // use the first unsettled edge adjacent to the smallest settled edge which
+  // still has one. Edges are only ever settled, so an edge whose neighbours
+  // have all been scanned once never has to be looked at again.
+  while (!frontier->edgs.empty()) {
+    auto s = frontier->edgs.top();
+    size_t& pos = frontier->pos[cfg.getId(s)];
+
+    const auto& fr = s->getFrom()->getAdjList();
+    const auto& to = s->getTo()->getAdjList();
+
+    for (; pos < fr.size() + to.size(); pos++) {
+      auto adj = pos < fr.size() ? fr[pos] : to[pos - fr.size()];
+      if (!settled[cfg.getId(adj)]) return adj;
     }
+
+    frontier->edgs.pop();
   }
 
   return 0;
@@ -131,13 +141,20 @@ const OptEdge* GreedyOptimizer::getInitialEdge(
 std::pair<int, double> GreedyOptimizer::smallerThanAt(
     const shared::linegraph::Line* a, const shared::linegraph::Line* b,
     const OptEdge* start, const OptNode* nd, const OptEdge* ign,
-    const OptOrderCfg& cfg) const {
+    const OptOrderCfg& cfg, const SettledEdgs& settled) const {
   // return -1 for false, 0 for undecided, 1 for true
   std::vector<size_t> positionsA;
   std::vector<size_t> positionsB;
 
   double cost = 0;
 
+  // number of lines collapsed into a and b on the edge the comparison is
+  // made at
+  auto startLoA = start->pl().getLineOcc(a);
+  auto startLoB = start->pl().getLineOcc(b);
+  size_t multA = startLoA ? startLoA->relatives.size() : 1;
+  size_t multB = startLoB ? startLoB->relatives.size() : 1;
+
   size_t offset = 0;
 
   for (auto e : OptGraph::clockwEdges(start, nd)) {
@@ -146,13 +163,14 @@ std::pair<int, double> GreedyOptimizer::smallerThanAt(
     auto loB = e->pl().getLineOcc(b);
 
     if (loA && loB) {
-      auto eCfg = cfg.find(e);
-      if (eCfg != cfg.end()) {
+      if (settled[cfg.getId(e)]) {
         bool rev = (e->getFrom() != nd) ^ e->pl().lnEdgParts.front().dir;
-        size_t peaA = std::find(eCfg->second.begin(), eCfg->second.end(), a) -
-                      eCfg->second.begin();
-        size_t peaB = std::find(eCfg->second.begin(), eCfg->second.end(), b) -
-                      eCfg->second.begin();
+        const auto* perm = cfg.perm(e);
+        const auto* end = perm + e->pl().getCardinality();
+        size_t peaA =
+            std::find(perm, end, loA - &e->pl().getLines()[0]) - perm;
+        size_t peaB =
+            std::find(perm, end, loB - &e->pl().getLines()[0]) - perm;
         if (rev) {
           positionsA.push_back(offset + peaA);
           positionsB.push_back(offset + peaB);
@@ -175,6 +193,9 @@ std::pair<int, double> GreedyOptimizer::smallerThanAt(
 
   if (positionsA.size() == 0 || positionsB.size() == 0) return {0, 0};
 
+  // each of the lines collapsed into a crosses each of the lines of b
+  cost *= multA * multB;
+
   if (positionsA.back() < positionsB.front()) return {1, cost};
   if (positionsA.front() > positionsB.back()) return {-1, cost};
   return {0, 0};
@@ -185,7 +206,8 @@ std::pair<bool, double> GreedyOptimizer::guess(const shared::linegraph::Line* a,
                                                const shared::linegraph::Line* b,
                                                const OptEdge* start,
                                                const OptNode* refNd,
-                                               const OptOrderCfg& cfg) const {
+                                               const OptOrderCfg& cfg,
+                                               const SettledEdgs& settled) const {
   int dec = 0;
   bool notRef = false;
 
@@ -195,7 +217,7 @@ std::pair<bool, double> GreedyOptimizer::guess(const shared::linegraph::Line* a,
   auto e = start;
   auto curNd = refNd;
   while (true) {
-    auto i = smallerThanAt(a, b, e, curNd, e, cfg);
+    auto i = smallerThanAt(a, b, e, curNd, e, cfg, settled);
     if (i.first != 0) {
       dec = i.first;
       cost = i.second;
@@ -210,7 +232,7 @@ std::pair<bool, double> GreedyOptimizer::guess(const shared::linegraph::Line* a,
     e = start;
     curNd = start->getOtherNd(refNd);
     while (true) {
-      auto i = smallerThanAt(a, b, e, curNd, e, cfg);
+      auto i = smallerThanAt(a, b, e, curNd, e, cfg, settled);
       if (i.first != 0) {
         dec = i.first;
         cost = i.second;
@@ -5,7 +5,9 @@
 #ifndef LOOM_OPTIM_GREEDYOPTIMIZER_H_
 #define LOOM_OPTIM_GREEDYOPTIMIZER_H_
 
-#include <map>
+#include <functional>
+#include <queue>
+#include <vector>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
@@ -18,24 +20,38 @@
 namespace loom {
 namespace optim {
 
-typedef std::set<const OptEdge*> SettledEdgs;
-typedef std::map<
-    std::pair<const shared::linegraph::Line*, const shared::linegraph::Line*>,
-    std::pair<bool, double>>
-    Cmp;
+// settled flags, indexed by the edge ids of the component's OptOrderCfg
+typedef std::vector<char> SettledEdgs;
+
+// pairwise line comparisons on a single edge, a flat matrix indexed by the
+// positions of the lines in the edge's line vector
+typedef std::vector<std::pair<bool, double>> Cmp;
 
 struct LineCmp {
-  LineCmp(const Cmp& cmp, bool rev) : _map(cmp), _rev(rev){};
+  LineCmp(const Cmp& cmp, size_t card, bool rev)
+      : _map(cmp), _card(card), _rev(rev){};
 
-  bool operator()(const shared::linegraph::Line* a,
-                  const shared::linegraph::Line* b) {
-    return _map.find({a, b})->second.first ^ _rev;
+  bool operator()(uint16_t a, uint16_t b) const {
+    if (a == b) return false;
+    return _map[a * _card + b].first ^ _rev;
   }
 
-  Cmp _map;
+  const Cmp& _map;
+  size_t _card;
   bool _rev;
 };
 
+// the settled edges which may still have unsettled neighbours, the edge with
+// the smallest address is expanded first. pos holds, per edge id, how far the
+// edges adjacent to an edge (those at its from node, then those at its to
+// node) have already been scanned.
+struct GreedyFrontier {
+  std::priority_queue<const OptEdge*, std::vector<const OptEdge*>,
+                      std::greater<const OptEdge*>>
+      edgs;
+  std::vector<size_t> pos;
+};
+
 class GreedyOptimizer : public ExhaustiveOptimizer {
  public:
   GreedyOptimizer(const config::Config* cfg,
@@ -49,22 +65,29 @@ class GreedyOptimizer : public ExhaustiveOptimizer {
   void getFlatConfig(const std::set<OptNode*>& g,
                      OptOrderCfg* cfg) const;
 
+  virtual std::string getName() const {
+    return _lookAhead ? "greedy-lookahead" : "greedy";
+  }
+
  private:
   bool _lookAhead;
 
-  const OptEdge* getNextEdge(const std::set<OptNode*>& g,
-                             SettledEdgs* settled) const;
+  const OptEdge* getNextEdge(const OptOrderCfg& cfg,
+                             const SettledEdgs& settled,
+                             GreedyFrontier* frontier) const;
   const OptEdge* getInitialEdge(const std::set<OptNode*>& g) const;
 
   std::pair<bool, double> guess(const shared::linegraph::Line* a,
                                 const shared::linegraph::Line* b,
                                 const OptEdge* start, const OptNode* refNd,
-                                const OptOrderCfg& cfg) const;
+                                const OptOrderCfg& cfg,
+                                const SettledEdgs& settled) const;
   std::pair<int, double> smallerThanAt(const shared::linegraph::Line* a,
                                        const shared::linegraph::Line* b,
                                        const OptEdge* e, const OptNode* nd,
                                        const OptEdge* ignore,
-                                       const OptOrderCfg& cfg) const;
+                                       const OptOrderCfg& cfg,
+                                       const SettledEdgs& settled) const;
 
   const OptEdge* eligibleNextEdge(const OptEdge* start, const OptNode* nd,
                                   const shared::linegraph::Line* a,
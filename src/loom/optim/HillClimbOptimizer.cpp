@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <unordered_map>
+#include "loom/optim/DeltaScorer.h"
 #include "loom/optim/GreedyOptimizer.h"
 #include "loom/optim/HillClimbOptimizer.h"
 #include "shared/linegraph/Line.h"
@@ -19,70 +20,69 @@ using shared::rendergraph::HierarOrderCfg;
 double HillClimbOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                                      HierarOrderCfg* hc, size_t depth,
                                      OptResStats& stats) const {
+  UNUSED(og);
   UNUSED(stats);
   UNUSED(depth);
   T_START(1);
   OptOrderCfg cur;
 
-  // fixed order list of optim graph edges
-  std::vector<OptEdge*> edges;
+  climb(g, &cur);
 
-  for (auto n : g)
-    for (auto e : n->getAdjList())
-      if (n == e->getFrom() && e->pl().getCardinality() > 1) edges.push_back(e);
+  writeHierarch(&cur, hc);
+  return T_STOP(1);
+}
 
+// _____________________________________________________________________________
+void HillClimbOptimizer::climb(const std::set<OptNode*>& g,
+                               OptOrderCfg* cur) const {
   if (_randomStart) {
     // this is the starting ordering, which is random
-    initialConfig(g, &cur, false);
+    initialConfig(g, cur, false);
   } else {
     // take the greedy optimized ordering as a starting point
     GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
-    greedy.getFlatConfig(g, &cur);
+    greedy.getFlatConfig(g, cur);
   }
 
+  improve(g, cur);
+}
+
+// _____________________________________________________________________________
+void HillClimbOptimizer::improve(const std::set<OptNode*>& g,
+                                 OptOrderCfg* cur) const {
+  // fixed order list of optim graph edges
+  std::vector<OptEdge*> edges;
+
+  for (auto n : g)
+    for (auto e : n->getAdjList())
+      if (n == e->getFrom() && e->pl().getCardinality() > 1) edges.push_back(e);
+
+  DeltaScorer delta(&_optScorer, g, cur);
+
   while (true) {
     double bestChange = 0;
     OptEdge* bestEdge = 0;
-    std::vector<const Line*> bestOrder;
+    size_t bestP1 = 0, bestP2 = 0;
 
     for (size_t i = 0; i < edges.size(); i++) {
-      double oldScore = getScore(og, edges[i], cur);
-
-      for (size_t p1 = 0; p1 < cur[edges[i]].size(); p1++) {
-        for (size_t p2 = p1; p2 < cur[edges[i]].size(); p2++) {
-          // switch p1 and p2
-          auto tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
-
-          double s = getScore(og, edges[i], cur);
-          if (s < oldScore && oldScore - s > bestChange) {
-            bestChange = oldScore - s;
+      size_t card = edges[i]->pl().getCardinality();
+      for (size_t p1 = 0; p1 < card; p1++) {
+        for (size_t p2 = p1 + 1; p2 < card; p2++) {
+          // score change if p1 and p2 were switched
+          double d = delta.getSwapDelta(edges[i], p1, p2);
+          if (-d > bestChange) {
+            bestChange = -d;
             bestEdge = edges[i];
-            bestOrder = cur[edges[i]];
+            bestP1 = p1;
+            bestP2 = p2;
           }
-
-          // switch back
-          tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
         }
       }
     }
 
-    if (bestEdge == 0) break;
+    // when racing, keep the local improvements found so far
+    if (bestEdge == 0 || raceOver()) break;
 
-    cur[bestEdge] = bestOrder;
+    delta.swap(bestEdge, bestP1, bestP2);
   }
-
-  writeHierarch(&cur, hc);
-  return T_STOP(1);
-}
-
-// _____________________________________________________________________________
-double HillClimbOptimizer::getScore(OptGraph* og, OptEdge* e,
-                                    OptOrderCfg& cur) const {
-  UNUSED(og);
-  if (_optScorer.optimizeSep()) return _optScorer.getTotalScore(e, cur);
-  return _optScorer.getCrossingScore(e, cur);
 }
@@ -27,9 +27,18 @@ class HillClimbOptimizer : public ExhaustiveOptimizer {
                            shared::rendergraph::HierarOrderCfg* c, size_t depth,
                            OptResStats& stats) const;
 
- protected:
-  double getScore(OptGraph* og, OptEdge* e, OptOrderCfg& cur) const;
+  // write a local optimum for g, reached by line swaps, into cur
+  void climb(const std::set<OptNode*>& g, OptOrderCfg* cur) const;
+
+  // improve the ordering cur of g by line swaps until a local optimum is
+  // reached
+  void improve(const std::set<OptNode*>& g, OptOrderCfg* cur) const;
 
+  virtual std::string getName() const {
+    return _randomStart ? "hillc-random" : "hillc";
+  }
+
+ protected:
   bool _randomStart;
 };
 }  // namespace optim
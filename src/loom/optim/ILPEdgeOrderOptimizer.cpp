@@ -2,6 +2,8 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
 #include "loom/optim/OptGraph.h"
@@ -12,38 +14,39 @@
 
 using namespace loom;
 using namespace optim;
+using shared::linegraph::Line;
+using shared::optim::ColBatch;
 using shared::optim::ILPSolver;
+using shared::optim::RowBatch;
+using shared::optim::StarterSol;
 using shared::rendergraph::HierarOrderCfg;
 
 // _____________________________________________________________________________
 void ILPEdgeOrderOptimizer::getConfigurationFromSolution(
     ILPSolver* lp, HierarOrderCfg* hc, const std::set<OptNode*>& g) const {
+  std::vector<double> vals;
+  lp->getVarVals(&vals);
+
+  auto posVars = getPosVarIds(g);
+
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
+      size_t card = e->pl().getCardinality();
 
       for (auto lnEdgPart : e->pl().lnEdgParts) {
         if (lnEdgPart.wasCut) continue;
-        for (size_t tp = 0; tp < e->pl().getCardinality(); tp++) {
+        for (size_t tp = 0; tp < card; tp++) {
           bool found = false;
 
-          for (auto ro : e->pl().getLines()) {
+          for (size_t i = 0; i < card; i++) {
+            const auto& ro = e->pl().getLines()[i];
+            int first = posVars[e] + i * card;
+
             // check if this route (r) switches from 0 to 1 at tp-1 and tp
             double valPrev = 0;
-            std::stringstream varName;
-
-            if (tp > 0) {
-              varName << "x_(" << e->pl().getStrRepr() << ",l=" << ro.line
-                      << ",p<=" << tp - 1 << ")";
-
-              valPrev = lp->getVarVal(varName.str());
-            }
-
-            varName.str("");
-            varName << "x_(" << e->pl().getStrRepr() << ",l=" << ro.line
-                    << ",p<=" << tp << ")";
-
-            double val = lp->getVarVal(varName.str());
+            if (tp > 0) valPrev = vals[first + tp - 1];
+            double val = vals[first + tp];
 
             if (valPrev < 0.5 && val > 0.5) {
               // first time p is eq/greater, so it is this p
@@ -76,146 +79,279 @@ void ILPEdgeOrderOptimizer::getConfigurationFromSolution(
 }
 
 // _____________________________________________________________________________
-ILPSolver* ILPEdgeOrderOptimizer::createProblem(
-    OptGraph* og, const std::set<OptNode*>& g) const {
+void ILPEdgeOrderOptimizer::getStarter(const std::set<OptNode*>& g,
+                                       const OptOrderCfg& cfg,
+                                       StarterSol* start) const {
+  auto posVars = getPosVarIds(g);
+  EdgeVarIds ordVars, distVars;
+  getOrderVarIds(g, &ordVars, &distVars);
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      size_t card = e->pl().getCardinality();
+
+      std::map<const Line*, int> pos;
+      for (size_t p = 0; p < card; p++) pos[cfg.lineAt(e, p)] = p;
+
+      for (size_t i = 0; i < card; i++) {
+        const Line* l = e->pl().getLines()[i].line;
+        for (size_t p = 0; p < card; p++) {
+          (*start)[posVars[e] + i * card + p] =
+              pos[l] <= static_cast<int>(p);
+        }
+      }
+
+      // note that x_(e,A<B) is 1 if A comes _after_ B, see writeCrossingOracle
+      for (LinePair linepair : getLinePairs(e)) {
+        (*start)[getOrderVarId(ordVars, e, linepair.first.line,
+                               linepair.second.line)] =
+            pos[linepair.first.line] > pos[linepair.second.line];
+      }
+
+      if (!separationOpt() || card < 3) continue;
+
+      for (LinePair linepair : getLinePairs(e, true)) {
+        (*start)[getDistVarId(distVars, e, linepair.first.line,
+                              linepair.second.line)] =
+            std::abs(pos[linepair.first.line] - pos[linepair.second.line]) > 1;
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::getOrderVarIds(const std::set<OptNode*>& g,
+                                           EdgeVarIds* ordVars,
+                                           EdgeVarIds* distVars) const {
+  // the order variables follow the position variables, for each edge first
+  // the order variables, then the distance variables
+  int id = 0;
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      id += e->pl().getCardinality() * e->pl().getCardinality();
+    }
+  }
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      int c = e->pl().getCardinality();
+      (*ordVars)[e] = id;
+      id += c * (c - 1);
+
+      if (separationOpt() && c > 2) {
+        (*distVars)[e] = id;
+        id += c * (c - 1) / 2;
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+int ILPEdgeOrderOptimizer::getOrderVarId(const EdgeVarIds& ordVars,
+                                         const OptEdge* e, const Line* a,
+                                         const Line* b) {
+  size_t c = e->pl().getCardinality();
+  size_t ia = getLineIdx(e, a);
+  size_t ib = getLineIdx(e, b);
+  return ordVars.find(e)->second + ia * (c - 1) + (ib < ia ? ib : ib - 1);
+}
+
+// _____________________________________________________________________________
+int ILPEdgeOrderOptimizer::getDistVarId(const EdgeVarIds& distVars,
+                                        const OptEdge* e, const Line* a,
+                                        const Line* b) {
+  size_t c = e->pl().getCardinality();
+  size_t i = std::min(getLineIdx(e, a), getLineIdx(e, b));
+  size_t j = std::max(getLineIdx(e, a), getLineIdx(e, b));
+  return distVars.find(e)->second + i * c - i * (i + 1) / 2 + (j - i - 1);
+}
+
+// _____________________________________________________________________________
+ILPSolver* ILPEdgeOrderOptimizer::createProblem(OptGraph* og,
+                                                const std::set<OptNode*>& g,
+                                                StarterSol* start,
+                                                RowBatch* lazy) const {
   UNUSED(og);
   ILPSolver* lp = shared::optim::getSolver(_cfg->ilpSolver, shared::optim::MIN);
 
-  std::set<OptEdge*> processed;
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
 
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
+      size_t card = e->pl().getCardinality();
+
+      int first = cols.getFirstId() + cols.size();
+
+      for (auto r : e->pl().getLines()) {
+        for (size_t p = 0; p < card; p++) {
+          int curCol = cols.add(shared::optim::BIN, 0);
+          if (ilpNames()) {
+            std::stringstream varName;
+            varName << "x_(" << e->pl().getStrRepr() << ",l=" << r.line
+                    << ",p<=" << p << ")";
+            cols.setName(curCol, varName.str());
+          }
+        }
+      }
+
       // constraint: the sum of all x_sl<=p over the set of lines
       // must be p+1
+      for (size_t p = 0; p < card; p++) {
+        int row = rows.add(p + 1, shared::optim::FIX);
+        for (size_t i = 0; i < card; i++) rows.addCoef(first + i * card + p, 1);
 
-      size_t rowA = lp->getNumConstrs();
-      for (size_t p = 0; p < e->pl().getCardinality(); p++) {
-        std::stringstream rowName;
-        rowName << "sum(" << e->pl().getStrRepr() << ",<=" << p << ")";
-        lp->addRow(rowName.str(), p + 1, shared::optim::FIX);
+        if (ilpNames()) {
+          std::stringstream rowName;
+          rowName << "sum(" << e->pl().getStrRepr() << ",<=" << p << ")";
+          rows.setName(row, rowName.str());
+        }
       }
 
-      for (auto r : e->pl().getLines()) {
-        for (size_t p = 0; p < e->pl().getCardinality(); p++) {
-          std::stringstream varName;
-          varName << "x_(" << e->pl().getStrRepr() << ",l=" << r.line
-                  << ",p<=" << p << ")";
-          int curCol = lp->addCol(varName.str(), shared::optim::BIN, 0);
+      for (size_t i = 0; i < card; i++) {
+        for (size_t p = 1; p < card; p++) {
+          int curCol = first + i * card + p;
+          int row = rows.add(0, shared::optim::LO);
 
-          // coefficients for constraint from above
-          lp->addColToRow(rowA + p, curCol, 1);
+          rows.addCoef(curCol, 1);
+          rows.addCoef(curCol - 1, -1);
 
-          if (p > 0) {
+          if (ilpNames()) {
             std::stringstream rowName;
-            rowName << "sum(" << e->pl().getStrRepr() << ",r=" << r.line
-                    << ",p<=" << p << ")";
-
-            int row = lp->addRow(rowName.str(), 0, shared::optim::LO);
-
-            lp->addColToRow(row, curCol, 1);
-            lp->addColToRow(row, curCol - 1, -1);
+            rowName << "sum(" << e->pl().getStrRepr()
+                    << ",r=" << e->pl().getLines()[i].line << ",p<=" << p
+                    << ")";
+            rows.setName(row, rowName.str());
           }
         }
       }
     }
   }
 
+  lp->addCols(cols);
+  lp->addRows(rows);
   lp->update();
 
-  writeCrossingOracle(g, lp);
-  writeDiffSegConstraintsImpr(g, lp);
+  writeCrossingOracle(g, lp, start, lazy);
+  writeDiffSegConstraintsImpr(g, lp, start, lazy);
+
+  lp->update();
 
   return lp;
 }
 
 // _____________________________________________________________________________
 void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
-                                                ILPSolver* lp) const {
+                                                ILPSolver* lp,
+                                                StarterSol* start,
+                                                RowBatch* lazy) const {
   // do everything iteratively, otherwise it would be unreadable
 
+  auto posVars = getPosVarIds(g);
+  EdgeVarIds ordVars, distVars;
+  getOrderVarIds(g, &ordVars, &distVars);
+
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+
   size_t m = 0;
 
   // introduce crossing constraint variables
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
-      if (segment->pl().getCardinality() > m) {
-        m = segment->pl().getCardinality();
-      }
-
-      size_t rowDistanceRangeKeeper = 0;
       size_t c = segment->pl().getCardinality();
-      // constraint is only needed for segments with more than 2 lines
-      if (separationOpt() && c > 2) {
-        std::stringstream rowName;
-        rowName << "sum_distancorRangeKeeper(e=" << segment->pl().getStrRepr()
-                << ")";
+      if (c > m) m = c;
 
-        size_t max = getLinePairs(segment).size() - (2 * c - 2);
-        assert(max % 2 == 0);
-        max = max / 2;
+      const auto& lines = segment->pl().getLines();
 
-        rowDistanceRangeKeeper =
-            lp->addRow(rowName.str(), max, shared::optim::UP);
+      // variable to check if position of line A is < than position of
+      // line B in segment, in the order given by getOrderVarId()
+      for (size_t ia = 0; ia < c; ia++) {
+        for (size_t ib = 0; ib < c; ib++) {
+          if (ia == ib) continue;
+          int col = cols.add(shared::optim::BIN, 0);
+          assert(col == getOrderVarId(ordVars, segment, lines[ia].line,
+                                      lines[ib].line));
+
+          if (ilpNames()) {
+            std::stringstream ss;
+            ss << "x_(" << segment->pl().getStrRepr() << "," << lines[ia].line
+               << "<" << lines[ib].line << ")";
+            cols.setName(col, ss.str());
+          }
+        }
       }
 
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segment)) {
-        // variable to check if position of line A (first) is < than
-        // position of line B (second) in segment
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
+      // constraint is only needed for segments with more than 2 lines
+      if (!separationOpt() || c < 3) continue;
+
+      // variable to check if distance between position of A and position
+      // of B is > 1, in the order given by getDistVarId()
+      for (size_t i = 0; i < c; i++) {
+        for (size_t j = i + 1; j < c; j++) {
+          int col = cols.add(shared::optim::BIN, 0);
+          assert(col ==
+                 getDistVarId(distVars, segment, lines[i].line, lines[j].line));
+
+          if (ilpNames()) {
+            const Line* a = std::min(lines[i].line, lines[j].line);
+            const Line* b = std::max(lines[i].line, lines[j].line);
+            std::stringstream ss;
+            ss << "x_(" << segment->pl().getStrRepr() << "," << a << "<T>"
+               << b << ")";
+            cols.setName(col, ss.str());
+          }
+        }
+      }
+
+      size_t max = getLinePairs(segment).size() - (2 * c - 2);
+      assert(max % 2 == 0);
+      max = max / 2;
 
-        lp->addCol(ss.str(), shared::optim::BIN, 0);
+      int rowDistanceRangeKeeper = rows.add(max, shared::optim::UP);
+      for (size_t i = 0; i < c * (c - 1) / 2; i++) {
+        rows.addCoef(distVars[segment] + i, 1);
       }
 
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segment, true)) {
-        if (separationOpt() && c > 2) {
-          std::stringstream ss;
-          // variable to check if distance between position of A and position
-          // of B is > 1
-          ss << "x_(" << segment->pl().getStrRepr() << ","
-             << linepair.first.line << "<T>" << linepair.second.line << ")";
-
-          size_t dist1Var = lp->addCol(ss.str(), shared::optim::BIN, 0);
-          lp->addColToRow(rowDistanceRangeKeeper, dist1Var, 1);
-        }
+      if (ilpNames()) {
+        std::stringstream rowName;
+        rowName << "sum_distancorRangeKeeper(e=" << segment->pl().getStrRepr()
+                << ")";
+        rows.setName(rowDistanceRangeKeeper, rowName.str());
       }
     }
   }
 
-  lp->update();
-
   // write constraints for the A>B variable, both can never be 1...
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
       // iterate over all possible line pairs in this segment
       for (LinePair linepair : getLinePairs(segment)) {
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
-
-        int smaller = lp->getVarByName(ss.str());
-        assert(smaller > -1);
-
-        std::stringstream ss2;
-        ss2 << "x_(" << segment->pl().getStrRepr() << ","
-            << linepair.second.line << "<" << linepair.first.line << ")";
-
-        int bigger = lp->getVarByName(ss2.str());
-        assert(bigger > -1);
+        int smaller = getOrderVarId(ordVars, segment, linepair.first.line,
+                                    linepair.second.line);
+        int bigger = getOrderVarId(ordVars, segment, linepair.second.line,
+                                   linepair.first.line);
 
-        std::stringstream rowName;
-        rowName << "sum(" << ss.str() << "," << ss2.str() << ")";
+        int row = rows.add(1, shared::optim::FIX);
 
-        int row = lp->addRow(rowName.str(), 1, shared::optim::FIX);
+        rows.addCoef(smaller, 1);
+        rows.addCoef(bigger, 1);
 
-        lp->addColToRow(row, smaller, 1);
-        lp->addColToRow(row, bigger, 1);
+        if (ilpNames()) {
+          std::stringstream rowName;
+          rowName << "sum(x_(" << segment->pl().getStrRepr() << ","
+                  << linepair.first.line << "<" << linepair.second.line
+                  << "),x_(" << segment->pl().getStrRepr() << ","
+                  << linepair.second.line << "<" << linepair.first.line
+                  << "))";
+          rows.setName(row, rowName.str());
+        }
       }
     }
   }
@@ -224,39 +360,31 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
+      size_t card = segment->pl().getCardinality();
       for (LinePair linepair : getLinePairs(segment)) {
-        std::stringstream rowName;
-        rowName << "sum_crossor(e=" << segment->pl().getStrRepr()
-                << ",A=" << linepair.first.line << ",B=" << linepair.second.line
-                << ")";
-        int rowSmallerThan = lp->addRow(rowName.str(), 0, shared::optim::LO);
+        int rowSmallerThan = rows.add(0, shared::optim::LO);
 
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
+        int decVar = getOrderVarId(ordVars, segment, linepair.first.line,
+                                   linepair.second.line);
 
-        int decVar = lp->getVarByName(ss.str());
-        assert(decVar > -1);
+        rows.addCoef(decVar, m);
 
-        lp->addColToRow(rowSmallerThan, decVar, m);
+        int first = posVars[segment] +
+                    getLineIdx(segment, linepair.first.line) * card;
+        int second = posVars[segment] +
+                     getLineIdx(segment, linepair.second.line) * card;
 
-        for (size_t p = 0; p < segment->pl().getCardinality(); ++p) {
-          std::stringstream ss;
-          ss << "x_(" << segment->pl().getStrRepr()
-             << ",l=" << linepair.first.line << ",p<=" << p << ")";
-
-          int first = lp->getVarByName(ss.str());
-          assert(first > -1);
-
-          std::stringstream ss2;
-          ss2 << "x_(" << segment->pl().getStrRepr()
-              << ",l=" << linepair.second.line << ",p<=" << p << ")";
-
-          int second = lp->getVarByName(ss2.str());
-          assert(second > -1);
+        for (size_t p = 0; p < card; ++p) {
+          rows.addCoef(first + p, 1);
+          rows.addCoef(second + p, -1);
+        }
 
-          lp->addColToRow(rowSmallerThan, first, 1);
-          lp->addColToRow(rowSmallerThan, second, -1);
+        if (ilpNames()) {
+          std::stringstream rowName;
+          rowName << "sum_crossor(e=" << segment->pl().getStrRepr()
+                  << ",A=" << linepair.first.line
+                  << ",B=" << linepair.second.line << ")";
+          rows.setName(rowSmallerThan, rowName.str());
         }
       }
     }
@@ -266,63 +394,54 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
+      size_t card = segment->pl().getCardinality();
+      if (!separationOpt() || card < 3) continue;
+
       for (LinePair linepair : getLinePairs(segment, true)) {
-        std::stringstream rowName;
+        int decVarDistance = getDistVarId(distVars, segment,
+                                          linepair.first.line,
+                                          linepair.second.line);
+
+        int first = posVars[segment] +
+                    getLineIdx(segment, linepair.first.line) * card;
+        int second = posVars[segment] +
+                     getLineIdx(segment, linepair.second.line) * card;
+
+        int rowDistance1 = rows.add(1, shared::optim::UP);
+        rows.addCoef(decVarDistance, -static_cast<int>(m));
+        for (size_t p = 0; p < card; ++p) {
+          rows.addCoef(first + p, 1);
+          rows.addCoef(second + p, -1);
+        }
 
-        int rowDistance1 = 0;
-        int rowDistance2 = 0;
-        if (separationOpt() && segment->pl().getCardinality() > 2) {
-          rowName.str("");
+        int rowDistance2 = rows.add(1, shared::optim::UP);
+        rows.addCoef(decVarDistance, -static_cast<int>(m));
+        for (size_t p = 0; p < card; ++p) {
+          rows.addCoef(first + p, -1);
+          rows.addCoef(second + p, 1);
+        }
+
+        if (ilpNames()) {
+          std::stringstream rowName;
           rowName << "sum_distancor1(e=" << segment->pl().getStrRepr()
                   << ",A=" << linepair.first.line
                   << ",B=" << linepair.second.line << ")";
-
-          rowDistance1 = lp->addRow(rowName.str(), 1, shared::optim::UP);
+          rows.setName(rowDistance1, rowName.str());
 
           rowName.str("");
           rowName << "sum_distancor2(e=" << segment->pl().getStrRepr()
                   << ",A=" << linepair.first.line
                   << ",B=" << linepair.second.line << ")";
-
-          rowDistance2 = lp->addRow(rowName.str(), 1, shared::optim::UP);
-
-          std::stringstream sss;
-          sss << "x_(" << segment->pl().getStrRepr() << ","
-              << linepair.first.line << "<T>" << linepair.second.line << ")";
-
-          int decVarDistance = lp->getVarByName(sss.str());
-          assert(decVarDistance > -1);
-
-          lp->addColToRow(rowDistance1, decVarDistance, -static_cast<int>(m));
-          lp->addColToRow(rowDistance2, decVarDistance, -static_cast<int>(m));
-
-          for (size_t p = 0; p < segment->pl().getCardinality(); ++p) {
-            std::stringstream ss;
-            ss << "x_(" << segment->pl().getStrRepr()
-               << ",l=" << linepair.first.line << ",p<=" << p << ")";
-
-            int first = lp->getVarByName(ss.str());
-            assert(first > -1);
-
-            std::stringstream ss2;
-            ss2 << "x_(" << segment->pl().getStrRepr()
-                << ",l=" << linepair.second.line << ",p<=" << p << ")";
-
-            int second = lp->getVarByName(ss2.str());
-            assert(second > -1);
-
-            lp->addColToRow(rowDistance1, first, 1);
-            lp->addColToRow(rowDistance1, second, -1);
-
-            lp->addColToRow(rowDistance2, first, -1);
-            lp->addColToRow(rowDistance2, second, 1);
-          }
+          rows.setName(rowDistance2, rowName.str());
         }
       }
     }
   }
 
-  // crossing constraints
+  // crossing constraints, they only make sure that crossings are paid for,
+  // so they may be added lazily
+  RowBatch& decRows = lazy ? *lazy : rows;
+
   for (OptNode* node : g) {
     std::set<OptEdge*> processed;
     for (OptEdge* segmentA : node->getAdjList()) {
@@ -338,60 +457,29 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
           if (processed.find(segmentB) != processed.end()) continue;
 
           // introduce dec var
-          std::stringstream ss;
-          ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
-             << segmentA->pl().getStrRepr() << segmentB->pl().getStrRepr()
-             << "," << linepair.first.line << "(" << linepair.first.line->id()
-             << ")," << linepair.second.line << "("
-             << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
+          int decisionVar = cols.add(
+              shared::optim::BIN,
               getCrossingPenaltySameSeg(node)
                   // multiply the penalty with the number of collapsed lines!
                   * (linepair.first.relatives.size()) *
                   (linepair.second.relatives.size()));
 
-          int aSmallerBinL1 = 0;
-          int aSmallerBinL2 = 0;
-          int bSmallerAinL2 = 0;
-
-          std::stringstream aSmBStr;
-          aSmBStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                  << linepair.first.line << "<" << linepair.second.line << ")";
-          aSmallerBinL1 = lp->getVarByName(aSmBStr.str());
-
-          assert(aSmallerBinL1 > -1);
-
-          std::stringstream aBgBStr;
-          aBgBStr << "x_(" << segmentB->pl().getStrRepr() << ","
-                  << linepair.first.line << "<" << linepair.second.line << ")";
-          aSmallerBinL2 = lp->getVarByName(aBgBStr.str());
-
-          assert(aSmallerBinL2 > -1);
-
-          std::stringstream bBgAStr;
-          bBgAStr << "x_(" << segmentB->pl().getStrRepr() << ","
-                  << linepair.second.line << "<" << linepair.first.line << ")";
-          bSmallerAinL2 = lp->getVarByName(bBgAStr.str());
-
-          assert(bSmallerAinL2 > -1);
-
-          std::stringstream rowName;
-          rowName << "sum_dec(e1=" << segmentA->pl().getStrRepr()
-                  << ",e2=" << segmentB->pl().getStrRepr()
-                  << ",A=" << linepair.first.line
-                  << ",B=" << linepair.second.line << ",n=" << node << ")";
-
-          int row = lp->addRow(rowName.str(), 0, shared::optim::LO);
-
-          std::stringstream rowName2;
-          rowName2 << "sum_dec2(e1=" << segmentA->pl().getStrRepr()
-                   << ",e2=" << segmentB->pl().getStrRepr()
-                   << ",A=" << linepair.first.line
-                   << ",B=" << linepair.second.line << ",n=" << node << ")";
+          if (ilpNames()) {
+            std::stringstream ss;
+            ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
+               << segmentA->pl().getStrRepr() << segmentB->pl().getStrRepr()
+               << "," << linepair.first.line << "(" << linepair.first.line->id()
+               << ")," << linepair.second.line << "("
+               << linepair.second.line->id() << ")," << node << ")";
+            cols.setName(decisionVar, ss.str());
+          }
 
-          int row2 = lp->addRow(rowName2.str(), 0, shared::optim::LO);
+          int aSmallerBinL1 = getOrderVarId(
+              ordVars, segmentA, linepair.first.line, linepair.second.line);
+          int aSmallerBinL2 = getOrderVarId(
+              ordVars, segmentB, linepair.first.line, linepair.second.line);
+          int bSmallerAinL2 = getOrderVarId(
+              ordVars, segmentB, linepair.second.line, linepair.first.line);
 
           bool otherWayA = (segmentA->getFrom() != node) ^
                            segmentA->pl().lnEdgParts.front().dir;
@@ -403,13 +491,37 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
             aSmallerBinL2 = bSmallerAinL2;
           }
 
-          lp->addColToRow(row, aSmallerBinL1, -1);
-          lp->addColToRow(row, aSmallerBinL2, 1);
-          lp->addColToRow(row, decisionVar, 1);
+          if (start) {
+            // the lines cross iff their orders in A and B differ
+            (*start)[decisionVar] =
+                std::abs(start->at(aSmallerBinL1) - start->at(aSmallerBinL2));
+          }
 
-          lp->addColToRow(row2, aSmallerBinL1, 1);
-          lp->addColToRow(row2, aSmallerBinL2, -1);
-          lp->addColToRow(row2, decisionVar, 1);
+          int row = decRows.add(0, shared::optim::LO);
+          decRows.addCoef(aSmallerBinL1, -1);
+          decRows.addCoef(aSmallerBinL2, 1);
+          decRows.addCoef(decisionVar, 1);
+
+          int row2 = decRows.add(0, shared::optim::LO);
+          decRows.addCoef(aSmallerBinL1, 1);
+          decRows.addCoef(aSmallerBinL2, -1);
+          decRows.addCoef(decisionVar, 1);
+
+          if (ilpNames()) {
+            std::stringstream rowName;
+            rowName << "sum_dec(e1=" << segmentA->pl().getStrRepr()
+                    << ",e2=" << segmentB->pl().getStrRepr()
+                    << ",A=" << linepair.first.line
+                    << ",B=" << linepair.second.line << ",n=" << node << ")";
+            decRows.setName(row, rowName.str());
+
+            std::stringstream rowName2;
+            rowName2 << "sum_dec2(e1=" << segmentA->pl().getStrRepr()
+                     << ",e2=" << segmentB->pl().getStrRepr()
+                     << ",A=" << linepair.first.line
+                     << ",B=" << linepair.second.line << ",n=" << node << ")";
+            decRows.setName(row2, rowName2.str());
+          }
         }
       }
 
@@ -430,57 +542,59 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
               // segment A to segment B and the cardinality of both A and B
               // is > 2 (that is, it is possible in A or B that the two lines
               // won't be together)
-              std::stringstream sss;
-              sss << "x_decT(" << segmentA->pl().getStrRepr() << ","
-                  << segmentA->pl().getStrRepr() << segmentB->pl().getStrRepr()
-                  << "," << linepair.first.line << "("
-                  << linepair.first.line->id() << ")," << linepair.second.line
-                  << "(" << linepair.second.line->id() << ")," << node << ")";
-
-              int decisionVarDist1Change = lp->addCol(
-                  sss.str(), shared::optim::BIN, getSeparationPenalty(node));
-
-              int aNearBinL1 = 0;
-              int aNearBinL2 = 0;
-
-              std::stringstream aNearBL1Str;
-              aNearBL1Str << "x_(" << segmentA->pl().getStrRepr() << ","
-                          << linepair.first.line << "<T>"
-                          << linepair.second.line << ")";
-              aNearBinL1 = lp->getVarByName(aNearBL1Str.str());
-              assert(aNearBinL1 > -1);
-
-              std::stringstream aNearBL2Str;
-              aNearBL2Str << "x_(" << segmentB->pl().getStrRepr() << ","
-                          << linepair.first.line << "<T>"
-                          << linepair.second.line << ")";
-              aNearBinL2 = lp->getVarByName(aNearBL2Str.str());
-              assert(aNearBinL2 > -1);
-
-              std::stringstream rowTName;
-              rowTName << "sum_decT(e1=" << segmentA->pl().getStrRepr()
-                       << ",e2=" << segmentB->pl().getStrRepr()
-                       << ",A=" << linepair.first.line
-                       << ",B=" << linepair.second.line << ",n=" << node << ")";
-
-              int rowT = lp->addRow(rowTName.str(), 0, shared::optim::LO);
-
-              std::stringstream rowTName2;
-              rowTName2 << "sum_decT2(e1=" << segmentA->pl().getStrRepr()
-                        << ",e2=" << segmentB->pl().getStrRepr()
-                        << ",A=" << linepair.first.line
-                        << ",B=" << linepair.second.line << ",n=" << node
-                        << ")";
-
-              int rowT2 = lp->addRow(rowTName2.str(), 0, shared::optim::LO);
-
-              lp->addColToRow(rowT, aNearBinL1, -1);
-              lp->addColToRow(rowT, aNearBinL2, 1);
-              lp->addColToRow(rowT, decisionVarDist1Change, 1);
-
-              lp->addColToRow(rowT2, aNearBinL1, 1);
-              lp->addColToRow(rowT2, aNearBinL2, -1);
-              lp->addColToRow(rowT2, decisionVarDist1Change, 1);
+              int decisionVarDist1Change =
+                  cols.add(shared::optim::BIN, getSeparationPenalty(node));
+
+              if (ilpNames()) {
+                std::stringstream sss;
+                sss << "x_decT(" << segmentA->pl().getStrRepr() << ","
+                    << segmentA->pl().getStrRepr()
+                    << segmentB->pl().getStrRepr() << ","
+                    << linepair.first.line << "(" << linepair.first.line->id()
+                    << ")," << linepair.second.line << "("
+                    << linepair.second.line->id() << ")," << node << ")";
+                cols.setName(decisionVarDist1Change, sss.str());
+              }
+
+              int aNearBinL1 = getDistVarId(distVars, segmentA,
+                                              linepair.first.line,
+                                              linepair.second.line);
+              int aNearBinL2 = getDistVarId(distVars, segmentB,
+                                              linepair.first.line,
+                                              linepair.second.line);
+
+              int rowT = decRows.add(0, shared::optim::LO);
+              decRows.addCoef(aNearBinL1, -1);
+              decRows.addCoef(aNearBinL2, 1);
+              decRows.addCoef(decisionVarDist1Change, 1);
+
+              int rowT2 = decRows.add(0, shared::optim::LO);
+              decRows.addCoef(aNearBinL1, 1);
+              decRows.addCoef(aNearBinL2, -1);
+              decRows.addCoef(decisionVarDist1Change, 1);
+
+              if (ilpNames()) {
+                std::stringstream rowTName;
+                rowTName << "sum_decT(e1=" << segmentA->pl().getStrRepr()
+                         << ",e2=" << segmentB->pl().getStrRepr()
+                         << ",A=" << linepair.first.line
+                         << ",B=" << linepair.second.line << ",n=" << node
+                         << ")";
+                decRows.setName(rowT, rowTName.str());
+
+                std::stringstream rowTName2;
+                rowTName2 << "sum_decT2(e1=" << segmentA->pl().getStrRepr()
+                          << ",e2=" << segmentB->pl().getStrRepr()
+                          << ",A=" << linepair.first.line
+                          << ",B=" << linepair.second.line << ",n=" << node
+                          << ")";
+                decRows.setName(rowT2, rowTName2.str());
+              }
+
+              if (start) {
+                (*start)[decisionVarDist1Change] =
+                    std::abs(start->at(aNearBinL1) - start->at(aNearBinL2));
+              }
             } else if ((segmentA->pl().getCardinality() == 2) ^
                        (segmentB->pl().getCardinality() == 2)) {
               // the trivial case where one of the two segments only has
@@ -489,23 +603,32 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
               OptEdge* segment =
                   segmentA->pl().getCardinality() != 2 ? segmentA : segmentB;
 
-              std::stringstream aNearBStr;
-              aNearBStr << "x_(" << segment->pl().getStrRepr() << ","
-                        << linepair.first.line << "<T>" << linepair.second.line
-                        << ")";
-
-              lp->setObjCoef(aNearBStr.str(), getSeparationPenalty(node));
+              cols.setObjCoef(getDistVarId(distVars, segment,
+                                           linepair.first.line,
+                                           linepair.second.line),
+                              getSeparationPenalty(node));
             }
           }
         }
       }
     }
   }
+
+  lp->addCols(cols);
+  lp->addRows(rows);
 }
 
 // _____________________________________________________________________________
 void ILPEdgeOrderOptimizer::writeDiffSegConstraintsImpr(
-    const std::set<OptNode*>& g, ILPSolver* lp) const {
+    const std::set<OptNode*>& g, ILPSolver* lp, StarterSol* start,
+    RowBatch* lazy) const {
+  EdgeVarIds ordVars, distVars;
+  getOrderVarIds(g, &ordVars, &distVars);
+
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+  RowBatch& decRows = lazy ? *lazy : rows;
+
   // go into nodes and build crossing constraints for adjacent
   for (OptNode* node : g) {
     std::set<OptEdge*> processed;
@@ -518,51 +641,56 @@ void ILPEdgeOrderOptimizer::writeDiffSegConstraintsImpr(
           // try all position combinations
 
           // introduce dec var
-          std::stringstream ss;
-          ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
-             << segments.first->pl().getStrRepr()
-             << segments.second->pl().getStrRepr() << "," << linepair.first.line
-             << "(" << linepair.first.line->id() << ")," << linepair.second.line
-             << "(" << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
+          int decisionVar = cols.add(
+              shared::optim::BIN,
               getCrossingPenaltyDiffSeg(node)
                   // multiply the penalty with the number of collapsed lines!
                   * (linepair.first.relatives.size()) *
                   (linepair.second.relatives.size()));
 
+          if (ilpNames()) {
+            std::stringstream ss;
+            ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
+               << segments.first->pl().getStrRepr()
+               << segments.second->pl().getStrRepr() << ","
+               << linepair.first.line << "(" << linepair.first.line->id()
+               << ")," << linepair.second.line << "("
+               << linepair.second.line->id() << ")," << node << ")";
+            cols.setName(decisionVar, ss.str());
+          }
+
+          if (start) (*start)[decisionVar] = 0;
+
           for (PosCom poscomb : getPositionCombinations(segmentA)) {
             if (crosses(node, segmentA, segments, poscomb)) {
               int testVar = 0;
 
               if (poscomb.first > poscomb.second) {
-                std::stringstream bBgAStr;
-                bBgAStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                        << linepair.first.line << "<" << linepair.second.line
-                        << ")";
-                testVar = lp->getVarByName(bBgAStr.str());
+                testVar = getOrderVarId(ordVars, segmentA, linepair.first.line,
+                                        linepair.second.line);
               } else {
-                std::stringstream bBgAStr;
-                bBgAStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                        << linepair.second.line << "<" << linepair.first.line
-                        << ")";
-                testVar = lp->getVarByName(bBgAStr.str());
+                testVar = getOrderVarId(ordVars, segmentA,
+                                        linepair.second.line,
+                                        linepair.first.line);
               }
 
-              assert(testVar);
-              std::stringstream ss;
-              ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
-                 << segments.first->pl().getStrRepr()
-                 << segments.second->pl().getStrRepr() << ","
-                 << linepair.first.line << "," << linepair.second.line
-                 << "pa=" << poscomb.first << ",pb=" << poscomb.second
-                 << ",n=" << node << ")";
+              if (start) (*start)[decisionVar] = start->at(testVar);
 
-              int row = lp->addRow(ss.str(), 0, shared::optim::FIX);
+              int row = decRows.add(0, shared::optim::FIX);
 
-              lp->addColToRow(row, testVar, 1);
-              lp->addColToRow(row, decisionVar, -1);
+              decRows.addCoef(testVar, 1);
+              decRows.addCoef(decisionVar, -1);
+
+              if (ilpNames()) {
+                std::stringstream ss;
+                ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
+                   << segments.first->pl().getStrRepr()
+                   << segments.second->pl().getStrRepr() << ","
+                   << linepair.first.line << "," << linepair.second.line
+                   << "pa=" << poscomb.first << ",pb=" << poscomb.second
+                   << ",n=" << node << ")";
+                decRows.setName(row, ss.str());
+              }
 
               // one cross is enough...
               break;
@@ -572,4 +700,7 @@ void ILPEdgeOrderOptimizer::writeDiffSegConstraintsImpr(
       }
     }
   }
+
+  lp->addCols(cols);
+  lp->addRows(rows);
 }
@@ -28,17 +28,38 @@ class ILPEdgeOrderOptimizer : public ILPOptimizer {
 
  private:
   virtual shared::optim::ILPSolver* createProblem(
-      OptGraph* og, const std::set<OptNode*>& g) const;
+      OptGraph* og, const std::set<OptNode*>& g,
+      shared::optim::StarterSol* start, shared::optim::RowBatch* lazy) const;
 
   virtual void getConfigurationFromSolution(
       shared::optim::ILPSolver* lp, shared::rendergraph::HierarOrderCfg* c,
       const std::set<OptNode*>& g) const;
 
+  virtual void getStarter(const std::set<OptNode*>& g, const OptOrderCfg& cfg,
+                          shared::optim::StarterSol* start) const;
+
   void writeCrossingOracle(const std::set<OptNode*>& g,
-                           shared::optim::ILPSolver* lp) const;
+                           shared::optim::ILPSolver* lp,
+                           shared::optim::StarterSol* start,
+                           shared::optim::RowBatch* lazy) const;
 
   void writeDiffSegConstraintsImpr(const std::set<OptNode*>& g,
-                                   shared::optim::ILPSolver* lp) const;
+                                   shared::optim::ILPSolver* lp,
+                                   shared::optim::StarterSol* start,
+                                   shared::optim::RowBatch* lazy) const;
+
+  // the order variables x_(e,A<B) and the distance variables x_(e,A<T>B)
+  // follow the position variables
+  void getOrderVarIds(const std::set<OptNode*>& g, EdgeVarIds* ordVars,
+                      EdgeVarIds* distVars) const;
+
+  static int getOrderVarId(const EdgeVarIds& ordVars, const OptEdge* e,
+                           const shared::linegraph::Line* a,
+                           const shared::linegraph::Line* b);
+
+  static int getDistVarId(const EdgeVarIds& distVars, const OptEdge* e,
+                          const shared::linegraph::Line* a,
+                          const shared::linegraph::Line* b);
 };
 }  // namespace optim
 }  // namespace loom
@@ -2,10 +2,13 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <thread>
+#include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "shared/optim/ILPSolvProv.h"
@@ -18,7 +21,10 @@
 using namespace loom;
 using namespace optim;
 using shared::linegraph::Line;
+using shared::optim::ColBatch;
 using shared::optim::ILPSolver;
+using shared::optim::RowBatch;
+using shared::optim::StarterSol;
 using shared::rendergraph::HierarOrderCfg;
 
 // _____________________________________________________________________________
@@ -31,22 +37,52 @@ double ILPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
     return _exhausOpt.optimizeComp(og, g, hc, depth + 1, stats);
   }
 
+  // the local optimum found by hill climbing is passed to the solver as a
+  // starting solution, so there is a good incumbent from the beginning on
+  StarterSol start;
+  if (_cfg->ilpWarmStart) {
+    OptOrderCfg cfg;
+    HillClimbOptimizer(_cfg, _scorer.getPens(), false).climb(g, &cfg);
+    getStarter(g, cfg, &start);
+  }
+
+  // written problems should always be complete
+  bool lazyRows = _cfg->ilpLazyCrossings && _cfg->MPSOutputPath.empty();
+  RowBatch lazy(0);
+
   LOGTO(DEBUG, std::cerr) << "Creating ILP problem... ";
   T_START(build);
-  auto lp = createProblem(og, g);
+  auto lp = createProblem(og, g, _cfg->ilpWarmStart ? &start : 0,
+                          lazyRows ? &lazy : 0);
   double buildT = T_STOP(build);
   LOGTO(DEBUG, std::cerr) << " .. done";
 
-  if (lp->getNumVars() > static_cast<int>(stats.maxNumColsPerComp))
-    stats.maxNumColsPerComp = lp->getNumVars();
-  if (lp->getNumConstrs() > static_cast<int>(stats.maxNumRowsPerComp))
-    stats.maxNumRowsPerComp = lp->getNumConstrs();
+  // non-reentrant solvers (GLPK) wait for other instances on creation, the
+  // race may have been decided in the meantime
+  if (raceOver()) {
+    delete lp;
+    return 0;
+  }
+
+  // a running solve cannot be interrupted, so it may only take the time which
+  // is left in the race
+  int timeLim = _cfg->ilpTimeLimit;
+  int raceLeft = raceSecondsLeft();
+  if (raceLeft >= 0 && (timeLim < 0 || raceLeft < timeLim)) timeLim = raceLeft;
+
+  if (_cfg->ilpWarmStart) lp->setStarter(start);
 
   if (_cfg->MPSOutputPath.size()) {
     lp->writeMps(_cfg->MPSOutputPath);
+    if (_cfg->ilpWarmStart) {
+      std::string basename = _cfg->MPSOutputPath;
+      size_t pos = basename.find_last_of(".");
+      if (pos != std::string::npos) basename = basename.substr(0, pos);
+      lp->writeMst(basename + ".mst", start);
+    }
   }
 
-  if (_cfg->ilpTimeLimit >= 0) lp->setTimeLim(_cfg->ilpTimeLimit);
+  if (timeLim >= 0) lp->setTimeLim(timeLim);
   if (_cfg->ilpNumThreads != 0) lp->setNumThreads(_cfg->ilpNumThreads);
 
   LOGTO(DEBUG, std::cerr) << "Solving ILP problem...";
@@ -55,8 +91,39 @@ double ILPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
 
   auto status = lp->solve();
 
+  // the ordering is always valid, the lazy rows only make sure that the
+  // crossings are paid for. Re-solve until no crossing row is violated.
+  std::vector<bool> added(lazy.size(), false);
+  size_t rounds = 1;
+  bool violatedLeft = false;
+  while (lazy.size() && status != shared::optim::SolveType::INF) {
+    size_t num = addViolatedRows(lp, lazy, &added);
+    if (num == 0) break;
+
+    if (timeLim >= 0) {
+      int left = timeLim - T_STOP(solve) / 1000;
+      if (left <= 0) {
+        LOG(WARN) << "ILP time limit reached with " << num
+                  << " violated crossing constraints left!";
+        violatedLeft = true;
+        break;
+      }
+      lp->setTimeLim(left);
+    }
+
+    LOGTO(DEBUG, std::cerr) << "Added " << num
+                            << " violated crossing constraints, re-solving...";
+    status = lp->solve();
+    rounds++;
+  }
+
   double solveT = T_STOP(solve);
 
+  if (lp->getNumVars() > static_cast<int>(stats.maxNumColsPerComp))
+    stats.maxNumColsPerComp = lp->getNumVars();
+  if (lp->getNumConstrs() > static_cast<int>(stats.maxNumRowsPerComp))
+    stats.maxNumRowsPerComp = lp->getNumConstrs();
+
   if (status == shared::optim::SolveType::INF) {
     LOG(WARN)
         << "No solution found for ILP problem (most likely because of a time "
@@ -65,8 +132,27 @@ double ILPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
     LOGTO(DEBUG, std::cerr) << "(stats) ILP obj = " << lp->getObjVal();
     LOGTO(DEBUG, std::cerr) << "(stats) ILP build time = " << buildT << " ms";
     LOGTO(DEBUG, std::cerr) << "(stats) ILP solve time = " << solveT << " ms";
-    if (status == shared::optim::SolveType::OPTIM)
+    if (lazy.size()) {
+      LOGTO(DEBUG, std::cerr)
+          << "(stats) ILP solve rounds = " << rounds << ", "
+          << std::count(added.begin(), added.end(), true) << " of "
+          << lazy.size() << " crossing constraints added";
+    }
+    if (status == shared::optim::SolveType::OPTIM) {
       LOGTO(DEBUG, std::cerr) << "(stats) (which is optimal)";
+    }
+
+    // with violated lazy rows left, the objective is not the true score
+    if (!violatedLeft) {
+      double obj = lp->getObjVal();
+      double gap = 0;
+      if (status != shared::optim::SolveType::OPTIM && obj > 0) {
+        gap = std::max(0.0, (obj - lp->getBestBound()) / obj);
+      }
+      LOGTO(DEBUG, std::cerr) << "(stats) ILP gap = " << gap;
+      stats.gap = gap;
+      if (status == shared::optim::SolveType::OPTIM) raceSolved();
+    }
 
     getConfigurationFromSolution(lp, hc, g);
   }
@@ -95,19 +181,22 @@ int ILPOptimizer::getSeparationPenalty(const OptNode* n) const {
 // _____________________________________________________________________________
 void ILPOptimizer::getConfigurationFromSolution(
     ILPSolver* lp, HierarOrderCfg* hc, const std::set<OptNode*>& g) const {
-  // build name index for faster lookup
+  std::vector<double> vals;
+  lp->getVarVals(&vals);
+
+  auto posVars = getPosVarIds(g);
 
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
+      size_t card = e->pl().getCardinality();
       for (auto lnEdgPart : e->pl().lnEdgParts) {
         if (lnEdgPart.wasCut) continue;
-        for (size_t tp = 0; tp < e->pl().getCardinality(); tp++) {
+        for (size_t tp = 0; tp < card; tp++) {
           bool found = false;
-          for (auto lo : e->pl().getLines()) {
-            std::string varName = getILPVarName(e, lo.line, tp);
-
-            double val = lp->getVarVal(varName);
+          for (size_t i = 0; i < card; i++) {
+            const auto& lo = e->pl().getLines()[i];
+            double val = vals[posVars[e] + i * card + tp];
 
             if (val > 0.5) {
               for (auto rel : lo.relatives) {
@@ -133,48 +222,106 @@ void ILPOptimizer::getConfigurationFromSolution(
   }
 }
 
+// _____________________________________________________________________________
+void ILPOptimizer::getStarter(const std::set<OptNode*>& g,
+                              const OptOrderCfg& cfg, StarterSol* start) const {
+  auto posVars = getPosVarIds(g);
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      size_t card = e->pl().getCardinality();
+      for (size_t i = 0; i < card; i++) {
+        for (size_t p = 0; p < card; p++) {
+          (*start)[posVars[e] + i * card + p] =
+              cfg.lineAt(e, p) == e->pl().getLines()[i].line;
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+EdgeVarIds ILPOptimizer::getPosVarIds(const std::set<OptNode*>& g) const {
+  EdgeVarIds ret;
+  int id = 0;
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      ret[e] = id;
+      id += e->pl().getCardinality() * e->pl().getCardinality();
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+size_t ILPOptimizer::getLineIdx(const OptEdge* e, const Line* l) {
+  return e->pl().getLineOcc(l) - &e->pl().getLines()[0];
+}
+
 // _____________________________________________________________________________
 ILPSolver* ILPOptimizer::createProblem(OptGraph* og,
-                                       const std::set<OptNode*>& g) const {
+                                       const std::set<OptNode*>& g,
+                                       StarterSol* start,
+                                       RowBatch* lazy) const {
   ILPSolver* lp = shared::optim::getSolver(_cfg->ilpSolver, shared::optim::MIN);
 
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+
   // for every segment s, we define |L(s)|^2 decision variables x_slp
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
-      // get string repr of lineedge part
+      size_t card = e->pl().getCardinality();
 
-      int rowA = lp->getNumConstrs();
+      int first = cols.getFirstId() + cols.size();
 
-      for (size_t p = 0; p < e->pl().getCardinality(); p++) {
-        std::stringstream rowName;
-
-        rowName << "sum(" << e->pl().getStrRepr() << ",p=" << p << ")";
-        lp->addRow(rowName.str(), 1, shared::optim::FIX);
+      for (auto l : e->pl().getLines()) {
+        for (size_t p = 0; p < card; p++) {
+          int col = cols.add(shared::optim::BIN, 0);
+          if (ilpNames()) cols.setName(col, getILPVarName(e, l.line, p));
+        }
       }
 
-      for (auto l : e->pl().getLines()) {
-        // constraint: the sum of all x_slp over p must be 1 for equal sl
-        std::stringstream rowName;
-        rowName << "sum(" << e->pl().getStrRepr() << ",l=" << l.line << ")";
+      // constraint: the sum of all x_slp over l must be 1 for equal sp
+      for (size_t p = 0; p < card; p++) {
+        int row = rows.add(1, shared::optim::FIX);
+        for (size_t i = 0; i < card; i++) rows.addCoef(first + i * card + p, 1);
 
-        int row = lp->addRow(rowName.str(), 1, shared::optim::FIX);
+        if (ilpNames()) {
+          std::stringstream rowName;
+          rowName << "sum(" << e->pl().getStrRepr() << ",p=" << p << ")";
+          rows.setName(row, rowName.str());
+        }
+      }
 
-        for (size_t p = 0; p < e->pl().getCardinality(); p++) {
-          std::string varName = getILPVarName(e, l.line, p);
-          int curCol = lp->addCol(varName, shared::optim::BIN, 0);
+      // constraint: the sum of all x_slp over p must be 1 for equal sl
+      for (size_t i = 0; i < card; i++) {
+        int row = rows.add(1, shared::optim::FIX);
+        for (size_t p = 0; p < card; p++) rows.addCoef(first + i * card + p, 1);
 
-          lp->addColToRow(row, curCol, 1);
-          lp->addColToRow(rowA + p, curCol, 1);
+        if (ilpNames()) {
+          std::stringstream rowName;
+          rowName << "sum(" << e->pl().getStrRepr()
+                  << ",l=" << e->pl().getLines()[i].line << ")";
+          rows.setName(row, rowName.str());
         }
       }
     }
   }
 
+  lp->addCols(cols);
+  lp->addRows(rows);
   lp->update();
 
-  writeSameSegConstraints(og, g, lp);
-  writeDiffSegConstraints(og, g, lp);
+  writeSameSegConstraints(og, g, lp, start, lazy);
+  writeDiffSegConstraints(og, g, lp, start, lazy);
+
+  lp->update();
 
   return lp;
 }
@@ -182,8 +329,15 @@ ILPSolver* ILPOptimizer::createProblem(OptGraph* og,
 // _____________________________________________________________________________
 void ILPOptimizer::writeSameSegConstraints(OptGraph* og,
                                            const std::set<OptNode*>& g,
-                                           ILPSolver* lp) const {
+                                           ILPSolver* lp, StarterSol* start,
+                                           RowBatch* lazy) const {
   UNUSED(og);
+  auto posVars = getPosVarIds(g);
+
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+  RowBatch& decRows = lazy ? *lazy : rows;
+
   // go into nodes and build crossing constraints for adjacent
   for (OptNode* node : g) {
     std::set<OptEdge*> processed;
@@ -200,110 +354,153 @@ void ILPOptimizer::writeSameSegConstraints(OptGraph* og,
           // try all position combinations
 
           // introduce dec var
-          std::stringstream ss;
-          ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
-             << segmentB->pl().getStrRepr() << "," << linepair.first.line << "("
-             << linepair.first.line->id() << ")," << linepair.second.line << "("
-             << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
+          int decisionVar = cols.add(
+              shared::optim::BIN,
               getCrossingPenaltySameSeg(node)
                   // multiply the penalty with the number of collapsed lines!
                   * (linepair.first.relatives.size()) *
                   (linepair.second.relatives.size()));
 
-          // introduce dec var for sep
-          std::stringstream sss;
-          sss << "x||_dec(" << segmentA->pl().getStrRepr() << ","
-              << segmentB->pl().getStrRepr() << "," << linepair.first.line
-              << "(" << linepair.first.line->id() << "),"
-              << linepair.second.line << "(" << linepair.second.line->id()
-              << ")," << node << ")";
+          if (ilpNames()) {
+            std::stringstream ss;
+            ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
+               << segmentB->pl().getStrRepr() << "," << linepair.first.line
+               << "(" << linepair.first.line->id() << "),"
+               << linepair.second.line << "(" << linepair.second.line->id()
+               << ")," << node << ")";
+            cols.setName(decisionVar, ss.str());
+          }
 
+          // introduce dec var for sep
           int decisionVarSep = 0;
           if (separationOpt()) {
-            decisionVarSep = lp->addCol(sss.str(), shared::optim::BIN,
-                                        getSeparationPenalty(node));
+            decisionVarSep =
+                cols.add(shared::optim::BIN, getSeparationPenalty(node));
+
+            if (ilpNames()) {
+              std::stringstream sss;
+              sss << "x||_dec(" << segmentA->pl().getStrRepr() << ","
+                  << segmentB->pl().getStrRepr() << "," << linepair.first.line
+                  << "(" << linepair.first.line->id() << "),"
+                  << linepair.second.line << "("
+                  << linepair.second.line->id() << ")," << node << ")";
+              cols.setName(decisionVarSep, sss.str());
+            }
           }
 
+          // values of the dec vars in the starting solution
+          int decVal = 0;
+          int decSepVal = 0;
+
+          size_t cardA = segmentA->pl().getCardinality();
+          size_t cardB = segmentB->pl().getCardinality();
+
+          int firstInA =
+              posVars[segmentA] + getLineIdx(segmentA, linepair.first.line) *
+                                      cardA;
+          int secondInA =
+              posVars[segmentA] + getLineIdx(segmentA, linepair.second.line) *
+                                      cardA;
+          int firstInB =
+              posVars[segmentB] + getLineIdx(segmentB, linepair.first.line) *
+                                      cardB;
+          int secondInB =
+              posVars[segmentB] + getLineIdx(segmentB, linepair.second.line) *
+                                      cardB;
+
           for (PosComPair poscomb :
                getPositionCombinations(segmentA, segmentB)) {
-            if (crosses(node, segmentA, segmentB, poscomb)) {
-              int lineAinAatP = lp->getVarByName(getILPVarName(
-                  segmentA, linepair.first.line, poscomb.first.first));
-              int lineBinAatP = lp->getVarByName(getILPVarName(
-                  segmentA, linepair.second.line, poscomb.second.first));
-              int lineAinBatP = lp->getVarByName(getILPVarName(
-                  segmentB, linepair.first.line, poscomb.first.second));
-              int lineBinBatP = lp->getVarByName(getILPVarName(
-                  segmentB, linepair.second.line, poscomb.second.second));
-
-              assert(lineAinAatP > -1);
-              assert(lineAinBatP > -1);
-              assert(lineBinAatP > -1);
-              assert(lineBinBatP > -1);
-
-              std::stringstream ss;
-              ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
-                 << segmentB->pl().getStrRepr() << "," << linepair.first.line
-                 << "," << linepair.second.line << "pa=" << poscomb.first.first
-                 << ",pb=" << poscomb.second.first
-                 << ",pa'=" << poscomb.first.second
-                 << ",pb'=" << poscomb.second.second << ",n=" << node << ")";
-
-              int row = lp->addRow(ss.str(), 3, shared::optim::UP);
-
-              lp->addColToRow(row, lineAinAatP, 1);
-              lp->addColToRow(row, lineBinAatP, 1);
-              lp->addColToRow(row, lineAinBatP, 1);
-              lp->addColToRow(row, lineBinBatP, 1);
-              lp->addColToRow(row, decisionVar, -1);
+            bool cross = crosses(node, segmentA, segmentB, poscomb);
+            bool sep = separationOpt() && separates(poscomb);
+            if (!cross && !sep) continue;
+
+            int lineAinAatP = firstInA + poscomb.first.first;
+            int lineBinAatP = secondInA + poscomb.second.first;
+            int lineAinBatP = firstInB + poscomb.first.second;
+            int lineBinBatP = secondInB + poscomb.second.second;
+
+            int startSum = 0;
+            if (start) {
+              startSum = start->at(lineAinAatP) + start->at(lineBinAatP) +
+                         start->at(lineAinBatP) + start->at(lineBinBatP);
             }
 
-            if (separationOpt() && separates(poscomb)) {
-              int lineAinAatP = lp->getVarByName(getILPVarName(
-                  segmentA, linepair.first.line, poscomb.first.first));
-              int lineBinAatP = lp->getVarByName(getILPVarName(
-                  segmentA, linepair.second.line, poscomb.second.first));
-              int lineAinBatP = lp->getVarByName(getILPVarName(
-                  segmentB, linepair.first.line, poscomb.first.second));
-              int lineBinBatP = lp->getVarByName(getILPVarName(
-                  segmentB, linepair.second.line, poscomb.second.second));
-
-              assert(lineAinAatP > -1);
-              assert(lineAinBatP > -1);
-              assert(lineBinAatP > -1);
-              assert(lineBinBatP > -1);
-
-              std::stringstream ss;
-              ss << "dec_sum_sep(" << segmentA->pl().getStrRepr() << ","
-                 << segmentB->pl().getStrRepr() << "," << linepair.first.line
-                 << "," << linepair.second.line << "pa=" << poscomb.first.first
-                 << ",pb=" << poscomb.second.first
-                 << ",pa'=" << poscomb.first.second
-                 << ",pb'=" << poscomb.second.second << ",n=" << node << ")";
-
-              int row = lp->addRow(ss.str(), 3, shared::optim::UP);
-
-              lp->addColToRow(row, lineAinAatP, 1);
-              lp->addColToRow(row, lineBinAatP, 1);
-              lp->addColToRow(row, lineAinBatP, 1);
-              lp->addColToRow(row, lineBinBatP, 1);
-              lp->addColToRow(row, decisionVarSep, -1);
+            if (cross) {
+              int row = decRows.add(3, shared::optim::UP);
+
+              decRows.addCoef(lineAinAatP, 1);
+              decRows.addCoef(lineBinAatP, 1);
+              decRows.addCoef(lineAinBatP, 1);
+              decRows.addCoef(lineBinBatP, 1);
+              decRows.addCoef(decisionVar, -1);
+
+              if (ilpNames()) {
+                std::stringstream ss;
+                ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
+                   << segmentB->pl().getStrRepr() << "," << linepair.first.line
+                   << "," << linepair.second.line
+                   << "pa=" << poscomb.first.first
+                   << ",pb=" << poscomb.second.first
+                   << ",pa'=" << poscomb.first.second
+                   << ",pb'=" << poscomb.second.second << ",n=" << node
+                   << ")";
+                decRows.setName(row, ss.str());
+              }
+
+              decVal = std::max(decVal, startSum - 3);
+            }
+
+            if (sep) {
+              int row = decRows.add(3, shared::optim::UP);
+
+              decRows.addCoef(lineAinAatP, 1);
+              decRows.addCoef(lineBinAatP, 1);
+              decRows.addCoef(lineAinBatP, 1);
+              decRows.addCoef(lineBinBatP, 1);
+              decRows.addCoef(decisionVarSep, -1);
+
+              if (ilpNames()) {
+                std::stringstream ss;
+                ss << "dec_sum_sep(" << segmentA->pl().getStrRepr() << ","
+                   << segmentB->pl().getStrRepr() << "," << linepair.first.line
+                   << "," << linepair.second.line
+                   << "pa=" << poscomb.first.first
+                   << ",pb=" << poscomb.second.first
+                   << ",pa'=" << poscomb.first.second
+                   << ",pb'=" << poscomb.second.second << ",n=" << node
+                   << ")";
+                decRows.setName(row, ss.str());
+              }
+
+              decSepVal = std::max(decSepVal, startSum - 3);
             }
           }
+
+          if (start) {
+            (*start)[decisionVar] = decVal;
+            if (separationOpt()) (*start)[decisionVarSep] = decSepVal;
+          }
         }
       }
     }
   }
+
+  lp->addCols(cols);
+  lp->addRows(rows);
 }
 
 // _____________________________________________________________________________
 void ILPOptimizer::writeDiffSegConstraints(OptGraph* og,
                                            const std::set<OptNode*>& g,
-                                           ILPSolver* lp) const {
+                                           ILPSolver* lp, StarterSol* start,
+                                           RowBatch* lazy) const {
   UNUSED(og);
+  auto posVars = getPosVarIds(g);
+
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+  RowBatch& decRows = lazy ? *lazy : rows;
+
   // go into nodes and build crossing constraints for adjacent
   for (OptNode* node : g) {
     std::set<OptEdge*> processed;
@@ -316,49 +513,114 @@ void ILPOptimizer::writeDiffSegConstraints(OptGraph* og,
           // try all position combinations
 
           // introduce dec var
-          std::stringstream ss;
-          ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
-             << segments.first->pl().getStrRepr()
-             << segments.second->pl().getStrRepr() << "," << linepair.first.line
-             << "(" << linepair.first.line->id() << ")," << linepair.second.line
-             << "(" << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
+          int decisionVar = cols.add(
+              shared::optim::BIN,
               getCrossingPenaltyDiffSeg(node)
                   // multiply the penalty with the number of collapsed lines!
                   * (linepair.first.relatives.size()) *
                   (linepair.second.relatives.size()));
 
+          if (ilpNames()) {
+            std::stringstream ss;
+            ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
+               << segments.first->pl().getStrRepr()
+               << segments.second->pl().getStrRepr() << ","
+               << linepair.first.line << "(" << linepair.first.line->id()
+               << ")," << linepair.second.line << "("
+               << linepair.second.line->id() << ")," << node << ")";
+            cols.setName(decisionVar, ss.str());
+          }
+
+          int decVal = 0;
+
+          size_t card = segmentA->pl().getCardinality();
+          int firstInA =
+              posVars[segmentA] + getLineIdx(segmentA, linepair.first.line) *
+                                      card;
+          int secondInA =
+              posVars[segmentA] + getLineIdx(segmentA, linepair.second.line) *
+                                      card;
+
           for (PosCom poscomb : getPositionCombinations(segmentA)) {
             if (crosses(node, segmentA, segments, poscomb)) {
-              int lineAinAatP = lp->getVarByName(
-                  getILPVarName(segmentA, linepair.first.line, poscomb.first));
-              int lineBinAatP = lp->getVarByName(getILPVarName(
-                  segmentA, linepair.second.line, poscomb.second));
-
-              assert(lineAinAatP > -1);
-              assert(lineBinAatP > -1);
-
-              std::stringstream ss;
-              ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
-                 << segments.first->pl().getStrRepr()
-                 << segments.second->pl().getStrRepr() << ","
-                 << linepair.first.line << "," << linepair.second.line
-                 << "pa=" << poscomb.first << ",pb=" << poscomb.second
-                 << ",n=" << node << ")";
-
-              int row = lp->addRow(ss.str(), 1, shared::optim::UP);
-
-              lp->addColToRow(row, lineAinAatP, 1);
-              lp->addColToRow(row, lineBinAatP, 1);
-              lp->addColToRow(row, decisionVar, -1);
+              int lineAinAatP = firstInA + poscomb.first;
+              int lineBinAatP = secondInA + poscomb.second;
+
+              int row = decRows.add(1, shared::optim::UP);
+
+              decRows.addCoef(lineAinAatP, 1);
+              decRows.addCoef(lineBinAatP, 1);
+              decRows.addCoef(decisionVar, -1);
+
+              if (ilpNames()) {
+                std::stringstream ss;
+                ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
+                   << segments.first->pl().getStrRepr()
+                   << segments.second->pl().getStrRepr() << ","
+                   << linepair.first.line << "," << linepair.second.line
+                   << "pa=" << poscomb.first << ",pb=" << poscomb.second
+                   << ",n=" << node << ")";
+                decRows.setName(row, ss.str());
+              }
+
+              if (start) {
+                int sum = start->at(lineAinAatP) + start->at(lineBinAatP);
+                decVal = std::max(decVal, sum - 1);
+              }
             }
           }
+
+          if (start) (*start)[decisionVar] = decVal;
         }
       }
     }
   }
+
+  lp->addCols(cols);
+  lp->addRows(rows);
+}
+
+// _____________________________________________________________________________
+size_t ILPOptimizer::addViolatedRows(ILPSolver* lp, const RowBatch& lazy,
+                                     std::vector<bool>* added) const {
+  std::vector<double> vals;
+  lp->getVarVals(&vals);
+
+  const auto& starts = lazy.getStarts();
+  const auto& cols = lazy.getCols();
+  const auto& coefs = lazy.getCoefs();
+
+  RowBatch rows(lp->getNumConstrs());
+
+  for (size_t i = 0; i < lazy.size(); i++) {
+    if ((*added)[i]) continue;
+
+    double lhs = 0;
+    for (size_t j = starts[i]; j < starts[i + 1]; j++) {
+      lhs += coefs[j] * vals[cols[j]];
+    }
+
+    // all coefficients and variables of the crossing constraints are
+    // integral, so a violation is at least 1
+    double bnd = lazy.getBnds()[i];
+    auto type = lazy.getTypes()[i];
+    if (type == shared::optim::UP && lhs < bnd + 0.5) continue;
+    if (type == shared::optim::LO && lhs > bnd - 0.5) continue;
+    if (type == shared::optim::FIX && fabs(lhs - bnd) < 0.5) continue;
+
+    (*added)[i] = true;
+
+    int row = rows.add(bnd, type);
+    for (size_t j = starts[i]; j < starts[i + 1]; j++) {
+      rows.addCoef(cols[j], coefs[j]);
+    }
+    if (lazy.getNames().size()) rows.setName(row, lazy.getNames()[i]);
+  }
+
+  lp->addRows(rows);
+  lp->update();
+
+  return rows.size();
 }
 
 // _____________________________________________________________________________
@@ -411,3 +673,6 @@ std::string ILPOptimizer::getILPVarName(OptEdge* seg, const Line* r,
 
 // _____________________________________________________________________________
 bool ILPOptimizer::separationOpt() const { return _scorer.optimizeSep(); }
+
+// _____________________________________________________________________________
+bool ILPOptimizer::ilpNames() const { return _cfg->MPSOutputPath.size(); }
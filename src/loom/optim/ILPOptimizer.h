@@ -5,6 +5,7 @@
 #ifndef LOOM_OPTIM_ILPOPTIMIZER_H_
 #define LOOM_OPTIM_ILPOPTIMIZER_H_
 
+#include <map>
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/OptGraph.h"
@@ -16,6 +17,11 @@
 namespace loom {
 namespace optim {
 
+// column id of the first variable of a block of variables belonging to an
+// edge, e.g. the position variable of the i-th line of e at position p has
+// id base + i * |L(e)| + p
+typedef std::map<const OptEdge*, int> EdgeVarIds;
+
 class ILPOptimizer : public Optimizer {
  public:
   ILPOptimizer(const config::Config* cfg,
@@ -30,21 +36,49 @@ class ILPOptimizer : public Optimizer {
 
  protected:
   const loom::optim::ExhaustiveOptimizer _exhausOpt;
+
+  // if start is not null, it holds the values of the position variables of
+  // a starting solution, and the values of all other variables are added.
+  // Variable and constraint names are only generated if the problem is
+  // written to a file. If lazy is not null, the crossing constraints are
+  // not added to the problem but written to lazy
   virtual shared::optim::ILPSolver* createProblem(
-      OptGraph* og, const std::set<OptNode*>& g) const;
+      OptGraph* og, const std::set<OptNode*>& g,
+      shared::optim::StarterSol* start, shared::optim::RowBatch* lazy) const;
 
   virtual void getConfigurationFromSolution(
       shared::optim::ILPSolver* lp, shared::rendergraph::HierarOrderCfg* c,
       const std::set<OptNode*>& g) const;
 
+  // write the values of the position variables for cfg into start
+  virtual void getStarter(const std::set<OptNode*>& g, const OptOrderCfg& cfg,
+                          shared::optim::StarterSol* start) const;
+
   std::string getILPVarName(OptEdge* e, const shared::linegraph::Line* r,
                             size_t p) const;
 
   void writeSameSegConstraints(OptGraph* og, const std::set<OptNode*>& g,
-                               shared::optim::ILPSolver* lp) const;
+                               shared::optim::ILPSolver* lp,
+                               shared::optim::StarterSol* start,
+                               shared::optim::RowBatch* lazy) const;
 
   void writeDiffSegConstraints(OptGraph* og, const std::set<OptNode*>& g,
-                               shared::optim::ILPSolver* lp) const;
+                               shared::optim::ILPSolver* lp,
+                               shared::optim::StarterSol* start,
+                               shared::optim::RowBatch* lazy) const;
+
+  // add the rows of lazy not marked in added which are violated by the
+  // current solution of lp, returns the number of added rows
+  size_t addViolatedRows(shared::optim::ILPSolver* lp,
+                         const shared::optim::RowBatch& lazy,
+                         std::vector<bool>* added) const;
+
+  // position variables are the first columns of the problem, added for each
+  // edge in the iteration order of g
+  EdgeVarIds getPosVarIds(const std::set<OptNode*>& g) const;
+
+  // index of line l in the line vector of e
+  static size_t getLineIdx(const OptEdge* e, const shared::linegraph::Line* l);
 
   std::vector<PosComPair> getPositionCombinations(OptEdge* a, OptEdge* b) const;
   std::vector<PosCom> getPositionCombinations(OptEdge* a) const;
@@ -54,6 +88,9 @@ class ILPOptimizer : public Optimizer {
   int getSeparationPenalty(const OptNode* n) const;
 
   bool separationOpt() const;
+
+  // true if the variables and constraints should be named
+  bool ilpNames() const;
 };
 }  // namespace optim
 }  // namespace loom
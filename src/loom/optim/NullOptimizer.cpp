@@ -14,12 +14,14 @@ double NullOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                                 HierarOrderCfg* hc, size_t depth,
                                 OptResStats& stats) const {
   UNUSED(og);
-  UNUSED(stats);
   LOGTO(DEBUG, std::cerr) << prefix(depth)
                           << "(NullOptimizer) Optimizing component with "
                           << g.size() << " nodes.";
   T_START(1);
 
+  // single lines never cross or separate
+  if (maxCard(g) < 2) stats.gap = 0;
+
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
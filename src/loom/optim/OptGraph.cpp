@@ -2,14 +2,16 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <map>
 #include <set>
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
+#include "loom/optim/Tracer.h"
 #include "shared/linegraph/Line.h"
 #include "shared/linegraph/LineGraph.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "util/String.h"
-#include "util/graph/Algorithm.h"
 #include "util/log/Log.h"
 
 using loom::optim::LnEdgPart;
@@ -20,7 +22,9 @@ using loom::optim::OptGraphScorer;
 using loom::optim::OptLO;
 using loom::optim::OptNode;
 using loom::optim::OptNodePL;
+using loom::optim::OptOrderCfg;
 using loom::optim::PartnerPath;
+using loom::optim::TraceSpan;
 using shared::linegraph::Line;
 using shared::linegraph::LineEdge;
 using shared::linegraph::LineGraph;
@@ -28,10 +32,33 @@ using shared::linegraph::LineNode;
 using shared::linegraph::LineOcc;
 using shared::rendergraph::RenderGraph;
 using util::Nullable;
-using util::graph::Algorithm;
 
 const static double DO = 100;
 
+// _____________________________________________________________________________
+OptOrderCfg::OptOrderCfg(const std::set<OptNode*>& g) {
+  // the numbering is kept here and not in the graph, configs over different
+  // node sets sharing an edge may be created concurrently
+  auto ids = std::make_shared<std::unordered_map<const OptEdge*, size_t>>();
+
+  _offsets.push_back(0);
+  for (auto n : g) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      (*ids)[e] = _edges.size();
+      _edges.push_back(e);
+      _offsets.push_back(_offsets.back() + e->pl().getCardinality());
+    }
+  }
+
+  _ids = ids;
+
+  _perms.resize(_offsets.back());
+  for (size_t i = 0; i < _edges.size(); i++) {
+    for (size_t p = 0; p < card(i); p++) perm(i)[p] = p;
+  }
+}
+
 // _____________________________________________________________________________
 void OptGraph::upFirstLastEdg(OptEdge* optEdg) {
   size_t i = 0;
@@ -168,7 +195,7 @@ std::map<const LineNode*, OptNode*> OptGraph::build(RenderGraph* rg) {
 }
 
 // _____________________________________________________________________________
-void OptGraph::terminusDetach() {
+bool OptGraph::terminusDetach() {
   std::vector<std::pair<OptEdge*, OptNode*>> toDetach;
 
   // collect edges to cut
@@ -189,6 +216,8 @@ void OptGraph::terminusDetach() {
     }
   }
 
+  bool changed = false;
+
   for (auto ePair : toDetach) {
     OptEdge* e = ePair.first;
     OptNode* n = ePair.second;
@@ -197,6 +226,8 @@ void OptGraph::terminusDetach() {
       continue;  // may happen if we have detached an edge
                  // from the other side
 
+    changed = true;
+
     OptNode* eFrom = e->getFrom();
     OptNode* eTo = e->getTo();
 
@@ -218,10 +249,12 @@ void OptGraph::terminusDetach() {
       updateEdgeOrder(eTo);
     }
   }
+
+  return changed;
 }
 
 // _____________________________________________________________________________
-void OptGraph::splitSingleLineEdgs() {
+bool OptGraph::splitSingleLineEdgs() {
   std::vector<OptEdge*> toCut;
 
   // collect edges to cut
@@ -263,26 +296,35 @@ void OptGraph::splitSingleLineEdgs() {
     updateEdgeOrder(eFrom);
     updateEdgeOrder(eTo);
   }
+
+  return !toCut.empty();
 }
 
 // _____________________________________________________________________________
-void OptGraph::partnerLines() {
+bool OptGraph::partnerLines() {
   const auto& partners = getPartnerLines();
 
   for (const auto& p : partners) {
-    if (p.partners.size() == 1) continue;
-
     for (size_t i = 0; i < p.path.size(); i++) {
       // TODO: why isnt there a getLine function f or OptEdgePL?
       auto e = p.path[i];
+
+      // the partners may already be collapsed bundles themselves, concatenate
+      // their relatives in the direction of the path
+      std::vector<const Line*> rels;
+      for (const auto& partner : p.partners) {
+        auto rel = e->pl().getLineOcc(partner.line)->relatives;
+        if (p.inv[i]) std::reverse(rel.begin(), rel.end());
+        rels.insert(rels.end(), rel.begin(), rel.end());
+      }
+      if (p.inv[i]) std::reverse(rels.begin(), rels.end());
+
       auto it = e->pl().getLines().begin();
 
       while (it != e->pl().getLines().end()) {
         auto& ro = *it;
         if (ro == *p.partners.begin()) {
-          ro.relatives.clear();
-          for (auto partner : p.partners) ro.relatives.push_back(partner.line);
-          if (p.inv[i]) std::reverse(ro.relatives.begin(), ro.relatives.end());
+          ro.relatives = rels;
         } else if (p.partners.count(ro)) {
           it = e->pl().getLines().erase(it);
           continue;
@@ -291,6 +333,8 @@ void OptGraph::partnerLines() {
       }
     }
   }
+
+  return !partners.empty();
 }
 
 // _____________________________________________________________________________
@@ -319,31 +363,67 @@ Nullable<const OptLO> OptGraph::getLO(const OptEdge* a, const Line* r) {
 std::vector<PartnerPath> OptGraph::getPartnerLines() const {
   std::vector<PartnerPath> ret;
 
-  for (auto rt : getLines()) {
-    // create connected components w.r.t. route (each component consists only of
-    // edges containing route rt)
+  // the edges of each line
+  std::map<const Line*, std::set<OptEdge*>> lnEdgs;
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      for (const auto& lo : e->pl().getLines()) lnEdgs[lo.line].insert(e);
+    }
+  }
+
+  // equivalence classes of lines: lines can only be partners if they run
+  // over exactly the same connected set of edges. A line may run over
+  // several unconnected sets of edges (e.g. after untangling), each of them
+  // is considered separately.
+  std::map<std::set<OptEdge*>, std::set<const Line*>> classes;
+
+  for (const auto& le : lnEdgs) {
+    auto rem = le.second;
+    while (!rem.empty()) {
+      std::set<OptEdge*> comp;
+      std::vector<OptEdge*> stack{*rem.begin()};
+      rem.erase(rem.begin());
+
+      while (!stack.empty()) {
+        auto e = stack.back();
+        stack.pop_back();
+        comp.insert(e);
+        for (auto n : {e->getFrom(), e->getTo()}) {
+          for (auto f : n->getAdjList()) {
+            if (rem.erase(f)) stack.push_back(f);
+          }
+        }
+      }
 
-    struct Check : public Algorithm::EdgeCheckFunc<OptNodePL, OptEdgePL> {
-      Check(const Line* l) : rt(l){};
-      const Line* rt;
-      virtual bool operator()(const OptNode* frNd, const OptEdge* edg) const {
-        UNUSED(frNd);
-        // TODO: this will put lines not continueing over a particular edge
-        // in one component, as only the lines' presence on the edge is checked.
-        // Later on, we then cannot follow the edge through the entire path,
-        // which may lead to collapsing opportunities being missed.
-        auto ro = getLO(edg, rt);
-        return !ro.isNull();
-      };
-    };
+      classes[comp].insert(le.first);
+    }
+  }
 
-    const auto& comps = Algorithm::connectedComponents(*this, Check(rt));
+  for (const auto& c : classes) {
+    if (c.second.size() < 2) continue;
 
-    for (const auto& comp : comps) {
-      if (comp.size() < 2) continue;
-      auto p = pathFromComp(comp);
-      if (p.partners.size() && p.path.size()) ret.push_back(p);
+    std::set<OptNode*> comp;
+    for (auto e : c.first) {
+      comp.insert(e->getFrom());
+      comp.insert(e->getTo());
     }
+
+    auto p = pathFromComp(comp);
+
+    // the path has to run over exactly the edges of the class
+    if (std::set<OptEdge*>(p.path.begin(), p.path.end()) != c.first) continue;
+
+    // only lines of this class are interchangeable
+    for (auto it = p.partners.begin(); it != p.partners.end();) {
+      if (!c.second.count(it->line)) {
+        it = p.partners.erase(it);
+      } else {
+        it++;
+      }
+    }
+
+    if (p.partners.size() > 1) ret.push_back(p);
   }
 
   return ret;
@@ -440,29 +520,59 @@ PartnerPath OptGraph::pathFromComp(const std::set<OptNode*>& comp) const {
 }
 
 // _____________________________________________________________________________
-void OptGraph::contractDeg2Nds() {
-  while (contractDeg2Step()) {
+bool OptGraph::contractDeg2Nds() {
+  // all nodes which may be contractible, ordered like getNds(), so nodes are
+  // contracted in the same order as by a rescan after each contraction
+  std::set<OptNode*> work(getNds().begin(), getNds().end());
+  bool changed = false;
+
+  while (!work.empty()) {
+    OptNode* n = *work.begin();
+    work.erase(work.begin());
+
+    auto ends = contractDeg2(n);
+    if (!ends.first) continue;
+    changed = true;
+
+    // the contraction only changed the adjacency of the end nodes, which is
+    // also checked when contracting their neighbors
+    for (auto m : {ends.first, ends.second}) {
+      work.insert(m);
+      for (auto e : m->getAdjList()) work.insert(e->getOtherNd(m));
+    }
   }
+
+  return changed;
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangle() {
-  untangleDoubleStump();
+bool OptGraph::untangle() {
+  bool changed = false;
 
-  untangleOuterStump();
+  auto rule = [this](const std::string& name, bool (OptGraph::*f)()) {
+    TraceSpan span("untangle", name);
+    bool changed = (this->*f)();
+    span.arg("changed", changed);
+    return changed;
+  };
 
-  while (untangleFullX()) {
-  }
+  changed |= rule("double-stump", &OptGraph::untangleDoubleStump);
+
+  changed |= rule("outer-stump", &OptGraph::untangleOuterStump);
+
+  changed |= rule("full-x", &OptGraph::untangleFullX);
+
+  changed |= rule("y", &OptGraph::untangleY);
 
-  untangleY();
+  changed |= rule("partial-y", &OptGraph::untanglePartialY);
 
-  untanglePartialY();
+  changed |= rule("dog-bone", &OptGraph::untangleDogBone);
 
-  untangleDogBone();
+  changed |= rule("partial-dog-bone", &OptGraph::untanglePartialDogBone);
 
-  untanglePartialDogBone();
+  changed |= rule("inner-stump", &OptGraph::untangleInnerStump);
 
-  untangleInnerStump();
+  return changed;
 }
 
 // _____________________________________________________________________________
@@ -553,91 +663,86 @@ bool OptGraph::contractCheaper(const OptNode* cont, const OptNode* cheaper,
 }
 
 // _____________________________________________________________________________
-bool OptGraph::contractDeg2Step() {
-  for (OptNode* n : getNds()) {
-    if (n->getDeg() == 2) {
-      OptEdge* first = n->getAdjList().front();
-      OptEdge* second = n->getAdjList().back();
-
-      assert(n->pl().node);
-
-      if (dirLineEqualIn(first, second)) {
-        // if both edges have more than 2 lines, only contract if we can move
-        // potential crossings to a cheaper location
-        if (first->pl().getCardinality() > 1) {
-          if (!contractCheaper(n, first->getOtherNd(n),
-                               first->pl().getLines()) &&
-              !contractCheaper(n, second->getOtherNd(n),
-                               first->pl().getLines()))
-            continue;
-        }
+std::pair<OptNode*, OptNode*> OptGraph::contractDeg2(OptNode* n) {
+  std::pair<OptNode*, OptNode*> none(0, 0);
+  if (n->getDeg() != 2) return none;
 
-        OptNode* newFrom = 0;
-        OptNode* newTo = 0;
+  OptEdge* first = n->getAdjList().front();
+  OptEdge* second = n->getAdjList().back();
 
-        bool firstReverted;
-        bool secondReverted;
+  assert(n->pl().node);
 
-        // add new edge
-        if (first->getTo() != n) {
-          newFrom = first->getTo();
-          firstReverted = true;
-        } else {
-          newFrom = first->getFrom();
-          firstReverted = false;
-        }
+  if (!dirLineEqualIn(first, second)) return none;
 
-        if (second->getTo() != n) {
-          newTo = second->getTo();
-          secondReverted = false;
-        } else {
-          newTo = second->getFrom();
-          secondReverted = true;
-        }
+  // if both edges have more than 2 lines, only contract if we can move
+  // potential crossings to a cheaper location
+  if (first->pl().getCardinality() > 1) {
+    if (!contractCheaper(n, first->getOtherNd(n), first->pl().getLines()) &&
+        !contractCheaper(n, second->getOtherNd(n), first->pl().getLines()))
+      return none;
+  }
 
-        // Important: dont create a multigraph, dont add self-edges
-        if (newFrom == newTo || getEdg(newFrom, newTo)) continue;
+  OptNode* newFrom = 0;
+  OptNode* newTo = 0;
 
-        OptEdge* newEdge = addEdg(newFrom, newTo);
+  bool firstReverted;
+  bool secondReverted;
 
-        // add lnEdgParts...
-        for (LnEdgPart& lnEdgPart : first->pl().lnEdgParts) {
-          newEdge->pl().lnEdgParts.push_back(
-              LnEdgPart(lnEdgPart.lnEdg, (lnEdgPart.dir ^ firstReverted),
-                        lnEdgPart.order, lnEdgPart.wasCut));
-        }
+  // add new edge
+  if (first->getTo() != n) {
+    newFrom = first->getTo();
+    firstReverted = true;
+  } else {
+    newFrom = first->getFrom();
+    firstReverted = false;
+  }
 
-        for (LnEdgPart& lnEdgPart : second->pl().lnEdgParts) {
-          newEdge->pl().lnEdgParts.push_back(
-              LnEdgPart(lnEdgPart.lnEdg, (lnEdgPart.dir ^ secondReverted),
-                        lnEdgPart.order, lnEdgPart.wasCut));
-        }
+  if (second->getTo() != n) {
+    newTo = second->getTo();
+    secondReverted = false;
+  } else {
+    newTo = second->getFrom();
+    secondReverted = true;
+  }
 
-        upFirstLastEdg(newEdge);
+  // Important: dont create a multigraph, dont add self-edges
+  if (newFrom == newTo || getEdg(newFrom, newTo)) return none;
 
-        newEdge->pl().depth = std::max(first->pl().depth, second->pl().depth);
+  OptEdge* newEdge = addEdg(newFrom, newTo);
 
-        newEdge->pl().lines = first->pl().lines;
+  // add lnEdgParts...
+  for (LnEdgPart& lnEdgPart : first->pl().lnEdgParts) {
+    newEdge->pl().lnEdgParts.push_back(
+        LnEdgPart(lnEdgPart.lnEdg, (lnEdgPart.dir ^ firstReverted),
+                  lnEdgPart.order, lnEdgPart.wasCut));
+  }
 
-        // update direction markers
-        for (auto& ro : newEdge->pl().lines) {
-          if (ro.dir == n->pl().node) ro.dir = newTo->pl().node;
-        }
+  for (LnEdgPart& lnEdgPart : second->pl().lnEdgParts) {
+    newEdge->pl().lnEdgParts.push_back(
+        LnEdgPart(lnEdgPart.lnEdg, (lnEdgPart.dir ^ secondReverted),
+                  lnEdgPart.order, lnEdgPart.wasCut));
+  }
 
-        assert(newFrom != n);
-        assert(newTo != n);
+  upFirstLastEdg(newEdge);
 
-        delNd(n);
+  newEdge->pl().depth = std::max(first->pl().depth, second->pl().depth);
 
-        updateEdgeOrder(newFrom);
-        updateEdgeOrder(newTo);
+  newEdge->pl().lines = first->pl().lines;
 
-        return true;
-      }
-    }
+  // update direction markers
+  for (auto& ro : newEdge->pl().lines) {
+    if (ro.dir == n->pl().node) ro.dir = newTo->pl().node;
   }
 
-  return false;
+  assert(newFrom != n);
+  assert(newTo != n);
+
+  delNd(n);
+
+  updateEdgeOrder(newFrom);
+  updateEdgeOrder(newTo);
+
+  return {newFrom, newTo};
 }
 
 // _____________________________________________________________________________
@@ -797,49 +902,97 @@ std::pair<OptEdge*, OptEdge*> OptGraph::isFullX(OptNode* n) const {
 
 // _____________________________________________________________________________
 bool OptGraph::untangleFullX() {
-  for (OptNode* n : getNds()) {
-    std::pair<OptEdge*, OptEdge*> cross;
-    if ((cross = isFullX(n)).first) {
-      LOGTO(DEBUG, std::cerr)
-          << "Found full cross at node " << n << " between " << cross.first
-          << "(" << cross.first->pl().toStr() << ") and " << cross.second
-          << " (" << cross.second->pl().toStr() << ")";
-
-      auto newN = addNd(util::geo::DPoint(n->pl().getGeom()->getX() + DO,
-                                          n->pl().getGeom()->getY() + DO));
-      newN->pl().node = n->pl().node;
-
-      if (cross.first->getFrom() == n) {
-        addEdg(newN, cross.first->getTo(), cross.first->pl());
-      } else {
-        addEdg(cross.first->getFrom(), newN, cross.first->pl());
-      }
+  // all nodes which may be full crosses, ordered like getNds(), so crosses
+  // are untangled in the same order as by a rescan after each untangling
+  std::set<OptNode*> work(getNds().begin(), getNds().end());
+  bool changed = false;
 
-      if (cross.second->getFrom() == n) {
-        addEdg(newN, cross.second->getTo(), cross.second->pl());
-      } else {
-        addEdg(cross.second->getFrom(), newN, cross.second->pl());
-      }
+  while (!work.empty()) {
+    OptNode* n = *work.begin();
+    work.erase(work.begin());
 
-      auto fa = cross.first->getFrom();
-      auto fb = cross.first->getTo();
-      auto sa = cross.second->getFrom();
-      auto sb = cross.second->getTo();
+    std::vector<OptNode*> touched;
+    if (!untangleFullX(n, &touched)) continue;
+    changed = true;
 
-      delEdg(cross.first->getFrom(), cross.first->getTo());
-      delEdg(cross.second->getFrom(), cross.second->getTo());
+    // a full cross only depends on the edges at its node
+    work.insert(touched.begin(), touched.end());
+  }
 
-      updateEdgeOrder(n);
-      updateEdgeOrder(newN);
-      updateEdgeOrder(fa);
-      updateEdgeOrder(fb);
-      updateEdgeOrder(sa);
-      updateEdgeOrder(sb);
+  return changed;
+}
 
-      return true;
+// _____________________________________________________________________________
+bool OptGraph::untangleLocal(bool (OptGraph::*f)(OptNode*,
+                                                   std::vector<OptNode*>*)) {
+  // all nodes at which the rule may apply, ordered like getNds()
+  std::set<OptNode*> work(getNds().begin(), getNds().end());
+  bool changed = false;
+
+  while (!work.empty()) {
+    OptNode* n = *work.begin();
+    work.erase(work.begin());
+
+    // deleted by an earlier untangling
+    if (!getNds().count(n)) continue;
+
+    std::vector<OptNode*> touched;
+    if (!(this->*f)(n, &touched)) continue;
+    changed = true;
+
+    // the rules only look at the edges adjacent to the end nodes of a leg,
+    // legs may be anchored at either end node
+    for (auto m : touched) {
+      work.insert(m);
+      for (auto e : m->getAdjList()) {
+        auto o = e->getOtherNd(m);
+        work.insert(o);
+        for (auto oe : o->getAdjList()) work.insert(oe->getOtherNd(o));
+      }
     }
   }
-  return false;
+
+  return changed;
+}
+
+// _____________________________________________________________________________
+bool OptGraph::untangleFullX(OptNode* n, std::vector<OptNode*>* touched) {
+  std::pair<OptEdge*, OptEdge*> cross;
+  if (!(cross = isFullX(n)).first) return false;
+
+  LOGTO(DEBUG, std::cerr) << "Found full cross at node " << n << " between "
+                          << cross.first << "(" << cross.first->pl().toStr()
+                          << ") and " << cross.second << " ("
+                          << cross.second->pl().toStr() << ")";
+
+  auto newN = addNd(util::geo::DPoint(n->pl().getGeom()->getX() + DO,
+                                      n->pl().getGeom()->getY() + DO));
+  newN->pl().node = n->pl().node;
+
+  if (cross.first->getFrom() == n) {
+    addEdg(newN, cross.first->getTo(), cross.first->pl());
+  } else {
+    addEdg(cross.first->getFrom(), newN, cross.first->pl());
+  }
+
+  if (cross.second->getFrom() == n) {
+    addEdg(newN, cross.second->getTo(), cross.second->pl());
+  } else {
+    addEdg(cross.second->getFrom(), newN, cross.second->pl());
+  }
+
+  auto fa = cross.first->getFrom();
+  auto fb = cross.first->getTo();
+  auto sa = cross.second->getFrom();
+  auto sb = cross.second->getTo();
+
+  delEdg(cross.first->getFrom(), cross.first->getTo());
+  delEdg(cross.second->getFrom(), cross.second->getTo());
+
+  *touched = {n, newN, fa, fb, sa, sb};
+  for (auto m : *touched) updateEdgeOrder(m);
+
+  return true;
 }
 
 // _____________________________________________________________________________
@@ -856,74 +1009,67 @@ std::vector<OptNode*> OptGraph::explodeNodeAlong(
 }
 
 // _____________________________________________________________________________
-void OptGraph::untanglePartialY() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() != 1) continue;  // only look at terminus nodes
+bool OptGraph::untanglePartialY() {
+  return untangleLocal(&OptGraph::untanglePartialY);
+}
 
-    // the only outgoing edge
-    OptEdge* ea = na->getAdjList().front();
-    OptNode* nb = ea->getOtherNd(na);
+// _____________________________________________________________________________
+bool OptGraph::untanglePartialY(OptNode* na,
+                                std::vector<OptNode*>* touched) {
+  if (na->getDeg() != 1) return false;  // only look at terminus nodes
 
-    if (isPartialYAt(ea, nb)) {
-      assert(nb->pl().node);
-      assert(na->pl().node);
+  // the only outgoing edge
+  OptEdge* ea = na->getAdjList().front();
+  OptNode* nb = ea->getOtherNd(na);
 
-      LOGTO(DEBUG, std::cerr)
-          << "Found partial Y at node " << nb << " with main leg " << ea << " ("
-          << ea->pl().toStr() << ")";
-      toUntangle.push_back(ea);
-    }
-  }
+  if (!isPartialYAt(ea, nb)) return false;
 
-  for (auto ea : toUntangle) {
-    // the only outgoing edge
-    OptNode* na = ea->getFrom();
-    if (na->getDeg() != 1) na = ea->getTo();
+  assert(nb->pl().node);
+  assert(na->pl().node);
 
-    assert(na->getDeg() == 1);
-    OptNode* nb = ea->getOtherNd(na);
+  LOGTO(DEBUG, std::cerr) << "Found partial Y at node " << nb
+                          << " with main leg " << ea << " ("
+                          << ea->pl().toStr() << ")";
 
-    assert(nb->pl().node);
-    assert(na->pl().node);
+  // the geometry of the main leg
+  util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
+  double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
+  auto ortho = pl.getOrthoLineAtDist(pl.getLength(), bandW);
 
-    // the geometry of the main leg
-    util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
-    double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
-    auto ortho = pl.getOrthoLineAtDist(pl.getLength(), bandW);
+  // each leg, in clockwise fashion
+  auto minLgs = partialClockwEdges(ea, nb);
 
-    // each leg, in clockwise fashion
-    auto minLgs = partialClockwEdges(ea, nb);
+  assert(minLgs.size() <= ea->pl().getCardinality());
 
-    assert(minLgs.size() <= ea->pl().getCardinality());
+  // for each minor leg of the Y, create a new node at the origin
+  std::vector<OptNode*> origNds = explodeNodeAlong(na, ortho, minLgs.size());
 
-    // for each minor leg of the Y, create a new node at the origin
-    std::vector<OptNode*> origNds = explodeNodeAlong(na, ortho, minLgs.size());
-
-    size_t offset = 0;
-    for (size_t i = 0; i < minLgs.size(); i++) {
-      size_t j = i;
-      OptEdgePL pl;
-      if (ea->getFrom() == nb) {
-        if (ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
-        pl = getPartialView(ea, minLgs[j], offset);
-        addEdg(nb, origNds[j], pl);
-      } else {
-        if (!ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
-        pl = getPartialView(ea, minLgs[j], offset);
-        addEdg(origNds[j], nb, pl);
-      }
-      offset += pl.getLines().size();
+  size_t offset = 0;
+  for (size_t i = 0; i < minLgs.size(); i++) {
+    size_t j = i;
+    OptEdgePL pl;
+    if (ea->getFrom() == nb) {
+      if (ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
+      pl = getPartialView(ea, minLgs[j], offset);
+      addEdg(nb, origNds[j], pl);
+    } else {
+      if (!ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
+      pl = getPartialView(ea, minLgs[j], offset);
+      addEdg(origNds[j], nb, pl);
     }
+    offset += pl.getLines().size();
+  }
 
-    // delete remaining stuff
-    delNd(na);
+  // delete remaining stuff
+  delNd(na);
 
-    // update orderings
-    for (auto n : origNds) updateEdgeOrder(n);
-    updateEdgeOrder(nb);
-  }
+  // update orderings
+  for (auto n : origNds) updateEdgeOrder(n);
+  updateEdgeOrder(nb);
+
+  *touched = origNds;
+  touched->push_back(nb);
+  return true;
 }
 
 // _____________________________________________________________________________
@@ -1000,25 +1146,23 @@ std::pair<OptEdge*, bool> OptGraph::isOuterStumpAt(OptEdge* mainLeg,
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleDoubleStump() {
-  std::vector<OptEdge*> toUntangle;
+bool OptGraph::untangleDoubleStump() {
+  return untangleLocal(&OptGraph::untangleDoubleStump);
+}
 
-  for (OptNode* n : getNds()) {
-    for (OptEdge* mainLeg : n->getAdjList()) {
-      if (mainLeg->getFrom() != n) continue;
-
-      const OptLO* stump;
-      if ((stump = isDoubleStump(mainLeg))) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found double stump with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") with stump " << stump->line->id();
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+// _____________________________________________________________________________
+bool OptGraph::untangleDoubleStump(OptNode* n,
+                                   std::vector<OptNode*>* touched) {
+  for (OptEdge* mainLeg : n->getAdjList()) {
+    if (mainLeg->getFrom() != n) continue;
 
-  for (auto mainLeg : toUntangle) {
     const OptLO* stump = isDoubleStump(mainLeg);
+    if (!stump) continue;
+
+    LOGTO(DEBUG, std::cerr)
+        << "Found double stump with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") with stump " << stump->line->id();
+
     OptEdgePL plMain = getPartialViewExcl(mainLeg, stump, 0);
     OptEdgePL plStump =
         getPartialView(mainLeg, stump, plMain.getLines().size());
@@ -1028,37 +1172,34 @@ void OptGraph::untangleDoubleStump() {
     auto stNdA = addNd(mainLeg->getFrom()->pl());
     auto stNdB = addNd(mainLeg->getTo()->pl());
     addEdg(stNdA, stNdB, plStump);
+
+    *touched = {mainLeg->getFrom(), mainLeg->getTo(), stNdA, stNdB};
+    return true;
   }
+
+  return false;
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleOuterStump() {
-  std::set<OptEdge*> toUntangle;
+bool OptGraph::untangleOuterStump() {
+  return untangleLocal(&OptGraph::untangleOuterStump);
+}
 
-  for (OptNode* n : getNds()) {
-    for (OptEdge* mainLeg : n->getAdjList()) {
-      if (mainLeg->getFrom() != n) continue;
-
-      std::pair<OptEdge*, bool> stumpEdgPair;
-      if ((stumpEdgPair = isOuterStump(mainLeg)).first) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found outer stump with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") at node " << stumpEdgPair.second
-            << " with stump " << stumpEdgPair.first << " ("
-            << stumpEdgPair.first->pl().toStr() << ")";
-        assert(mainLeg->getFrom());
-        assert(mainLeg->getTo());
-        toUntangle.insert(mainLeg);
-      }
-    }
-  }
+// _____________________________________________________________________________
+bool OptGraph::untangleOuterStump(OptNode* n,
+                                  std::vector<OptNode*>* touched) {
+  for (OptEdge* mainLeg : n->getAdjList()) {
+    if (mainLeg->getFrom() != n) continue;
 
-  for (auto mainLeg : toUntangle) {
-    auto stumpEdgPair = isOuterStump(mainLeg);
-    // check here again because the main leg may break up if there were
-    // only 2 lines on it in a previous outer stump untangle, this should be
-    // explicitely checked above
+    std::pair<OptEdge*, bool> stumpEdgPair = isOuterStump(mainLeg);
     if (!stumpEdgPair.first) continue;
+
+    LOGTO(DEBUG, std::cerr)
+        << "Found outer stump with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") at node " << stumpEdgPair.second
+        << " with stump " << stumpEdgPair.first << " ("
+        << stumpEdgPair.first->pl().toStr() << ")";
+
     OptEdge* stumpEdg = stumpEdgPair.first;
     bool clockw = stumpEdgPair.second;
     OptNode* stumpN = sharedNode(mainLeg, stumpEdg);
@@ -1140,137 +1281,115 @@ void OptGraph::untangleOuterStump() {
     for (auto e : stumpN->getAdjList()) {
       if (e == stumpEdg || e == mainLeg) continue;
 
-      OptEdge* newE = 0;
-
       if (e->getFrom() == stumpN)
-        newE = addEdg(stumpNds[mainLegNode], e->getTo(), e->pl());
+        addEdg(stumpNds[mainLegNode], e->getTo(), e->pl());
       else
-        newE = addEdg(e->getFrom(), stumpNds[mainLegNode], e->pl());
-
-      // Important: the untangling rule assumes that if the node of the main
-      // leg are split, the original node is kept. This is not the case in this
-      // implementation - the original node is deleted, and a new split node
-      // is inserted. But the original node may have *another* dangling outer
-      // stump split in the toUntangle list, which we must replace here
-      if (toUntangle.count(e)) {
-        toUntangle.erase(e);
-        toUntangle.insert(newE);
-      }
+        addEdg(e->getFrom(), stumpNds[mainLegNode], e->pl());
     }
 
     for (auto e : notStumpN->getAdjList()) {
       if (e == mainLeg) continue;
 
-      OptEdge* newE = 0;
-
       if (e->getFrom() == notStumpN)
-        newE = addEdg(notStumpNds[mainLegNode], e->getTo(), e->pl());
+        addEdg(notStumpNds[mainLegNode], e->getTo(), e->pl());
       else
-        newE = addEdg(e->getFrom(), notStumpNds[mainLegNode], e->pl());
-
-      // see above
-      if (toUntangle.count(e)) {
-        toUntangle.erase(e);
-        toUntangle.insert(newE);
-      }
+        addEdg(e->getFrom(), notStumpNds[mainLegNode], e->pl());
     }
 
     delNd(stumpN);
     delNd(notStumpN);
 
     // update orderings
-    for (auto n : stumpNds) {
-      updateEdgeOrder(n);
-      for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
+    for (auto nd : stumpNds) {
+      updateEdgeOrder(nd);
+      for (auto e : nd->getAdjList()) updateEdgeOrder(e->getOtherNd(nd));
     }
-    for (auto n : notStumpNds) {
-      updateEdgeOrder(n);
-      for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
+    for (auto nd : notStumpNds) {
+      updateEdgeOrder(nd);
+      for (auto e : nd->getAdjList()) updateEdgeOrder(e->getOtherNd(nd));
     }
+
+    *touched = stumpNds;
+    touched->insert(touched->end(), notStumpNds.begin(), notStumpNds.end());
+    return true;
   }
+
+  return false;
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleY() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() != 1) continue;  // only look at terminus nodes
-
-    // the only outgoing edge
-    OptEdge* ea = na->getAdjList().front();
-    OptNode* nb = ea->getOtherNd(na);
+bool OptGraph::untangleY() { return untangleLocal(&OptGraph::untangleY); }
 
-    if (isYAt(ea, nb)) {
-      assert(nb->pl().node);
-      assert(na->pl().node);
-      LOGTO(DEBUG, std::cerr)
-          << "Found full Y at node " << nb << " with main leg " << ea << " ("
-          << ea->pl().toStr() << ")";
-      toUntangle.push_back(ea);
-    }
-  }
+// _____________________________________________________________________________
+bool OptGraph::untangleY(OptNode* na, std::vector<OptNode*>* touched) {
+  if (na->getDeg() != 1) return false;  // only look at terminus nodes
 
-  for (auto ea : toUntangle) {
-    // the only outgoing edge
-    OptNode* na = ea->getFrom();
-    if (na->getDeg() != 1) na = ea->getTo();
+  // the only outgoing edge
+  OptEdge* ea = na->getAdjList().front();
+  OptNode* nb = ea->getOtherNd(na);
 
-    assert(na->getDeg() == 1);
-    OptNode* nb = ea->getOtherNd(na);
+  if (!isYAt(ea, nb)) return false;
 
-    // the geometry of the main leg
-    util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
-    double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
-    auto orthoPl = pl.getOrthoLineAtDist(0, bandW);
-    auto orthoPlOrig = pl.getOrthoLineAtDist(pl.getLength(), bandW);
+  assert(nb->pl().node);
+  assert(na->pl().node);
+  LOGTO(DEBUG, std::cerr) << "Found full Y at node " << nb << " with main leg "
+                          << ea << " (" << ea->pl().toStr() << ")";
 
-    // for each minor leg of the stump, create a new node at the origin
-    std::vector<OptNode*> centerNds =
-        explodeNodeAlong(nb, orthoPl, nb->getDeg() - 1);
-    std::vector<OptNode*> origNds =
-        explodeNodeAlong(na, orthoPlOrig, nb->getDeg() - 1);
+  // the geometry of the main leg
+  util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
+  double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
+  auto orthoPl = pl.getOrthoLineAtDist(0, bandW);
+  auto orthoPlOrig = pl.getOrthoLineAtDist(pl.getLength(), bandW);
 
-    // each leg, in clockwise fashion
-    auto minLgs = clockwEdges(ea, nb);
-    std::vector<OptEdge*> minLgsN(minLgs.size());
-    assert(minLgs.size() == nb->pl().circOrdering.size() - 1);
+  // for each minor leg of the stump, create a new node at the origin
+  std::vector<OptNode*> centerNds =
+      explodeNodeAlong(nb, orthoPl, nb->getDeg() - 1);
+  std::vector<OptNode*> origNds =
+      explodeNodeAlong(na, orthoPlOrig, nb->getDeg() - 1);
 
-    for (size_t i = 0; i < minLgs.size(); i++) {
-      if (minLgs[i]->getFrom() == nb)
-        minLgsN[i] = addEdg(centerNds[i], minLgs[i]->getTo(), minLgs[i]->pl());
-      else
-        minLgsN[i] =
-            addEdg(minLgs[i]->getFrom(), centerNds[i], minLgs[i]->pl());
-    }
+  // each leg, in clockwise fashion
+  auto minLgs = clockwEdges(ea, nb);
+  std::vector<OptEdge*> minLgsN(minLgs.size());
+  assert(minLgs.size() == nb->pl().circOrdering.size() - 1);
 
-    size_t offset = 0;
-    for (size_t i = 0; i < minLgs.size(); i++) {
-      size_t j = i;
-      OptEdgePL pl;
-      if (ea->getFrom() == nb) {
-        if (ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
-        pl = getView(ea, minLgs[j], offset);
-        addEdg(centerNds[j], origNds[j], pl);
-      } else {
-        if (!ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
-        pl = getView(ea, minLgs[j], offset);
-        addEdg(origNds[j], centerNds[j], pl);
-      }
-      offset += pl.getLines().size();
+  for (size_t i = 0; i < minLgs.size(); i++) {
+    if (minLgs[i]->getFrom() == nb)
+      minLgsN[i] = addEdg(centerNds[i], minLgs[i]->getTo(), minLgs[i]->pl());
+    else
+      minLgsN[i] =
+          addEdg(minLgs[i]->getFrom(), centerNds[i], minLgs[i]->pl());
+  }
+
+  size_t offset = 0;
+  for (size_t i = 0; i < minLgs.size(); i++) {
+    size_t j = i;
+    OptEdgePL pl;
+    if (ea->getFrom() == nb) {
+      if (ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
+      pl = getView(ea, minLgs[j], offset);
+      addEdg(centerNds[j], origNds[j], pl);
+    } else {
+      if (!ea->pl().lnEdgParts[0].dir) j = minLgs.size() - 1 - i;
+      pl = getView(ea, minLgs[j], offset);
+      addEdg(origNds[j], centerNds[j], pl);
     }
+    offset += pl.getLines().size();
+  }
 
-    // delete remaining stuff
-    delNd(nb);
-    delNd(na);
+  // delete remaining stuff
+  delNd(nb);
+  delNd(na);
 
-    // update orderings
-    for (auto n : origNds) updateEdgeOrder(n);  // TODO: is this redundant?
-    for (auto n : centerNds) {
-      updateEdgeOrder(n);
-      for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
-    }
+  // update orderings
+  for (auto n : origNds) updateEdgeOrder(n);  // TODO: is this redundant?
+  for (auto n : centerNds) {
+    updateEdgeOrder(n);
+    for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
   }
+
+  *touched = centerNds;
+  touched->insert(touched->end(), origNds.begin(), origNds.end());
+  return true;
 }
 
 // _____________________________________________________________________________
@@ -1403,27 +1522,25 @@ OptEdgePL OptGraph::getPartialView(OptEdge* parent, OptEdge* leg,
 }
 
 // _____________________________________________________________________________
-void OptGraph::untanglePartialDogBone() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() < 3) continue;  // only look at nodes with deg > 2
+bool OptGraph::untanglePartialDogBone() {
+  return untangleLocal(&OptGraph::untanglePartialDogBone);
+}
 
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      OptNode* notPartN = 0;
-      if ((notPartN = isPartialDogBone(mainLeg))) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found partial dog bone with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") at node " << notPartN;
+// _____________________________________________________________________________
+bool OptGraph::untanglePartialDogBone(OptNode* na,
+                                      std::vector<OptNode*>* touched) {
+  if (na->getDeg() < 3) return false;  // only look at nodes with deg > 2
 
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+  for (OptEdge* mainLeg : na->getAdjList()) {
+    if (mainLeg->getFrom() != na) continue;
 
-  for (auto mainLeg : toUntangle) {
     OptNode* notPartN = isPartialDogBone(mainLeg);
+    if (!notPartN) continue;
+
+    LOGTO(DEBUG, std::cerr)
+        << "Found partial dog bone with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") at node " << notPartN;
+
     OptNode* partN = mainLeg->getOtherNd(notPartN);
 
     // the geometry of the main leg
@@ -1490,27 +1607,30 @@ void OptGraph::untanglePartialDogBone() {
       for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
     }
     updateEdgeOrder(notPartN);
+
+    *touched = partNds;
+    touched->push_back(notPartN);
+    return true;
   }
+
+  return false;
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleInnerStump() {
-  std::vector<OptEdge*> toUntangle;
+bool OptGraph::untangleInnerStump() {
+  return untangleLocal(&OptGraph::untangleInnerStump);
+}
 
-  for (OptNode* na : getNds()) {
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      if (isInnerStump(mainLeg)) {
-        LOGTO(DEBUG, std::cerr) << "Found inner stump with main leg " << mainLeg
-                                << " (" << mainLeg->pl().toStr() << ")";
+// _____________________________________________________________________________
+bool OptGraph::untangleInnerStump(OptNode* na,
+                                  std::vector<OptNode*>* touched) {
+  for (OptEdge* mainLeg : na->getAdjList()) {
+    if (mainLeg->getFrom() != na) continue;
+    if (!isInnerStump(mainLeg)) continue;
 
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+    LOGTO(DEBUG, std::cerr) << "Found inner stump with main leg " << mainLeg
+                            << " (" << mainLeg->pl().toStr() << ")";
 
-  for (auto mainLeg : toUntangle) {
-    auto na = mainLeg->getFrom();
     OptNode* nb = mainLeg->getOtherNd(na);
 
     std::vector<OptNode*> dummies;
@@ -1530,6 +1650,8 @@ void OptGraph::untangleInnerStump() {
         auto dummyEdge = addEdg(nb, dummyNode);
         for (auto roOld : a->pl().getLines()) {
           dummyEdge->pl().lines.push_back(OptLO(roOld.line, 0));
+          // keep the multiplicity of collapsed lines
+          dummyEdge->pl().lines.back().relatives = roOld.relatives;
         }
         dummyEdge->pl().lnEdgParts.push_back({0, 0, 0, 0});
 
@@ -1553,6 +1675,8 @@ void OptGraph::untangleInnerStump() {
         auto dummyEdge = addEdg(na, dummyNode);
         for (auto roOld : a->pl().getLines()) {
           dummyEdge->pl().lines.push_back(OptLO(roOld.line, 0));
+          // keep the multiplicity of collapsed lines
+          dummyEdge->pl().lines.back().relatives = roOld.relatives;
         }
         dummyEdge->pl().lnEdgParts.push_back({0, 0, 0, 0});
         na->pl().circOrdering.insert(na->pl().circOrdering.end() - i,
@@ -1651,28 +1775,29 @@ void OptGraph::untangleInnerStump() {
       updateEdgeOrder(n);
       for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
     }
+
+    *touched = aNds;
+    touched->insert(touched->end(), bNds.begin(), bNds.end());
+    return true;
   }
+
+  return false;
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleDogBone() {
-  std::vector<OptEdge*> toUntangle;
+bool OptGraph::untangleDogBone() {
+  return untangleLocal(&OptGraph::untangleDogBone);
+}
 
-  for (OptNode* na : getNds()) {
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      if (isDogBone(mainLeg)) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found full dog bone with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ")";
+// _____________________________________________________________________________
+bool OptGraph::untangleDogBone(OptNode* na, std::vector<OptNode*>* touched) {
+  for (OptEdge* mainLeg : na->getAdjList()) {
+    if (mainLeg->getFrom() != na) continue;
+    if (!isDogBone(mainLeg)) continue;
 
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+    LOGTO(DEBUG, std::cerr) << "Found full dog bone with main leg " << mainLeg
+                            << " (" << mainLeg->pl().toStr() << ")";
 
-  for (auto mainLeg : toUntangle) {
-    auto na = mainLeg->getFrom();
     OptNode* nb = mainLeg->getOtherNd(na);
     // the geometry of the main leg
     util::geo::PolyLine<double> pl(*na->pl().getGeom(), *nb->pl().getGeom());
@@ -1761,7 +1886,13 @@ void OptGraph::untangleDogBone() {
       updateEdgeOrder(n);
       for (auto e : n->getAdjList()) updateEdgeOrder(e->getOtherNd(n));
     }
+
+    *touched = aNds;
+    touched->insert(touched->end(), bNds.begin(), bNds.end());
+    return true;
   }
+
+  return false;
 }
 
 // _____________________________________________________________________________
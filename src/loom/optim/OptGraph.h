@@ -5,8 +5,13 @@
 #ifndef LOOM_GRAPH_OPTIM_OPTGRAPH_H_
 #define LOOM_GRAPH_OPTIM_OPTGRAPH_H_
 
+#include <cassert>
+#include <cstdint>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "shared/linegraph/LineGraph.h"
 #include "shared/rendergraph/RenderGraph.h"
@@ -25,10 +30,6 @@ class OptGraphScorer;
 typedef util::graph::Node<OptNodePL, OptEdgePL> OptNode;
 typedef util::graph::Edge<OptNodePL, OptEdgePL> OptEdge;
 
-typedef std::map<const loom::optim::OptEdge*,
-                 std::vector<const shared::linegraph::Line*>>
-    OptOrderCfg;
-
 struct OptLO {
   OptLO() : line(0), dir(0) {}
   OptLO(const shared::linegraph::Line* r,
@@ -130,6 +131,57 @@ struct OptNodePL {
   std::map<OptEdge*, size_t> circOrderMap;
 };
 
+// Line orderings of all edges of an optimization (sub)graph. The edges are
+// numbered densely, and the ordering of each edge is stored as a permutation
+// of the edge's line occurrences (indices into OptEdgePL::getLines()) in a
+// single contiguous arena. Copying a configuration is thus a plain copy of
+// two flat arrays, and looking up an edge's ordering is array indexing.
+class OptOrderCfg {
+ public:
+  OptOrderCfg() {}
+
+  // Number the edges of g, all orderings are initially the identity
+  explicit OptOrderCfg(const std::set<OptNode*>& g);
+
+  size_t size() const { return _edges.size(); }
+  const OptEdge* getEdge(size_t id) const { return _edges[id]; }
+
+  bool has(const OptEdge* e) const { return _ids && _ids->count(e); }
+
+  size_t getId(const OptEdge* e) const {
+    assert(has(e));
+    return _ids->find(e)->second;
+  }
+
+  size_t card(size_t id) const { return _offsets[id + 1] - _offsets[id]; }
+
+  uint16_t* perm(size_t id) { return _perms.data() + _offsets[id]; }
+  const uint16_t* perm(size_t id) const { return _perms.data() + _offsets[id]; }
+
+  uint16_t* perm(const OptEdge* e) { return perm(getId(e)); }
+  const uint16_t* perm(const OptEdge* e) const { return perm(getId(e)); }
+
+  // the line at position p of e
+  const shared::linegraph::Line* lineAt(const OptEdge* e, size_t p) const {
+    return e->pl().getLines()[perm(e)[p]].line;
+  }
+
+  bool operator==(const OptOrderCfg& o) const {
+    return _edges == o._edges && _perms == o._perms;
+  }
+  bool operator!=(const OptOrderCfg& o) const { return !(*this == o); }
+
+ private:
+  std::vector<const OptEdge*> _edges;
+
+  // edge -> dense id, never changed after construction and thus shared
+  // between copies
+  std::shared_ptr<const std::unordered_map<const OptEdge*, size_t>> _ids;
+
+  std::vector<size_t> _offsets;
+  std::vector<uint16_t> _perms;
+};
+
 class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
  public:
   OptGraph(const OptGraphScorer* scorer) : _scorer(scorer){};
@@ -146,9 +198,10 @@ class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
   double getMaxCrossPen() const;
   double getMaxSplitPen() const;
 
-  void contractDeg2Nds();
-  void untangle();
-  void partnerLines();
+  // apply the simplification rules, true if the graph was changed
+  bool contractDeg2Nds();
+  bool untangle();
+  bool partnerLines();
 
   std::vector<PartnerPath> getPartnerLines() const;
   PartnerPath pathFromComp(const std::set<OptNode*>& comp) const;
@@ -179,24 +232,42 @@ class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
 
 
   // apply splitting rules
-  void splitSingleLineEdgs();
-  void terminusDetach();
+  bool splitSingleLineEdgs();
+  bool terminusDetach();
 
  private:
   const OptGraphScorer* _scorer;
   void writeEdgeOrder();
   void updateEdgeOrder(OptNode* n);
-  bool contractDeg2Step();
+
+  // contract n if possible, returns the end nodes of the contracted edge
+  std::pair<OptNode*, OptNode*> contractDeg2(OptNode* n);
 
   bool untangleFullX();
-  void untangleY();
-  void untanglePartialY();
-  void untangleDogBone();
-  void untanglePartialDogBone();
-
-  void untangleOuterStump();
-  void untangleInnerStump();
-  void untangleDoubleStump();
+  // untangle a full cross at n, touched are the nodes whose edges changed
+  bool untangleFullX(OptNode* n, std::vector<OptNode*>* touched);
+
+  // apply the rule f at all nodes until it applies nowhere anymore. f returns
+  // the nodes whose edges changed in touched, only their surroundings are
+  // checked again
+  bool untangleLocal(bool (OptGraph::*f)(OptNode*, std::vector<OptNode*>*));
+
+  // the rules below untangle at most one leg at the given node
+  bool untangleY();
+  bool untangleY(OptNode* n, std::vector<OptNode*>* touched);
+  bool untanglePartialY();
+  bool untanglePartialY(OptNode* n, std::vector<OptNode*>* touched);
+  bool untangleDogBone();
+  bool untangleDogBone(OptNode* n, std::vector<OptNode*>* touched);
+  bool untanglePartialDogBone();
+  bool untanglePartialDogBone(OptNode* n, std::vector<OptNode*>* touched);
+
+  bool untangleOuterStump();
+  bool untangleOuterStump(OptNode* n, std::vector<OptNode*>* touched);
+  bool untangleInnerStump();
+  bool untangleInnerStump(OptNode* n, std::vector<OptNode*>* touched);
+  bool untangleDoubleStump();
+  bool untangleDoubleStump(OptNode* n, std::vector<OptNode*>* touched);
 
   std::vector<OptNode*> explodeNodeAlong(OptNode* nd,
                                          const util::geo::PolyLine<double>& pl,
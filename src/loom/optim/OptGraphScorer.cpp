@@ -2,7 +2,9 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
-#include <map>
+#include <algorithm>
+#include <limits>
+#include <vector>
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
 #include "loom/optim/Optimizer.h"
@@ -14,6 +16,23 @@ using shared::linegraph::Line;
 using shared::linegraph::LineEdge;
 using shared::linegraph::LineNode;
 
+// _____________________________________________________________________________
+static size_t inversions(const std::vector<size_t>& order,
+                         const std::vector<size_t>& mult) {
+  // a collapsed line with multiplicity m stands for m lines, so an inversion
+  // of two collapsed lines accounts for the product of their multiplicities
+  if (std::all_of(mult.begin(), mult.end(), [](size_t m) { return m == 1; }))
+    return util::inversions(order);
+
+  size_t ret = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    for (size_t j = i + 1; j < order.size(); j++) {
+      if (order[i] > order[j]) ret += mult[i] * mult[j];
+    }
+  }
+  return ret;
+}
+
 // _____________________________________________________________________________
 std::pair<size_t, size_t> OptGraphScorer::getNumCrossings(
     const OptGraph* g, const OptOrderCfg& c) const {
@@ -181,34 +200,29 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
 // _____________________________________________________________________________
 size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
                                           const OptOrderCfg& c) const {
-  std::map<const Line*, size_t> ordering;
-
   bool revA = (ea->getFrom() != n) ^ ea->pl().lnEdgParts.front().dir;
 
-  const auto& cea = c.at(ea);
+  const auto& linesA = ea->pl().getLines();
+  const auto* cea = c.perm(ea);
+
+  // position of each line occurrence of ea
+  std::vector<size_t> ordering(linesA.size());
 
-  for (size_t i = 0; i < cea.size(); i++) {
-    const auto& l = cea[i];
-    ordering[l] = revA ? cea.size() - 1 - i : i;
+  for (size_t i = 0; i < linesA.size(); i++) {
+    ordering[cea[i]] = revA ? linesA.size() - 1 - i : i;
   }
 
-  std::vector<size_t> relOrderCross;
+  std::vector<size_t> relOrderCross, mult;
 
   for (const auto& eb : OptGraph::clockwEdges(ea, n)) {
-    const auto& ceb = c.at(eb);
+    const auto& linesB = eb->pl().getLines();
+    const auto* ceb = c.perm(eb);
     bool revB = (eb->getFrom() != n) ^ eb->pl().lnEdgParts.front().dir;
 
-    for (size_t i = 0; i < ceb.size(); i++) {
-      const auto& thisLine = ceb[!revB ? ceb.size() - 1 - i : i];
-
-      auto otherIt = ordering.find(thisLine);
-      if (otherIt == ordering.end()) continue;
-
-      const auto* eaLo = ea->pl().getLineOcc(otherIt->first);
-      const auto* ebLo = eb->pl().getLineOcc(thisLine);
-
-      assert(eaLo);
-      assert(ebLo);
+    for (size_t i = 0; i < linesB.size(); i++) {
+      const auto* ebLo = &linesB[ceb[!revB ? linesB.size() - 1 - i : i]];
+      const auto* eaLo = ea->pl().getLineOcc(ebLo->line);
+      if (!eaLo) continue;
 
       if ((eaLo->dir == 0 || ebLo->dir == 0 ||
            (eaLo->dir == n->pl().node && ebLo->dir != n->pl().node) ||
@@ -216,12 +230,13 @@ size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
           (n->pl().node->pl().connOccurs(eaLo->line, OptGraph::getAdjEdg(ea, n),
                                          OptGraph::getAdjEdg(eb, n)))) {
         // connection occurs, consider for crossings
-        relOrderCross.push_back(otherIt->second);
+        relOrderCross.push_back(ordering[eaLo - &linesA[0]]);
+        mult.push_back(eaLo->relatives.size());
       }
     }
   }
 
-  return util::inversions(relOrderCross);
+  return inversions(relOrderCross, mult);
 }
 
 // _____________________________________________________________________________
@@ -229,46 +244,44 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     OptNode* n, OptEdge* ea, OptEdge* eb, const OptOrderCfg& c) const {
   std::pair<std::pair<size_t, size_t>, size_t> ret{{0, 0}, 0};
 
-  std::map<const Line*, size_t> ordering;
-
   bool revA = (ea->getFrom() != n) ^ ea->pl().lnEdgParts.front().dir;
   bool revB = (eb->getFrom() != n) ^ eb->pl().lnEdgParts.front().dir;
 
   bool rev = !(revA ^ revB);
 
-  const auto& cea = c.at(ea);
-  const auto& ceb = c.at(eb);
+  const auto& linesA = ea->pl().getLines();
+  const auto& linesB = eb->pl().getLines();
+  const auto* cea = c.perm(ea);
+  const auto* ceb = c.perm(eb);
 
-  for (size_t i = 0; i < cea.size(); i++) {
-    ordering[cea[i]] = rev ? cea.size() - 1 - i : i;
+  // position of each line occurrence of ea
+  std::vector<size_t> ordering(linesA.size());
+
+  for (size_t i = 0; i < linesA.size(); i++) {
+    ordering[cea[i]] = rev ? linesA.size() - 1 - i : i;
   }
 
-  std::vector<size_t> relOrderCross, relOrderSep;
+  std::vector<size_t> relOrderCross, relOrderSep, mult;
 
-  for (size_t i = 0; i < ceb.size(); i++) {
-    const auto& thisLine = ceb[i];
+  for (size_t i = 0; i < linesB.size(); i++) {
+    const auto* ebLo = &linesB[ceb[i]];
+    const auto* eaLo = ea->pl().getLineOcc(ebLo->line);
 
-    auto otherIt = ordering.find(thisLine);
-    if (otherIt == ordering.end()) {
+    if (!eaLo) {
       // insert a placeholder for separations, otherwise ignore
       relOrderSep.push_back(std::numeric_limits<size_t>::max());
       continue;
     }
 
-    const auto* eaLo = ea->pl().getLineOcc(otherIt->first);
-    const auto* ebLo = eb->pl().getLineOcc(thisLine);
-
-    assert(eaLo);
-    assert(ebLo);
-
     if ((eaLo->dir == 0 || ebLo->dir == 0 ||
          (eaLo->dir == n->pl().node && ebLo->dir != n->pl().node) ||
          (eaLo->dir != n->pl().node && ebLo->dir == n->pl().node)) &&
         (n->pl().node->pl().connOccurs(eaLo->line, OptGraph::getAdjEdg(ea, n),
                                        OptGraph::getAdjEdg(eb, n)))) {
       // connection occurs, consider for crossings
-      relOrderCross.push_back(otherIt->second);
-      relOrderSep.push_back(otherIt->second);
+      relOrderCross.push_back(ordering[eaLo - &linesA[0]]);
+      relOrderSep.push_back(ordering[eaLo - &linesA[0]]);
+      mult.push_back(eaLo->relatives.size());
     } else {
       // otherwise insert a placeholder
       relOrderSep.push_back(std::numeric_limits<size_t>::max());
@@ -290,7 +303,7 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     }
   }
 
-  ret.first.first = util::inversions(relOrderCross);
+  ret.first.first = inversions(relOrderCross, mult);
   ret.second = seps;
 
   return ret;
@@ -2,18 +2,35 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <exception>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
+#include "loom/optim/CompCache.h"
+#include "loom/optim/DeltaScorer.h"
+#include "loom/optim/GreedyOptimizer.h"
 #include "loom/optim/NullOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
 #include "loom/optim/Optimizer.h"
+#include "loom/optim/Tracer.h"
 #include "util/Misc.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Algorithm.h"
 #include "util/log/Log.h"
 
+using loom::optim::CompJob;
+using loom::optim::CompRace;
+using loom::optim::CompStats;
 using loom::optim::EdgePair;
+using loom::optim::GreedyOptimizer;
 using loom::optim::LinePair;
 using loom::optim::NullOptimizer;
 using loom::optim::OptEdge;
@@ -24,6 +41,7 @@ using loom::optim::OptNode;
 using loom::optim::OptOrderCfg;
 using loom::optim::OptResStats;
 using loom::optim::PosComPair;
+using loom::optim::TraceSpan;
 using shared::linegraph::Line;
 using shared::linegraph::LineNode;
 using shared::rendergraph::HierarOrderCfg;
@@ -34,11 +52,32 @@ using util::factorial;
 using util::geo::DLine;
 using util::geo::DPoint;
 
+// the time budget of the component job run by this thread
+static thread_local const CompRace* curJobBudget = 0;
+
+// every job gets at least this fraction of an equal split of the time left
+static const double MIN_JOB_SHARE = 0.1;
+
+// number of threads running besides the ones which started an optimization,
+// shared by all optimizers so that nested parallelism stays within the
+// configured number of threads
+static std::atomic<size_t> extraThrds(0);
+
 // _____________________________________________________________________________
 OptResStats Optimizer::optimize(RenderGraph* rg) const {
+  // the time budget starts to run before the graph is simplified
+  CompRace budget;
+  budget.solved = false;
+  budget.hasDeadline = _cfg->timeBudgetMs >= 0;
+  budget.deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(std::max(0, _cfg->timeBudgetMs));
+
   // create optim graph
   OptGraph g(&_scorer);
-  g.build(rg);
+  {
+    TraceSpan span("build", "build");
+    g.build(rg);
+  }
 
   OptResStats optResStats;
 
@@ -65,17 +104,29 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   optResStats.solutionSpaceSizeOrig = solSp;
   optResStats.maxLineCardOrig = maxC;
 
+  auto rule = [&g](const std::string& name, bool (OptGraph::*f)()) {
+    TraceSpan span("simplify", name);
+    bool changed = (g.*f)();
+    span.arg("changed", changed);
+    return changed;
+  };
+
   if (_cfg->untangleGraph) {
     T_START(1);
     // do full untangling
     LOGTO(DEBUG, std::cerr) << "Untangling graph...";
-    g.partnerLines();
-
-    for (size_t i = 0; i <= maxC + 1; i++) {
-      g.untangle();
-      g.contractDeg2Nds();
-      g.splitSingleLineEdgs();
-      g.terminusDetach();
+    rule("partner-lines", &OptGraph::partnerLines);
+
+    // each pass may enable further rules, stop once a pass changes nothing
+    while (true) {
+      bool changed = g.untangle();
+      // untangling cuts lines into pieces, which may now be interchangeable
+      changed |= rule("partner-lines", &OptGraph::partnerLines);
+      changed |= rule("contract-deg2-nodes", &OptGraph::contractDeg2Nds);
+      changed |=
+          rule("split-single-line-edges", &OptGraph::splitSingleLineEdgs);
+      changed |= rule("terminus-detach", &OptGraph::terminusDetach);
+      if (!changed) break;
     }
 
     optResStats.simplificationTime = T_STOP(1);
@@ -86,12 +137,12 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
     // only apply core graph rules
     T_START(1);
     LOGTO(DEBUG, std::cerr) << "Creating core optimization graph...";
-    g.partnerLines();
+    rule("partner-lines", &OptGraph::partnerLines);
     // not necessary here, but avoids an excessive number of single edges...
-    g.contractDeg2Nds();
-    g.splitSingleLineEdgs();
-    g.terminusDetach();
-    g.contractDeg2Nds();
+    rule("contract-deg2-nodes", &OptGraph::contractDeg2Nds);
+    rule("split-single-line-edges", &OptGraph::splitSingleLineEdgs);
+    rule("terminus-detach", &OptGraph::terminusDetach);
+    rule("contract-deg2-nodes", &OptGraph::contractDeg2Nds);
 
     optResStats.simplificationTime = T_STOP(1);
 
@@ -108,7 +159,12 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   }
 
   // iterate over components and optimize all of them separately
-  const auto& comps = util::graph::Algorithm::connectedComponents(g);
+  std::vector<std::set<OptNode*>> comps;
+  {
+    TraceSpan span("partition", "components");
+    comps = util::graph::Algorithm::connectedComponents(g);
+    span.arg("num_comps", comps.size());
+  }
 
   optResStats.numNodes = g.getNumNodes();
   optResStats.numEdges = g.getNumEdges();
@@ -147,10 +203,108 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   double crossSumDiff = 0;
   double sepSum = 0;
 
-  // for trivial cases
-  const NullOptimizer nullOpt(_cfg, _scorer.getPens());
+  double maxCompSolSpace = 0;
+  size_t maxCompC = 0;
+  size_t maxNumNodes = 0;
+  size_t maxNumEdges = 0;
+  size_t numM1Comps = 0;
+
+  std::vector<double> compSolSp(comps.size());
+
+  for (size_t i = 0; i < comps.size(); i++) {
+    const auto& nds = comps[i];
+    compSolSp[i] = solutionSpaceSize(nds);
+
+    if (_cfg->outputStats) {
+      size_t maxC = maxCard(nds);
+      double solSp = compSolSp[i];
+
+      // skip trivial components
+      if (nds.size() > 2) {
+        if (maxC > maxCompC) maxCompC = maxC;
+        if (solSp > maxCompSolSpace) maxCompSolSpace = solSp;
+        if (solSp == 1) numM1Comps++;
+        if (nds.size() > maxNumNodes) maxNumNodes = nds.size();
+        if (numEdges(nds) > maxNumEdges) maxNumEdges = numEdges(nds);
+
+        LOGTO(INFO, std::cerr)
+            << " (stats) Optimizing subgraph of size " << nds.size()
+            << " with max cardinality = " << maxC
+            << " and solution space size = " << solSp;
+      }
+    }
+  }
+
+  optResStats.nonTrivialComponents = nonTrivialComponents;
+  optResStats.numCompsSolSpaceOne = numM1Comps;
+  optResStats.maxNumNodesPerComp = maxNumNodes;
+  optResStats.maxNumEdgesPerComp = maxNumEdges;
+  optResStats.maxCardPerComp = maxCompC;
+  optResStats.maxCompSolSpace = maxCompSolSpace;
+  optResStats.maxNumRowsPerComp = 0;
+  optResStats.maxNumColsPerComp = 0;
+  optResStats.gap = -1;
+
+  if (_cfg->outputStats) {
+    LOGTO(INFO, std::cerr) << "(stats) Number of nontrivial components: "
+                           << optResStats.nonTrivialComponents;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Number of nontrivial components with sol space size 1: "
+        << optResStats.numCompsSolSpaceOne;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max number of nodes of all nontrivial components: "
+        << optResStats.maxNumNodesPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max number of edges of all nontrivial components: "
+        << optResStats.maxNumEdgesPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max cardinality of all nontrivial components: "
+        << optResStats.maxCardPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max solution space size of all nontrivial components: "
+        << optResStats.maxCompSolSpace;
+  }
+
+  // every (run, component) pair is an independent job which writes into its
+  // own order config shard
+  std::vector<CompJob> jobs;
+  for (size_t run = 0; run < runs; run++) {
+    for (size_t i = 0; i < comps.size(); i++) {
+      jobs.push_back({run, i, compSolSp[i]});
+    }
+  }
+
+  // largest solution space first, so that the expensive components don't end
+  // up as the tail of the schedule
+  std::stable_sort(jobs.begin(), jobs.end(),
+                   [](const CompJob& a, const CompJob& b) {
+                     return a.solSp > b.solSp;
+                   });
+
+  std::vector<HierarOrderCfg> shards(jobs.size());
+  std::vector<double> times(jobs.size(), 0);
+  std::vector<OptResStats> jobStats(jobs.size(), optResStats);
+
+  CompCache cache(_cfg->optimCacheDir, getName(), &_scorer);
+
+  runJobs(&g, comps, maxC, jobs, budget.hasDeadline ? &budget : 0,
+          _cfg->optimCacheDir.empty() ? 0 : &cache, &shards, &times, &jobStats);
+
+  for (const auto& s : jobStats) {
+    if (s.maxNumRowsPerComp > optResStats.maxNumRowsPerComp)
+      optResStats.maxNumRowsPerComp = s.maxNumRowsPerComp;
+    if (s.maxNumColsPerComp > optResStats.maxNumColsPerComp)
+      optResStats.maxNumColsPerComp = s.maxNumColsPerComp;
+  }
+
+  // index of the job for (run, component)
+  std::vector<size_t> jobIdx(jobs.size());
+  for (size_t i = 0; i < jobs.size(); i++) {
+    jobIdx[jobs[i].run * comps.size() + jobs[i].comp] = i;
+  }
 
   double bestScore = std::numeric_limits<double>::infinity();
+  size_t bestRun = 0;
   OrderCfg bestCfg;
 
   for (size_t run = 0; run < runs; run++) {
@@ -158,72 +312,20 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
     HierarOrderCfg hc;
 
     double t = 0;
-    double maxCompSolSpace = 0;
-    size_t maxCompC = 0;
-    size_t maxNumNodes = 0;
-    size_t maxNumEdges = 0;
-    size_t numM1Comps = 0;
-
-    optResStats.maxNumRowsPerComp = 0;
-    optResStats.maxNumColsPerComp = 0;
-
-    for (const auto& nds : comps) {
-      if (_cfg->outputStats) {
-        size_t maxC = maxCard(nds);
-        double solSp = solutionSpaceSize(nds);
-
-        // skip trivial components
-        if (nds.size() > 2) {
-          if (maxC > maxCompC) maxCompC = maxC;
-          if (solSp > maxCompSolSpace) maxCompSolSpace = solSp;
-          if (solSp == 1) numM1Comps++;
-          if (nds.size() > maxNumNodes) maxNumNodes = nds.size();
-          if (numEdges(nds) > maxNumEdges) maxNumEdges = numEdges(nds);
-
-          LOGTO(INFO, std::cerr)
-              << " (stats) Optimizing subgraph of size " << nds.size()
-              << " with max cardinality = " << maxC
-              << " and solution space size = " << solSp;
-        }
-      }
 
-      // this is the implementation of the single edge pruning described in the
-      // publication - simple skip such components
-      // we also skip components with only single edges
-      if (maxC > 1 && nds.size() > 2) {
-        t += optimizeComp(&g, nds, &hc, optResStats);
-      } else {
-        t += nullOpt.optimizeComp(&g, nds, &hc, 0, optResStats);
+    // merge the shards in component order, independent of the order in which
+    // the jobs were finished
+    for (size_t i = 0; i < comps.size(); i++) {
+      size_t j = jobIdx[run * comps.size() + i];
+      t += times[j];
+      for (const auto& e : shards[j]) {
+        for (const auto& o : e.second) {
+          auto& dst = hc[e.first][o.first];
+          dst.insert(dst.end(), o.second.begin(), o.second.end());
+        }
       }
     }
 
-    optResStats.nonTrivialComponents = nonTrivialComponents;
-    optResStats.numCompsSolSpaceOne = numM1Comps;
-    optResStats.maxNumNodesPerComp = maxNumNodes;
-    optResStats.maxNumEdgesPerComp = maxNumEdges;
-    optResStats.maxCardPerComp = maxCompC;
-    optResStats.maxCompSolSpace = maxCompSolSpace;
-
-    if (_cfg->outputStats) {
-      LOGTO(INFO, std::cerr) << "(stats) Number of nontrivial components: "
-                             << optResStats.nonTrivialComponents;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Number of nontrivial components with sol space size 1: "
-          << optResStats.numCompsSolSpaceOne;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max number of nodes of all nontrivial components: "
-          << optResStats.maxNumNodesPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max number of edges of all nontrivial components: "
-          << optResStats.maxNumEdgesPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max cardinality of all nontrivial components: "
-          << optResStats.maxCardPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max solution space size of all nontrivial components: "
-          << optResStats.maxCompSolSpace;
-    }
-
     hc.writeFlatCfg(&c);
 
     // fill in missing edges (which may have been pruned in the optim graph)
@@ -264,6 +366,7 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
     if (score < bestScore) {
       bestCfg = c;
       bestScore = score;
+      bestRun = run;
 
       optResStats.score = score;
       optResStats.sameSegCrossings = crossings.first;
@@ -272,7 +375,19 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
     }
   }
 
-  rg->writePermutation(bestCfg);
+  {
+    TraceSpan span("write", "write-permutation");
+    rg->writePermutation(bestCfg);
+  }
+
+  for (size_t i = 0; i < comps.size(); i++) {
+    if (comps[i].size() < 3) continue;
+    size_t j = jobIdx[bestRun * comps.size() + i];
+    optResStats.compStats.push_back(
+        CompStats{i, comps[i].size(), static_cast<size_t>(numEdges(comps[i])),
+                  maxCard(comps[i]), compSolSp[i], jobStats[j].method, times[j],
+                  jobStats[j].gap});
+  }
 
   optResStats.runs = runs;
   optResStats.avgSolveTime = tSum / (1.0 * runs);
@@ -304,6 +419,291 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   return optResStats;
 }
 
+// _____________________________________________________________________________
+void Optimizer::runJobs(OptGraph* g, const std::vector<std::set<OptNode*>>& comps,
+                        size_t maxC, const std::vector<CompJob>& jobs,
+                        const CompRace* budget, const CompCache* cache,
+                        std::vector<HierarOrderCfg>* shards,
+                        std::vector<double>* times,
+                        std::vector<OptResStats>* stats) const {
+  // for trivial cases
+  const NullOptimizer nullOpt(_cfg, _scorer.getPens());
+
+  size_t numThreads = this->numThreads();
+  if (numThreads > jobs.size()) numThreads = std::max<size_t>(jobs.size(), 1);
+  numThreads = claimThreads(numThreads - 1) + 1;
+
+  // workers running out of jobs hand their thread over to the components
+  // still being optimized, the last one keeps the thread of the caller
+  std::atomic<size_t> running(numThreads);
+
+  // the time budget is split by the logarithm of the solution space sizes,
+  // which grow exponentially with the component size and may be infinite
+  std::vector<double> weights(jobs.size());
+  for (size_t i = 0; i < jobs.size(); i++) {
+    double solSp = std::min(jobs[i].solSp, DBL_MAX);
+    weights[i] = solSp > 1 ? 1 + std::log2(solSp) : 1;
+  }
+
+  // weights of the jobs not started before job i
+  std::vector<double> pendingWeight(jobs.size() + 1, 0);
+  for (size_t i = jobs.size(); i > 0; i--) {
+    pendingWeight[i - 1] = pendingWeight[i] + weights[i - 1];
+  }
+
+  // the next job to be taken, idle workers always grab the next one
+  std::atomic<size_t> next(0);
+  std::exception_ptr err;
+  std::mutex errMtx;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t i = next++;
+      if (i >= jobs.size()) {
+        if (--running > 0) releaseThreads(1);
+        return;
+      }
+      const auto& nds = comps[jobs[i].comp];
+
+      TraceSpan span("solve", "component " + std::to_string(jobs[i].comp));
+      span.arg("run", jobs[i].run);
+      span.arg("nodes", nds.size());
+      span.arg("solution_space_size", jobs[i].solSp);
+
+      (*stats)[i].method = getName();
+
+      try {
+        // this is the implementation of the single edge pruning described in
+        // the publication - simple skip such components
+        // we also skip components with only single edges
+        if (maxC > 1 && nds.size() > 2) {
+          if (cache && cache->get(nds, &(*shards)[i])) {
+            (*stats)[i].method = "cache";
+            // only proven optima are cached
+            (*stats)[i].gap = 0;
+            LOGTO(DEBUG, std::cerr)
+                << "Took ordering of component " << jobs[i].comp
+                << " from cache.";
+          } else if (budget) {
+            // each job gets the share of the time left which its weight has
+            // among the pending jobs, the workers run in parallel
+            auto now = std::chrono::steady_clock::now();
+            auto left = std::max(budget->deadline - now,
+                                 std::chrono::steady_clock::duration::zero());
+            double share = numThreads * weights[i] / pendingWeight[i];
+            share = std::max(share, MIN_JOB_SHARE * numThreads /
+                                        (jobs.size() - i));
+            if (!std::isfinite(share)) share = 1;
+
+            CompRace jobBudget;
+            jobBudget.solved = false;
+            jobBudget.hasDeadline = true;
+            jobBudget.deadline =
+                share < 1 ? now + std::chrono::duration_cast<
+                                      std::chrono::steady_clock::duration>(
+                                      left * share)
+                          : budget->deadline;
+
+            (*times)[i] = optimizeCompInBudget(g, nds, &jobBudget,
+                                               &(*shards)[i], (*stats)[i]);
+
+            if (cache && (*stats)[i].gap == 0) cache->put(nds, (*shards)[i]);
+          } else {
+            (*times)[i] = optimizeComp(g, nds, &(*shards)[i], (*stats)[i]);
+            // heuristic orderings would be reused in every further run
+            if (cache && (*stats)[i].gap == 0) cache->put(nds, (*shards)[i]);
+          }
+        } else {
+          (*stats)[i].method = nullOpt.getName();
+          (*times)[i] =
+              nullOpt.optimizeComp(g, nds, &(*shards)[i], 0, (*stats)[i]);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errMtx);
+        if (!err) err = std::current_exception();
+        // don't start any further jobs
+        next = jobs.size();
+        if (--running > 0) releaseThreads(1);
+        return;
+      }
+
+      span.arg("method", (*stats)[i].method);
+      span.arg("gap", (*stats)[i].gap);
+    }
+  };
+
+  if (numThreads < 2) {
+    worker();
+  } else {
+    std::vector<std::thread> thrds;
+    for (size_t i = 0; i < numThreads; i++) thrds.push_back(std::thread(worker));
+    for (auto& thr : thrds) thr.join();
+  }
+
+  if (err) std::rethrow_exception(err);
+}
+
+// _____________________________________________________________________________
+double Optimizer::optimizeCompInBudget(OptGraph* og,
+                                       const std::set<OptNode*>& g,
+                                       const CompRace* budget,
+                                       HierarOrderCfg* hc,
+                                       OptResStats& stats) const {
+  T_START(1);
+
+  // the greedy ordering is always available, even if the budget is used up
+  HierarOrderCfg greedyHc;
+  OptOrderCfg greedyCfg;
+  OptResStats greedyStats = stats;
+  GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
+  greedy.optimizeComp(og, g, &greedyHc, 0, greedyStats);
+  readHierarch(greedyHc, g, &greedyCfg);
+  double greedyScore = compScore(g, greedyCfg);
+
+  HierarOrderCfg res;
+  OptOrderCfg cfg;
+
+  setJobBudget(budget);
+  try {
+    optimizeComp(og, g, &res, 0, stats);
+  } catch (...) {
+    setJobBudget(0);
+    throw;
+  }
+  setJobBudget(0);
+
+  double score = greedyScore;
+
+  if (readHierarch(res, g, &cfg) && compScore(g, cfg) <= greedyScore) {
+    score = compScore(g, cfg);
+    *hc = res;
+  } else {
+    LOGTO(DEBUG, std::cerr) << "No better ordering than the greedy one found "
+                            << "within the time budget.";
+    stats.gap = -1;
+    stats.method = greedy.getName();
+    *hc = greedyHc;
+  }
+
+  // nothing is better than no crossings and separations at all
+  if (score == 0) stats.gap = 0;
+
+  return T_STOP(1);
+}
+
+// _____________________________________________________________________________
+bool Optimizer::raceOver() const {
+  auto now = std::chrono::steady_clock::now();
+  const CompRace* budget = jobBudget();
+  if (budget && budget->hasDeadline && now > budget->deadline) return true;
+  if (!_race) return false;
+  return _race->solved || (_race->hasDeadline && now > _race->deadline);
+}
+
+// _____________________________________________________________________________
+int Optimizer::raceSecondsLeft() const {
+  int ret = -1;
+  for (const CompRace* race : {static_cast<const CompRace*>(_race),
+                               jobBudget()}) {
+    if (!race || !race->hasDeadline) continue;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    race->deadline - std::chrono::steady_clock::now())
+                    .count();
+    int secs = left <= 0 ? 0 : (left + 999) / 1000;
+    if (ret < 0 || secs < ret) ret = secs;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Optimizer::raceSolved() const {
+  if (_race) _race->solved = true;
+}
+
+// _____________________________________________________________________________
+const CompRace* Optimizer::jobBudget() { return curJobBudget; }
+
+// _____________________________________________________________________________
+void Optimizer::setJobBudget(const CompRace* budget) { curJobBudget = budget; }
+
+// _____________________________________________________________________________
+double Optimizer::compScore(const std::set<OptNode*>& g,
+                            const OptOrderCfg& cfg) const {
+  // scored with the compiled component, like in the heuristics
+  OptOrderCfg tmp = cfg;
+  return DeltaScorer(&_scorer, g, &tmp).getScore();
+}
+
+// _____________________________________________________________________________
+void Optimizer::writeHierarch(OptOrderCfg* cfg, HierarOrderCfg* hc) const {
+  for (size_t i = 0; i < cfg->size(); i++) {
+    auto e = cfg->getEdge(i);
+
+    for (auto lnEdgPart : e->pl().lnEdgParts) {
+      if (lnEdgPart.wasCut) continue;
+      for (size_t j = 0; j < cfg->card(i); j++) {
+        // get the corresponding route occurance in the opt graph edge
+        const OptLO& optRO = e->pl().getLines()[cfg->perm(i)[j]];
+
+        for (auto rel : optRO.relatives) {
+          // retrieve the original line pos
+          size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
+          if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
+            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].insert(
+                (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].begin(), p);
+          } else {
+            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].push_back(p);
+          }
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool Optimizer::readHierarch(const HierarOrderCfg& hc,
+                             const std::set<OptNode*>& g, OptOrderCfg* cfg) {
+  *cfg = OptOrderCfg(g);
+
+  for (size_t i = 0; i < cfg->size(); i++) {
+    auto e = cfg->getEdge(i);
+
+    std::map<const Line*, uint16_t> idx;
+    for (size_t j = 0; j < e->pl().getLines().size(); j++) {
+      for (auto rel : e->pl().getLines()[j].relatives) idx[rel] = j;
+    }
+
+    // all parts carry the same ordering, the first one suffices
+    for (const auto& lnEdgPart : e->pl().lnEdgParts) {
+      if (lnEdgPart.wasCut) continue;
+
+      auto le = hc.find(lnEdgPart.lnEdg);
+      if (le == hc.end()) return false;
+      auto o = le->second.find(lnEdgPart.order);
+      if (o == le->second.end()) return false;
+
+      // the relatives of a line are consecutive
+      std::vector<uint16_t> perm;
+      for (size_t p : o->second) {
+        auto j = idx.find(lnEdgPart.lnEdg->pl().lineOccAtPos(p).line);
+        if (j == idx.end()) return false;
+        if (perm.empty() || perm.back() != j->second) perm.push_back(j->second);
+      }
+
+      if (perm.size() != cfg->card(i)) return false;
+
+      if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
+        std::reverse(perm.begin(), perm.end());
+      }
+
+      std::copy(perm.begin(), perm.end(), cfg->perm(i));
+      break;
+    }
+  }
+
+  return true;
+}
+
 // _____________________________________________________________________________
 std::vector<LinePair> Optimizer::getLinePairs(OptEdge* segment) {
   return getLinePairs(segment, false);
@@ -490,7 +890,7 @@ double Optimizer::optimizeComp(OptGraph* g, const std::set<OptNode*>& cmp,
 OptOrderCfg Optimizer::getOptOrderCfg(
     const shared::rendergraph::OrderCfg& cfg,
     const std::map<const LineNode*, OptNode*>& ndMap, const OptGraph* g) {
-  OptOrderCfg ret;
+  OptOrderCfg ret(g->getNds());
   for (auto i : cfg) {
     auto e = i.first;
     auto order = i.second;
@@ -499,15 +899,41 @@ OptOrderCfg Optimizer::getOptOrderCfg(
     auto opNdTo = ndMap.find(e->getTo())->second;
     auto opEdg = g->getEdg(opNdFr, opNdTo);
 
-    for (auto pos = order.rbegin(); pos != order.rend(); pos++) {
+    const auto& lines = opEdg->pl().getLines();
+    auto perm = ret.perm(opEdg);
+    size_t j = 0;
+
+    for (auto pos = order.rbegin(); pos != order.rend(); pos++, j++) {
       auto lo = e->pl().lineOccAtPos(*pos);
-      ret[opEdg].push_back(lo.line);
+      perm[j] = opEdg->pl().getLineOcc(lo.line) - &lines[0];
     }
   }
 
   return ret;
 }
 
+// _____________________________________________________________________________
+size_t Optimizer::numThreads() const {
+  size_t ret = _cfg->optimThreads;
+  if (ret == 0) ret = std::thread::hardware_concurrency();
+  if (ret == 0) ret = 1;
+  return ret;
+}
+
+// _____________________________________________________________________________
+size_t Optimizer::claimThreads(size_t max) const {
+  size_t cur = extraThrds;
+  size_t ret;
+  do {
+    size_t free = cur + 1 < numThreads() ? numThreads() - cur - 1 : 0;
+    ret = std::min(max, free);
+  } while (ret && !extraThrds.compare_exchange_weak(cur, cur + ret));
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Optimizer::releaseThreads(size_t n) const { extraThrds -= n; }
+
 // _____________________________________________________________________________
 std::string Optimizer::prefix(size_t depth) {
   std::stringstream ret;
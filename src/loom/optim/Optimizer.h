@@ -2,7 +2,10 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <atomic>
+#include <chrono>
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/CompCache.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
 #include "shared/rendergraph/OrderCfg.h"
@@ -19,6 +22,33 @@ typedef std::pair<size_t, size_t> PosCom;
 typedef std::pair<PosCom, PosCom> PosComPair;
 typedef std::pair<OptEdge*, OptEdge*> EdgePair;
 
+// a single (run, component) optimization job
+struct CompJob {
+  size_t run;
+  size_t comp;
+  double solSp;
+};
+
+// shared by optimizers racing on the same component: they stop once the
+// deadline has passed or once one of them has found a proven optimum
+struct CompRace {
+  bool hasDeadline;
+  std::chrono::steady_clock::time_point deadline;
+  std::atomic<bool> solved;
+};
+
+// statistics of a single nontrivial component of the best run
+struct CompStats {
+  size_t comp, numNodes, numEdges, maxCard;
+  double solSp;
+  // the optimizer which produced the ordering
+  std::string method;
+  // solve time in ms
+  double time;
+  // optimality gap, -1 if unknown
+  double gap;
+};
+
 struct OptResStats {
   size_t numNodesOrig, numStationsOrig, numEdgesOrig, maxLineCardOrig, numLinesOrig, maxDegOrig;
   size_t numStations, numNodes, numEdges, maxLineCard, nonTrivialComponents, numCompsSolSpaceOne, maxNumNodesPerComp, maxNumEdgesPerComp, maxCardPerComp, numCompsOrig, maxNumRowsPerComp, maxNumColsPerComp;
@@ -30,6 +60,14 @@ struct OptResStats {
   size_t diffSegCrossings;
   size_t separations;
   double score;
+
+  // optimality gap of a single component ordering, -1 if unknown
+  double gap;
+
+  // the optimizer which produced a single component ordering
+  std::string method;
+
+  std::vector<CompStats> compStats;
 };
 
 class Optimizer {
@@ -72,13 +110,65 @@ class Optimizer {
 
   virtual std::string getName() const = 0;
 
+  // take part in a race, optimizers checking raceOver() return their best
+  // ordering found so far once it is over. The race is also over once the
+  // time budget of the current component job is used up.
+  void setRace(CompRace* race) { _race = race; }
+
  protected:
   const config::Config* _cfg;
   const OptGraphScorer _scorer;
+  CompRace* _race = 0;
+
+  bool raceOver() const;
+
+  // seconds left until the race deadline (rounded up), -1 if there is none
+  int raceSecondsLeft() const;
+
+  // signal the other racers that a proven optimum was found
+  void raceSolved() const;
 
   static std::string prefix(size_t depth);
 
+  // number of worker threads to use, as configured
+  size_t numThreads() const;
+
+  // claim up to max threads besides the calling one from the numThreads()
+  // threads shared by all running optimizations, returns the number claimed
+  size_t claimThreads(size_t max) const;
+  void releaseThreads(size_t n) const;
+
+  // time budget of the component job run by the calling thread, 0 if none
+  static const CompRace* jobBudget();
+  static void setJobBudget(const CompRace* budget);
+
+  // score of the ordering cfg of component g
+  double compScore(const std::set<OptNode*>& g, const OptOrderCfg& cfg) const;
+
+  // write the ordering cfg into hc, expanding collapsed lines
+  void writeHierarch(OptOrderCfg* cfg,
+                     shared::rendergraph::HierarOrderCfg* c) const;
+
+  // read the ordering of g written into hc back, false if hc does not hold
+  // a complete ordering of g
+  static bool readHierarch(const shared::rendergraph::HierarOrderCfg& hc,
+                           const std::set<OptNode*>& g, OptOrderCfg* cfg);
+
  private:
+  // optimize g until its time budget is used up, keep the greedy ordering if
+  // nothing better was found until then
+  double optimizeCompInBudget(OptGraph* og, const std::set<OptNode*>& g,
+                              const CompRace* budget,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              OptResStats& stats) const;
+
+  void runJobs(OptGraph* g, const std::vector<std::set<OptNode*>>& comps,
+               size_t maxC, const std::vector<CompJob>& jobs,
+               const CompRace* budget, const CompCache* cache,
+               std::vector<shared::rendergraph::HierarOrderCfg>* shards,
+               std::vector<double>* times,
+               std::vector<OptResStats>* stats) const;
+
   static OptOrderCfg getOptOrderCfg(
       const shared::rendergraph::OrderCfg&,
       const std::map<const shared::linegraph::LineNode*, OptNode*>& ndMap,
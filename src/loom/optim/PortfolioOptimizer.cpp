@@ -0,0 +1,156 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "loom/optim/BranchBoundOptimizer.h"
+#include "loom/optim/HillClimbOptimizer.h"
+#include "loom/optim/ILPEdgeOrderOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/PortfolioOptimizer.h"
+#include "loom/optim/SimulatedAnnealingOptimizer.h"
+#include "loom/optim/Tracer.h"
+#include "shared/rendergraph/OrderCfg.h"
+#include "util/log/Log.h"
+
+using loom::optim::BranchBoundOptimizer;
+using loom::optim::CompRace;
+using loom::optim::HillClimbOptimizer;
+using loom::optim::ILPEdgeOrderOptimizer;
+using loom::optim::OptOrderCfg;
+using loom::optim::Optimizer;
+using loom::optim::PortfolioOptimizer;
+using loom::optim::SimulatedAnnealingOptimizer;
+using loom::optim::TraceSpan;
+using shared::rendergraph::HierarOrderCfg;
+
+// _____________________________________________________________________________
+double PortfolioOptimizer::optimizeComp(OptGraph* og,
+                                        const std::set<OptNode*>& g,
+                                        HierarOrderCfg* hc, size_t depth,
+                                        OptResStats& stats) const {
+  size_t maxC = maxCard(g);
+  double solSp = solutionSpaceSize(g);
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth)
+                          << "(PortfolioOptimizer) Optimizing comp with "
+                          << g.size() << " nodes, max card " << maxC
+                          << ", sol space size " << solSp;
+
+  // not worth a race
+  if (maxC == 1) {
+    stats.method = _nullOpt.getName();
+    return _nullOpt.optimizeComp(og, g, hc, depth + 1, stats);
+  } else if (solSp < 500 * numThreads()) {
+    stats.method = _exhausOpt.getName();
+    return _exhausOpt.optimizeComp(og, g, hc, depth + 1, stats);
+  }
+
+  T_START(1);
+
+  CompRace race;
+  race.solved = false;
+  race.hasDeadline = _cfg->portfolioTimeLimit >= 0;
+  race.deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(std::max(0, _cfg->portfolioTimeLimit));
+
+  // racers are created per component, as each one takes part in its own race
+#if defined GUROBI_FOUND || defined GLPK_FOUND || defined COIN_FOUND
+  ILPEdgeOrderOptimizer exactOpt(_cfg, _scorer.getPens());
+#else
+  BranchBoundOptimizer exactOpt(_cfg, _scorer.getPens());
+#endif
+  HillClimbOptimizer hillcOpt(_cfg, _scorer.getPens(), false);
+  SimulatedAnnealingOptimizer annealOpt(_cfg, _scorer.getPens(), false);
+
+  // the exact optimizer comes first, it wins ties
+  std::vector<Optimizer*> racers{&exactOpt, &hillcOpt, &annealOpt};
+
+  for (auto r : racers) r->setRace(&race);
+
+  std::vector<HierarOrderCfg> res(racers.size());
+  std::vector<OptOrderCfg> cfgs(racers.size());
+  std::vector<OptResStats> racerStats(racers.size(), stats);
+
+  // not a vector<bool>, the racers write their flags concurrently
+  std::vector<char> ok(racers.size(), false);
+
+  // number the component's edges before the racers do it concurrently
+  OptOrderCfg numbering(g);
+
+  // the racers are also bound by the time budget of this job
+  const CompRace* budget = jobBudget();
+
+  auto run = [&](size_t i) {
+    TraceSpan span("race", racers[i]->getName());
+    setJobBudget(budget);
+    try {
+      racers[i]->optimizeComp(og, g, &res[i], depth + 1, racerStats[i]);
+      ok[i] = readHierarch(res[i], g, &cfgs[i]);
+    } catch (const std::exception& e) {
+      LOGTO(WARN, std::cerr) << prefix(depth) << "Optimizer "
+                             << racers[i]->getName() << " failed: " << e.what();
+    }
+  };
+
+  // the racers share the thread budget with the other components, the ones
+  // without a thread of their own run one after the other on this thread
+  size_t numThrds = claimThreads(racers.size() - 1);
+
+  std::vector<std::thread> thrds;
+  for (size_t i = 0; i < numThrds; i++) {
+    thrds.push_back(std::thread(run, i));
+  }
+  for (size_t i = numThrds; i < racers.size(); i++) run(i);
+  for (auto& thr : thrds) thr.join();
+  releaseThreads(numThrds);
+
+  size_t best = racers.size();
+  double bestScore = std::numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < racers.size(); i++) {
+    if (racerStats[i].maxNumRowsPerComp > stats.maxNumRowsPerComp)
+      stats.maxNumRowsPerComp = racerStats[i].maxNumRowsPerComp;
+    if (racerStats[i].maxNumColsPerComp > stats.maxNumColsPerComp)
+      stats.maxNumColsPerComp = racerStats[i].maxNumColsPerComp;
+
+    if (!ok[i]) continue;
+
+    double score = compScore(g, cfgs[i]);
+
+    LOGTO(DEBUG, std::cerr) << prefix(depth) << racers[i]->getName()
+                            << " scored " << score;
+
+    if (score < bestScore) {
+      bestScore = score;
+      best = i;
+    }
+  }
+
+  if (best == racers.size()) {
+    LOGTO(WARN, std::cerr) << prefix(depth)
+                           << "No optimizer produced an ordering!";
+  } else {
+    LOGTO(DEBUG, std::cerr) << prefix(depth) << "Taking ordering of "
+                            << racers[best]->getName()
+                            << (race.solved ? " (race was solved)" : "");
+
+    stats.gap = racerStats[best].gap;
+    stats.method = racers[best]->getName();
+
+    for (const auto& e : res[best]) {
+      for (const auto& o : e.second) {
+        auto& dst = (*hc)[e.first][o.first];
+        dst.insert(dst.end(), o.second.begin(), o.second.end());
+      }
+    }
+  }
+
+  return T_STOP(1);
+}
@@ -0,0 +1,41 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_PORTFOLIOOPTIMIZER_H_
+#define LOOM_OPTIM_PORTFOLIOOPTIMIZER_H_
+
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/ExhaustiveOptimizer.h"
+#include "loom/optim/NullOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// Races the heuristics against an exact optimizer on each component. All
+// racers share a wall-clock budget, they are stopped once it is used up or
+// once the exact optimizer has proven its result optimal. The ordering with
+// the best score is taken.
+class PortfolioOptimizer : public Optimizer {
+ public:
+  PortfolioOptimizer(const config::Config* cfg,
+                     const shared::rendergraph::Penalties& pens)
+      : Optimizer(cfg, pens), _nullOpt(cfg, pens), _exhausOpt(cfg, pens){};
+
+  double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                      shared::rendergraph::HierarOrderCfg* c, size_t depth,
+                      OptResStats& stats) const;
+
+  virtual std::string getName() const { return "portfolio"; }
+
+ private:
+  const NullOptimizer _nullOpt;
+  const ExhaustiveOptimizer _exhausOpt;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_PORTFOLIOOPTIMIZER_H_
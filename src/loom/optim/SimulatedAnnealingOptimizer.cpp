@@ -3,7 +3,13 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <unordered_map>
+#include "loom/optim/DeltaScorer.h"
 #include "loom/optim/GreedyOptimizer.h"
 #include "loom/optim/SimulatedAnnealingOptimizer.h"
 #include "util/log/Log.h"
@@ -16,15 +22,28 @@ using shared::rendergraph::HierarOrderCfg;
 using shared::rendergraph::OrderCfg;
 using shared::rendergraph::RenderGraph;
 
+// temperature ratio between adjacent levels of the ladder
+const static double TEMP_LADDER = 1.5;
+
+// number of chains run if fewer threads were granted
+const static size_t MIN_CHAINS = 4;
+
+// stop once the coldest level has not changed for this many sweeps
+const static size_t ABORT_AFTER_UNCH = 5;
+
+// restart the coldest chain from the best ordering once it has stayed above
+// it for this many sweeps
+const static size_t RESTART_AFTER = 3;
+
 // _____________________________________________________________________________
 double SimulatedAnnealingOptimizer::optimizeComp(OptGraph* og,
                                               const std::set<OptNode*>& g,
                                               HierarOrderCfg* hc, size_t depth,
                                               OptResStats& stats) const {
   T_START(1);
+  UNUSED(og);
   UNUSED(depth);
   UNUSED(stats);
-  OptOrderCfg cur;
 
   // fixed order list of optim graph edges
   std::vector<OptEdge*> edges;
@@ -33,62 +52,203 @@ double SimulatedAnnealingOptimizer::optimizeComp(OptGraph* og,
     for (auto e : n->getAdjList())
       if (n == e->getFrom()) edges.push_back(e);
 
-  if (_randomStart) {
-    // this is the starting ordering, which is random
-    initialConfig(g, &cur, false);
-  } else {
+  // chains are run by the calling thread and the ones left over by other
+  // components, thread t runs the chains t, t + numThrds, ...
+  size_t numThrds = claimThreads(numThreads() - 1) + 1;
+
+  // one chain per granted thread, but always a small ladder, even if no
+  // thread was left over
+  size_t numChains = std::max(numThrds, MIN_CHAINS);
+
+  // a fresh seed for each component job, so runs differ
+  std::random_device rd;
+  std::seed_seq seq{rd(), rd(), rd(), rd()};
+  std::vector<uint32_t> seeds(numChains + 1);
+  seq.generate(seeds.begin(), seeds.end());
+
+  OptOrderCfg start;
+  if (!_randomStart) {
     // take the greedy optimized ordering as a starting point
     GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
-    greedy.getFlatConfig(g, &cur);
+    greedy.getFlatConfig(g, &start);
   }
 
+  std::vector<AnnealChain> chains(numChains);
+  std::vector<DeltaScorer> deltas;
+  deltas.reserve(numChains);
+
+  // chain at each level, the coldest level comes first
+  std::vector<size_t> atLevel(numChains);
+
+  for (size_t i = 0; i < numChains; i++) {
+    chains[i].rng.seed(seeds[i]);
+
+    if (_randomStart) {
+      // this is the starting ordering, which is random
+      initialConfig(g, &chains[i].cfg, true);
+      for (size_t j = 0; j < chains[i].cfg.size(); j++) {
+        std::shuffle(chains[i].cfg.perm(j),
+                     chains[i].cfg.perm(j) + chains[i].cfg.card(j),
+                     chains[i].rng);
+      }
+    } else {
+      chains[i].cfg = start;
+    }
+
+    chains[i].level = i;
+    atLevel[i] = i;
+
+    deltas.push_back(DeltaScorer(&_optScorer, g, &chains[i].cfg));
+    chains[i].score = deltas[i].getScore();
+  }
+
+  std::mt19937 rng(seeds[numChains]);
+  std::uniform_real_distribution<double> unif(0, 1);
+
+  OptOrderCfg best = chains[0].cfg;
+  double bestScore = chains[0].score;
+
   size_t iters = 0;
 
   size_t k = 0;
 
-  size_t ABORT_AFTER_UNCH = 5;
+  // sweeps above the best score of the chain at the coldest level
+  size_t stalled = 0;
+
+  double temp = 0;
+
+  auto run = [&](size_t t) {
+    for (size_t i = t; i < numChains; i += numThrds) {
+      sweep(edges, temp * std::pow(TEMP_LADDER, chains[i].level), &chains[i],
+            &deltas[i]);
+    }
+  };
+
+  // the chain threads live as long as the optimization, each sweep is
+  // started by increasing round and finished once pending drops to 0
+  std::mutex mtx;
+  std::condition_variable startCv, doneCv;
+  size_t round = 0, pending = 0;
+  bool done = false;
+
+  std::vector<std::thread> thrds;
+  for (size_t t = 1; t < numThrds; t++) {
+    thrds.push_back(std::thread([&, t]() {
+      size_t seen = 0;
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          startCv.wait(lock, [&]() { return done || round != seen; });
+          if (done) return;
+          seen = round;
+        }
+
+        run(t);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--pending == 0) doneCv.notify_one();
+      }
+    }));
+  }
 
   while (true) {
     iters++;
 
-    double temp = 1000.0 / iters;
-
-    for (size_t i = 0; i < edges.size(); i++) {
-      double oldScore = getScore(og, edges[i], cur);
-
-      for (size_t p1 = 0; p1 < cur[edges[i]].size(); p1++) {
-        for (size_t p2 = p1; p2 < cur[edges[i]].size(); p2++) {
-          // switch p1 and p2
-          auto tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
-
-          double s = getScore(og, edges[i], cur);
-
-          double r = rand() / (RAND_MAX + 1.0);
-          double e = exp(-(1.0 * (s - oldScore)) / temp);
-
-          if (s < oldScore) {
-            // found a better solution, keep it, update score
-            oldScore = s;
-            k = iters;
-          } else if (s != oldScore && e > r) {
-            // keep solution, despite not bringing any local gain, update score
-            oldScore = s;
-            k = iters;
-          } else {
-            // switch back
-            tmp = cur[edges[i]][p1];
-            cur[edges[i]][p1] = cur[edges[i]][p2];
-            cur[edges[i]][p2] = tmp;
-          }
-        }
+    temp = 1000.0 / iters;
+
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      round++;
+      pending = numThrds - 1;
+    }
+    startCv.notify_all();
+
+    run(0);
+
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      doneCv.wait(lock, [&]() { return pending == 0; });
+    }
+
+    if (chains[atLevel[0]].changed) k = iters;
+
+    for (auto& chain : chains) {
+      if (chain.score < bestScore) {
+        bestScore = chain.score;
+        best = chain.cfg;
+      }
+    }
+
+    // replica exchange between adjacent levels, a colder chain always takes
+    // over a strictly better ordering
+    for (size_t l = 0; l + 1 < numChains; l++) {
+      auto& a = chains[atLevel[l]];
+      auto& b = chains[atLevel[l + 1]];
+      if (a.score == b.score) continue;
+
+      double tA = temp * std::pow(TEMP_LADDER, l);
+      double tB = tA * TEMP_LADDER;
+      double x = (a.score - b.score) * (1 / tA - 1 / tB);
+
+      if (x > 0 || unif(rng) < exp(x)) {
+        std::swap(atLevel[l], atLevel[l + 1]);
+        std::swap(a.level, b.level);
+        if (l == 0) k = iters;
       }
     }
 
-    if (iters - k > ABORT_AFTER_UNCH) break;
+    // the best ordering may have been found by a hot chain which has since
+    // moved away from it, continue the coldest chain from there
+    size_t cold = atLevel[0];
+    if (chains[cold].score > bestScore) {
+      stalled++;
+    } else {
+      stalled = 0;
+    }
+
+    if (stalled >= RESTART_AFTER) {
+      chains[cold].cfg = best;
+      deltas[cold] = DeltaScorer(&_optScorer, g, &chains[cold].cfg);
+      chains[cold].score = deltas[cold].getScore();
+      stalled = 0;
+    }
+
+    if (iters - k > ABORT_AFTER_UNCH || raceOver()) break;
   }
 
-  writeHierarch(&cur, hc);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    done = true;
+  }
+  startCv.notify_all();
+  for (auto& thr : thrds) thr.join();
+  releaseThreads(numThrds - 1);
+
+  writeHierarch(&best, hc);
   return T_STOP(1);
 }
+
+// _____________________________________________________________________________
+void SimulatedAnnealingOptimizer::sweep(const std::vector<OptEdge*>& edges,
+                                        double temp, AnnealChain* chain,
+                                        DeltaScorer* delta) const {
+  std::uniform_real_distribution<double> unif(0, 1);
+  chain->changed = false;
+
+  for (size_t i = 0; i < edges.size(); i++) {
+    size_t card = edges[i]->pl().getCardinality();
+    for (size_t p1 = 0; p1 < card; p1++) {
+      for (size_t p2 = p1 + 1; p2 < card; p2++) {
+        // score change if p1 and p2 were switched
+        double d = delta->getSwapDelta(edges[i], p1, p2);
+
+        if (d < 0 || (d != 0 && exp(-(1.0 * d) / temp) > unif(chain->rng))) {
+          // keep solution, even if it does not bring any local gain
+          delta->swap(edges[i], p1, p2);
+          chain->score += d;
+          chain->changed = true;
+        }
+      }
+    }
+  }
+}
@@ -5,7 +5,10 @@
 #ifndef LOOM_OPTIM_SIMULATEDANNEALINGOPTIMIZER_H_
 #define LOOM_OPTIM_SIMULATEDANNEALINGOPTIMIZER_H_
 
+#include <random>
+#include <vector>
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/DeltaScorer.h"
 #include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
 #include "loom/optim/NullOptimizer.h"
@@ -17,6 +20,25 @@
 namespace loom {
 namespace optim {
 
+// a single annealing chain, chains exchange their temperature levels
+struct AnnealChain {
+  OptOrderCfg cfg;
+
+  // each chain draws from its own generator, so chains run independently
+  std::mt19937 rng;
+
+  size_t level;
+  double score;
+  bool changed;
+};
+
+// Parallel tempering: one annealing chain per thread granted from the thread
+// budget (but a few at least), each at its own temperature level of a
+// geometric ladder above the cooling schedule. After each sweep, chains on
+// adjacent levels may exchange their levels, so good orderings found by hot
+// chains sink down to the coldest one. The coldest chain restarts from the
+// best ordering seen by any chain once it stalls above it, and the best
+// ordering is returned.
 class SimulatedAnnealingOptimizer : public HillClimbOptimizer {
  public:
   SimulatedAnnealingOptimizer(const config::Config* cfg,
@@ -27,6 +49,15 @@ class SimulatedAnnealingOptimizer : public HillClimbOptimizer {
   virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                            shared::rendergraph::HierarOrderCfg* c,
                            size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const {
+    return _randomStart ? "anneal-random" : "anneal";
+  }
+
+ private:
+  // anneal chain for one sweep over all swaps at temperature temp
+  void sweep(const std::vector<OptEdge*>& edges, double temp,
+             AnnealChain* chain, DeltaScorer* delta) const;
 };
 }  // namespace optim
 }  // namespace loom
@@ -0,0 +1,95 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "3rdparty/json.hpp"
+#include "loom/optim/Tracer.h"
+
+using loom::optim::TraceSpan;
+using loom::optim::Tracer;
+
+static std::atomic<bool> traceOn(false);
+static std::mutex traceMtx;
+static std::vector<Tracer::Event> traceEvents;
+static std::map<std::thread::id, size_t> traceTids;
+static const auto traceStart = std::chrono::steady_clock::now();
+
+// _____________________________________________________________________________
+void Tracer::enable() { traceOn = true; }
+
+// _____________________________________________________________________________
+bool Tracer::enabled() { return traceOn; }
+
+// _____________________________________________________________________________
+double Tracer::now() {
+  // in microseconds, as expected by the trace-event format
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - traceStart)
+      .count();
+}
+
+// _____________________________________________________________________________
+void Tracer::record(Event ev) {
+  std::lock_guard<std::mutex> lock(traceMtx);
+  auto it = traceTids.find(std::this_thread::get_id());
+  if (it == traceTids.end()) {
+    it = traceTids.insert({std::this_thread::get_id(), traceTids.size()}).first;
+  }
+  ev.tid = it->second;
+  traceEvents.push_back(std::move(ev));
+}
+
+// _____________________________________________________________________________
+void Tracer::writeChromeTrace(std::ostream* out) {
+  std::lock_guard<std::mutex> lock(traceMtx);
+
+  nlohmann::json evs = nlohmann::json::array();
+  for (const auto& ev : traceEvents) {
+    nlohmann::json args = nlohmann::json::object();
+    for (const auto& arg : ev.args) {
+      args[arg.first] = nlohmann::json::parse(arg.second);
+    }
+    evs.push_back({{"name", ev.name},
+                   {"cat", ev.cat},
+                   {"ph", "X"},
+                   {"ts", ev.start},
+                   {"dur", ev.dur},
+                   {"pid", 1},
+                   {"tid", ev.tid},
+                   {"args", args}});
+  }
+
+  (*out) << nlohmann::json{{"traceEvents", evs}, {"displayTimeUnit", "ms"}};
+}
+
+// _____________________________________________________________________________
+TraceSpan::TraceSpan(const std::string& cat, const std::string& name)
+    : _on(Tracer::enabled()) {
+  if (!_on) return;
+  _ev.cat = cat;
+  _ev.name = name;
+  _ev.start = Tracer::now();
+}
+
+// _____________________________________________________________________________
+TraceSpan::~TraceSpan() {
+  if (!_on) return;
+  _ev.dur = Tracer::now() - _ev.start;
+  Tracer::record(std::move(_ev));
+}
+
+// _____________________________________________________________________________
+void TraceSpan::arg(const std::string& key, double val) {
+  if (!_on) return;
+  _ev.args.push_back({key, nlohmann::json(val).dump()});
+}
+
+// _____________________________________________________________________________
+void TraceSpan::arg(const std::string& key, const std::string& val) {
+  if (!_on) return;
+  _ev.args.push_back({key, nlohmann::json(val).dump()});
+}
@@ -0,0 +1,60 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_TRACER_H_
+#define LOOM_OPTIM_TRACER_H_
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace loom {
+namespace optim {
+
+// Process-wide recorder of timed spans (graph build, simplification rules,
+// component solves, ...) which can be exported as Chrome trace-event JSON,
+// viewable in chrome://tracing or Perfetto. Recording is disabled by default,
+// spans are then no-ops.
+class Tracer {
+ public:
+  static void enable();
+  static bool enabled();
+
+  // write all spans finished so far as Chrome trace-event JSON
+  static void writeChromeTrace(std::ostream* out);
+
+  struct Event {
+    std::string cat, name;
+    size_t tid;
+    double start, dur;
+    // argument names and their values, already JSON-encoded
+    std::vector<std::pair<std::string, std::string>> args;
+  };
+
+ private:
+  friend class TraceSpan;
+
+  static void record(Event ev);
+  static double now();
+};
+
+// A span which lasts from its construction to its destruction.
+class TraceSpan {
+ public:
+  TraceSpan(const std::string& cat, const std::string& name);
+  ~TraceSpan();
+
+  void arg(const std::string& key, double val);
+  void arg(const std::string& key, const std::string& val);
+
+ private:
+  bool _on;
+  Tracer::Event _ev;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_TRACER_H_
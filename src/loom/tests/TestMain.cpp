@@ -2,12 +2,23 @@
 // Author: Patrick Brosi
 //
 
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
 #include <vector>
 
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/BranchBoundOptimizer.h"
 #include "loom/optim/CombOptimizer.h"
+#include "loom/optim/CompCache.h"
+#include "loom/optim/DeltaScorer.h"
+#include "loom/optim/OptGraphScorer.h"
 #include "shared/optim/ILPSolvProv.h"
 #include "shared/rendergraph/RenderGraph.h"
+#include "util/graph/Algorithm.h"
 
 struct FileTest {
   std::string fname;
@@ -446,12 +457,14 @@ int main(int argc, char** argv) {
     loom::optim::ILPOptimizer ilpOptim(&cfg, pens);
     loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pens);
     loom::optim::CombOptimizer combOptim(&cfg, pens, true);
+    loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
 
     std::vector<loom::optim::Optimizer*> optimizers;
     optimizers.push_back(&exhausOptim);
     optimizers.push_back(&ilpOptim);
     optimizers.push_back(&ilpImprOptim);
     optimizers.push_back(&combOptim);
+    optimizers.push_back(&bnbOptim);
 
     for (auto optim : optimizers) {
       for (const auto& test : fileTests) {
@@ -468,6 +481,7 @@ int main(int argc, char** argv) {
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
         std::cout << optim->getName() << " " << test.fname
                   << " (search space size=" << g.searchSpaceSize() << ")"
@@ -492,12 +506,14 @@ int main(int argc, char** argv) {
     loom::optim::ILPOptimizer ilpOptim(&cfg, pens);
     loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pens);
     loom::optim::CombOptimizer combOptim(&cfg, pens, true);
+    loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
 
     std::vector<loom::optim::Optimizer*> optimizers;
     optimizers.push_back(&exhausOptim);
     optimizers.push_back(&ilpOptim);
     optimizers.push_back(&ilpImprOptim);
     optimizers.push_back(&combOptim);
+    optimizers.push_back(&bnbOptim);
 
     for (auto optim : optimizers) {
       shared::rendergraph::RenderGraph g(5, 1, 5);
@@ -515,6 +531,7 @@ int main(int argc, char** argv) {
       if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
       if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
       if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+      if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
       std::cout << optim->getName()
                 << " ../src/loom/tests/datasets/freiburg-tram.json (search "
@@ -545,12 +562,14 @@ int main(int argc, char** argv) {
       loom::optim::ILPOptimizer ilpOptim(&cfg, pensLoc);
       loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pensLoc);
       loom::optim::CombOptimizer combOptim(&cfg, pensLoc, true);
+      loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pensLoc);
 
       std::vector<loom::optim::Optimizer*> optimizers;
       optimizers.push_back(&exhausOptim);
       optimizers.push_back(&ilpOptim);
       optimizers.push_back(&ilpImprOptim);
       optimizers.push_back(&combOptim);
+      optimizers.push_back(&bnbOptim);
 
       for (auto optim : optimizers) {
         shared::rendergraph::RenderGraph g(5, 1, 5);
@@ -568,6 +587,7 @@ int main(int argc, char** argv) {
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
         std::cout << optim->getName()
                   << " ../src/loom/tests/datasets/freiburg-tram.json (search "
@@ -602,12 +622,14 @@ int main(int argc, char** argv) {
       loom::optim::ILPOptimizer ilpOptim(&cfg, pensLoc);
       loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pensLoc);
       loom::optim::CombOptimizer combOptim(&cfg, pensLoc, true);
+      loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pensLoc);
 
       std::vector<loom::optim::Optimizer*> optimizers;
       optimizers.push_back(&exhausOptim);
       optimizers.push_back(&ilpOptim);
       optimizers.push_back(&ilpImprOptim);
       optimizers.push_back(&combOptim);
+      optimizers.push_back(&bnbOptim);
 
       for (auto optim : optimizers) {
         shared::rendergraph::RenderGraph g(5, 1, 5);
@@ -625,6 +647,7 @@ int main(int argc, char** argv) {
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
         std::cout << optim->getName()
                   << " ../src/loom/tests/datasets/freiburg-tram.json (search "
@@ -657,12 +680,14 @@ int main(int argc, char** argv) {
     loom::optim::ILPOptimizer ilpOptim(&cfg, pens);
     loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pens);
     loom::optim::CombOptimizer combOptim(&cfg, pens, true);
+    loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
 
     std::vector<loom::optim::Optimizer*> optimizers;
     optimizers.push_back(&exhausOptim);
     optimizers.push_back(&ilpOptim);
     optimizers.push_back(&ilpImprOptim);
     optimizers.push_back(&combOptim);
+    optimizers.push_back(&bnbOptim);
 
     for (auto optim : optimizers) {
       for (const auto& test : fileTests) {
@@ -679,6 +704,7 @@ int main(int argc, char** argv) {
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
         std::cout << optim->getName()
                   << " ../src/loom/tests/datasets/freiburg-tram.json (search "
@@ -717,12 +743,14 @@ int main(int argc, char** argv) {
       loom::optim::ILPOptimizer ilpOptim(&cfg, pensLoc);
       loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pensLoc);
       loom::optim::CombOptimizer combOptim(&cfg, pensLoc, true);
+      loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pensLoc);
 
       std::vector<loom::optim::Optimizer*> optimizers;
       optimizers.push_back(&exhausOptim);
       optimizers.push_back(&ilpOptim);
       optimizers.push_back(&ilpImprOptim);
       optimizers.push_back(&combOptim);
+      optimizers.push_back(&bnbOptim);
 
       for (auto optim : optimizers) {
         shared::rendergraph::RenderGraph g(5, 1, 5);
@@ -740,6 +768,7 @@ int main(int argc, char** argv) {
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 5000000) continue;
 
         std::cout << optim->getName()
                   << " ../src/loom/tests/datasets/freiburg-tram.json (search "
@@ -759,4 +788,209 @@ int main(int argc, char** argv) {
       }
     }
   }
+
+  // components split at bridges, against the unsplit components
+  {
+    size_t numSplit = 0;
+
+    for (auto cfgSplit : configs) {
+      // a single thread keeps components above the exhaustive search limit
+      cfgSplit.optimThreads = 1;
+      loom::config::Config cfgWhole = cfgSplit;
+      cfgWhole.maxBridgeCard = 0;
+
+      loom::optim::CombOptimizer splitOptim(&cfgSplit, pens);
+      loom::optim::CombOptimizer wholeOptim(&cfgWhole, pens);
+
+      double scores[2];
+      loom::optim::OptResStats splitRes;
+
+      for (size_t i = 0; i < 2; i++) {
+        shared::rendergraph::RenderGraph g(5, 1, 5);
+
+        std::ifstream input;
+        input.open("../src/loom/tests/datasets/freiburg-tram.json");
+        g.readFromJson(&input, true);
+
+        auto res = (i == 0 ? splitOptim : wholeOptim).optimize(&g);
+        scores[i] = res.score;
+        if (i == 0) splitRes = res;
+      }
+
+      TEST(scores[0], ==, scores[1]);
+
+      for (const auto& cs : splitRes.compStats) {
+        if (cs.method.find('+') != std::string::npos) numSplit++;
+      }
+    }
+
+    TEST(numSplit, >, 0);
+  }
+
+  // incremental scoring, with and without separation penalty
+  {
+    shared::rendergraph::Penalties pensLoc = pens;
+    pensLoc.inStatSplitPenDegTwo = 0;
+    pensLoc.inStatSplitPen = 0;
+    pensLoc.splitPen = 0;
+
+    shared::rendergraph::Penalties pensAdj = pens;
+    pensAdj.diffSegCrossPen = 100;
+    pensAdj.inStatCrossPenDiffSeg = 200;
+    pensAdj.inStatCrossPenSameSeg = 5;
+    pensAdj.inStatSplitPen = 300;
+    pensAdj.splitPen = 500;
+    pensAdj.crossAdjPen = true;
+    pensAdj.splitAdjPen = true;
+
+    std::vector<std::string> fnames;
+    for (const auto& test : fileTests) fnames.push_back(test.fname);
+    fnames.push_back("../src/loom/tests/datasets/freiburg-tram.json");
+
+    std::mt19937 rng(0);
+
+    for (const auto& p : {pensLoc, pens, pensAdj}) {
+      for (const auto& fname : fnames) {
+        shared::rendergraph::RenderGraph g(5, 1, 5);
+
+        std::ifstream input;
+        input.open(fname);
+        g.readFromJson(&input, true);
+
+        loom::optim::OptGraphScorer scorer(p);
+        loom::optim::OptGraph og(&scorer);
+        og.build(&g);
+
+        // collapsed lines are weighted in both scorers
+        og.partnerLines();
+
+        for (const auto& comp :
+             util::graph::Algorithm::connectedComponents(og)) {
+          loom::optim::OptOrderCfg cfg(comp);
+          if (cfg.size() == 0) continue;
+
+          for (size_t i = 0; i < cfg.size(); i++) {
+            std::shuffle(cfg.perm(i), cfg.perm(i) + cfg.card(i), rng);
+          }
+
+          loom::optim::DeltaScorer delta(&scorer, comp, &cfg);
+
+          double full = scorer.getTotalScore(comp, cfg);
+          TEST(std::fabs(delta.getScore() - full), <, 1e-6);
+
+          // a sequence of swaps, each one checked against a full re-scoring
+          for (size_t k = 0; k < 100; k++) {
+            size_t id = rng() % cfg.size();
+            if (cfg.card(id) < 2) continue;
+
+            auto e = cfg.getEdge(id);
+            size_t p1 = rng() % cfg.card(id);
+            size_t p2 = rng() % cfg.card(id);
+            if (p1 == p2) continue;
+
+            double d = delta.getSwapDelta(e, p1, p2);
+            delta.swap(e, p1, p2);
+
+            double next = scorer.getTotalScore(comp, cfg);
+            TEST(std::fabs(next - full - d), <, 1e-6);
+            TEST(std::fabs(delta.getScore() - next), <, 1e-6);
+            full = next;
+          }
+        }
+      }
+    }
+  }
+
+  // component cache
+  {
+    char dirName[] = "/tmp/loomtest-XXXXXX";
+    TEST(mkdtemp(dirName), !=, (char*)0);
+    std::string dir = dirName;
+
+    shared::rendergraph::Penalties pensAdj = pens;
+    pensAdj.diffSegCrossPen = 100;
+
+    std::vector<std::string> fnames;
+    for (const auto& test : fileTests) fnames.push_back(test.fname);
+    fnames.push_back("../src/loom/tests/datasets/freiburg-tram.json");
+
+    for (const auto& fname : fnames) {
+      shared::rendergraph::RenderGraph g(5, 1, 5);
+
+      std::ifstream input;
+      input.open(fname);
+      g.readFromJson(&input, true);
+
+      loom::optim::OptGraphScorer scorer(pens);
+      loom::optim::OptGraphScorer scorerAdj(pensAdj);
+      loom::optim::ExhaustiveOptimizer exhausOptim(&baseCfg, pens);
+
+      loom::optim::CompCache cache(dir, exhausOptim.getName(), &scorer);
+      loom::optim::CompCache cacheGreedy(dir, "greedy", &scorer);
+      loom::optim::CompCache cacheAdj(dir, exhausOptim.getName(), &scorerAdj);
+
+      // a first optimization graph fills the cache
+      loom::optim::OptGraph og(&scorer);
+      og.build(&g);
+
+      size_t hits = 0;
+      shared::rendergraph::HierarOrderCfg all;
+
+      for (const auto& comp : util::graph::Algorithm::connectedComponents(og)) {
+        if (loom::optim::Optimizer::solutionSpaceSize(comp) > 50000) continue;
+
+        shared::rendergraph::HierarOrderCfg hc;
+        loom::optim::OptResStats stats;
+        exhausOptim.optimizeComp(&og, comp, &hc, 0, stats);
+        cache.put(comp, hc);
+
+        // components without a canonical form are never cached
+        shared::rendergraph::HierarOrderCfg back;
+        if (!cache.get(comp, &back)) continue;
+        TEST(back == hc, ==, true);
+
+        // the key covers the optimizer and the penalties
+        TEST(cacheGreedy.get(comp, &back), ==, false);
+        TEST(cacheAdj.get(comp, &back), ==, false);
+
+        for (const auto& e : hc) {
+          for (const auto& o : e.second) all[e.first][o.first] = o.second;
+        }
+        hits++;
+      }
+
+      // a second optimization graph of the same input has other node and
+      // edge addresses, but the same canonical components
+      loom::optim::OptGraph og2(&scorer);
+      og2.build(&g);
+
+      size_t hits2 = 0;
+      shared::rendergraph::HierarOrderCfg all2;
+
+      for (const auto& comp :
+           util::graph::Algorithm::connectedComponents(og2)) {
+        if (loom::optim::Optimizer::solutionSpaceSize(comp) > 50000) continue;
+
+        shared::rendergraph::HierarOrderCfg back;
+        if (!cache.get(comp, &back)) continue;
+        for (const auto& e : back) {
+          for (const auto& o : e.second) all2[e.first][o.first] = o.second;
+        }
+        hits2++;
+      }
+
+      TEST(hits2, ==, hits);
+      TEST(all2 == all, ==, true);
+    }
+
+    DIR* d = opendir(dir.c_str());
+    TEST(d, !=, (DIR*)0);
+    while (auto ent = readdir(d)) {
+      std::string name = ent->d_name;
+      if (name == "." || name == "..") continue;
+      unlink((dir + "/" + name).c_str());
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+  }
 }
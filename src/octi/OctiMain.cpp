@@ -111,10 +111,9 @@ std::vector<DPolygon> readObstacleFile(const std::string& p) {
 void drawComp(LineGraph& tg, double avgDist, util::json::Array& jsonScores,
               std::vector<LineGraph*>& resultGraphs,
               std::vector<BaseGraph*>& resultGridGraphs, TotalScore& totScore,
-              const config::Config& cfg) {
+              const config::Config& cfg, Octilinearizer& oct) {
   Drawing d;
 
-  Octilinearizer oct(cfg.baseGraphType);
   LineGraph* res = new LineGraph();
   BaseGraph* gg;
 
@@ -327,6 +326,9 @@ int main(int argc, char** argv) {
 
   TotalScore totScore;
 
+  // shared by all components and retries, to keep its search state
+  Octilinearizer oct(cfg.baseGraphType, cfg.heurJobs);
+
   size_t i = 0;
 
   for (auto& tg : comps) {
@@ -343,7 +345,7 @@ int main(int argc, char** argv) {
     while (tries < MAX_TRIES) {
       try {
         drawComp(tg, curDist, jsonScores, resultGraphs, resultGridGraphs,
-                 totScore, cfg);
+                 totScore, cfg, oct);
 
         break;
       } catch (const NoEmbeddingFoundExc& exc) {
@@ -3,6 +3,7 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <thread>
 #include "ilp/ILPGridOptimizer.h"
@@ -23,6 +24,12 @@
 #include "util/graph/BiDijkstra.h"
 #include "util/graph/Dijkstra.h"
 #include "util/log/Log.h"
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#define omp_get_thread_num() 0
+#endif
 
 using namespace octi;
 using namespace basegraph;
@@ -52,7 +59,7 @@ Score Octilinearizer::drawILP(
     const std::string& cacheDir, double cacheThreshold, int numThreads,
     octi::ilp::ILPStats* stats, const std::string& solverStr,
     const std::string& path) {
-  BaseGraph* gg;
+  BaseGraph* gg = 0;
   Drawing drawing;
 
   // always set density penality to 0, cannot by used in ILP and prevents proper
@@ -72,8 +79,14 @@ Score Octilinearizer::drawILP(
     LOGTO(DEBUG, std::cerr) << "Presolving finished.";
   } catch (const NoEmbeddingFoundExc& exc) {
     LOGTO(DEBUG, std::cerr) << "Presolve was not successful.";
-    gg = newBaseGraph(box, cg, gridSize, borderRad, hananIters, pensCpy);
-    gg->init();
+    if (gg) {
+      // a drawing with topology violations, start over on its grid graph
+      drawing.eraseFromGrid(gg);
+      gg->reset();
+    } else {
+      gg = newBaseGraph(box, cg, gridSize, borderRad, hananIters, pensCpy);
+      gg->init();
+    }
     drawing = Drawing(gg);
   }
 
@@ -125,12 +138,15 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
                            double enfGeoPen, size_t hananIters,
                            const std::vector<Polygon<double>>& obstacles,
                            size_t locSearchIters, size_t abortAfter) {
-  size_t jobs = 4;
+  // each job works on a grid graph of its own, no need for more jobs than
+  // there are nodes to move in the local search
+  size_t jobs = std::max<size_t>(1, std::min(numJobs(), cg.getNds().size()));
   std::vector<BaseGraph*> ggs(jobs);
+  if (_aStars.size() < jobs) _aStars.resize(jobs);
 
-  LOGTO(DEBUG, std::cerr) << "Creating grid graphs... ";
+  LOGTO(DEBUG, std::cerr) << "Creating " << jobs << " grid graphs... ";
   T_START(ggraph);
-#pragma omp parallel for
+#pragma omp parallel for num_threads(jobs)
   for (size_t i = 0; i < jobs; i++) {
     ggs[i] = newBaseGraph(box, cg, gridSize, borderRad, hananIters, pens);
     ggs[i]->init();
@@ -144,6 +160,10 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   size_t LOCAL_SEARCH_ITERS = locSearchIters;
   double CONVERGENCE_THRESHOLD = 0.05;
 
+  // relative slack on the local search cutoff, so that moves scoring equal
+  // to the best one so far survive the float rounding of the path costs
+  double TIE_SLACK = 1e-4;
+
   GeoPensMap enfGeoPens;
   const GeoPensMap* geoPens = 0;
 
@@ -185,47 +205,47 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
     methods = {orderMethod};
   }
 
-  std::vector<std::vector<OrderMethod>> batches(jobs);
-  for (size_t i = 0; i < methods.size(); i++) {
-    batches[i % jobs].push_back(methods[i]);
-  }
-
   LOGTO(DEBUG, std::cerr) << "Searching initial drawing... ";
 
-#pragma omp parallel for
-  for (size_t btch = 0; btch < jobs; btch++) {
-    for (OrderMethod meth : batches[btch]) {
-      T_START(draw);
-      Drawing drawingCp(ggs[btch]);
+  // the order methods are handed out one at a time, each to the next free job
+#pragma omp parallel for num_threads(jobs) schedule(dynamic, 1)
+  for (size_t i = 0; i < methods.size(); i++) {
+    OrderMethod meth = methods[i];
+    auto gg = ggs[omp_get_thread_num()];
+
+    T_START(draw);
+    Drawing drawingCp(gg);
 
-      // get a randomized ordering
-      std::vector<CombEdge*> iterOrder = getOrdering(cg, meth);
+    // get a randomized ordering
+    std::vector<CombEdge*> iterOrder = getOrdering(cg, meth);
 
-      double bestScoreSoFar = 0;
+    double bestScoreSoFar = 0;
 
 #pragma omp critical
-      { bestScoreSoFar = drawing.score(); }
+    { bestScoreSoFar = drawing.score(); }
 
-      auto status = draw(iterOrder, ggs[btch], &drawingCp, bestScoreSoFar,
-                         maxGrDist, geoPens, abortAfter);
+    auto status = draw(iterOrder, gg, &drawingCp, bestScoreSoFar, maxGrDist,
+                       geoPens, abortAfter);
 
-      drawingCp.eraseFromGrid(ggs[btch]);
+    drawingCp.eraseFromGrid(gg);
 
-      statLine(status, std::string("Try ") + std::to_string(meth), drawingCp,
-               T_STOP(draw), "*");
+    statLine(status, std::string("Try ") + std::to_string(meth), drawingCp,
+             T_STOP(draw), "*");
 
 #pragma omp critical
-      {
-        if (status == DRAWN && drawingCp.score() < drawing.score()) {
-          drawing = drawingCp;
-        } else {
-          drawingCp.crumble();
-        }
+    {
+      if (status == DRAWN && drawingCp.score() < drawing.score()) {
+        drawing = drawingCp;
+      } else {
+        drawingCp.crumble();
       }
     }
   }
 
-  if (drawing.score() == INF) throw NoEmbeddingFoundExc();
+  if (drawing.score() == INF) {
+    for (auto gg : ggs) delete gg;
+    throw NoEmbeddingFoundExc();
+  }
 
   LOGTO(DEBUG, std::cerr) << "Done.";
 
@@ -240,85 +260,112 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   // dont use local search if abortAfter is set
   if (abortAfter != std::numeric_limits<size_t>::max()) LOCAL_SEARCH_ITERS = 0;
 
-  std::vector<std::vector<CombNode*>> batchesLoc(jobs);
-  size_t c = 0;
+  // nodes which may be moved, those with the most adjacent edges are the most
+  // expensive to re-route and come first, so no job is left with them at the
+  // end of an iteration
+  std::vector<CombNode*> locNds;
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
-    batchesLoc[c % jobs].push_back(nd);
-    c++;
+    locNds.push_back(nd);
   }
+  std::stable_sort(locNds.begin(), locNds.end(),
+                   [](const CombNode* a, const CombNode* b) {
+                     return a->getDeg() > b->getDeg();
+                   });
 
   for (; iters < LOCAL_SEARCH_ITERS; iters++) {
     T_START(iter);
     std::vector<Drawing> bestFrIters(jobs);
 
-#pragma omp parallel for
-    for (size_t btch = 0; btch < jobs; btch++) {
-      for (auto a : batchesLoc[btch]) {
-        Drawing drawingCp = drawing;
+    // index of the moved node which led to the best drawing of each job, ties
+    // are broken by this index to not depend on the scheduling of the jobs
+    std::vector<size_t> bestFrItersNd(jobs, locNds.size());
 
-        // use the batches grid graph
-        drawingCp.setBaseGraph(ggs[btch]);
+    // working copies of the drawing for each job, moves are tried on them and
+    // rolled back afterwards
+    std::vector<Drawing> works(jobs, drawing);
+    for (size_t i = 0; i < jobs; i++) works[i].setBaseGraph(ggs[i]);
 
-        // reverting a
-        std::vector<CombEdge*> test;
-        for (auto ce : a->getAdjList()) {
-          test.push_back(ce);
+#pragma omp parallel for num_threads(jobs) schedule(dynamic, 1)
+    for (size_t i = 0; i < locNds.size(); i++) {
+      auto a = locNds[i];
+      size_t btch = omp_get_thread_num();
+      Drawing& drawingCp = works[btch];
 
-          drawingCp.eraseFromGrid(ce, ggs[btch]);
-          drawingCp.erase(ce);
-        }
+      auto unmoved = drawingCp.checkpoint();
 
-        drawingCp.erase(a);
-        ggs[btch]->unSettleNd(a);
+      // reverting a
+      std::vector<CombEdge*> test;
+      for (auto ce : a->getAdjList()) {
+        test.push_back(ce);
 
-        for (size_t pos = 0; pos < ggs[btch]->maxDeg() + 1; pos++) {
-          SettledPos p;
+        drawingCp.eraseFromGrid(ce, ggs[btch]);
+        drawingCp.erase(ce);
+      }
+
+      drawingCp.erase(a);
+      ggs[btch]->unSettleNd(a);
 
-          auto n = ggs[btch]->neigh(drawing.getGrNd(a), pos);
-          if (!n) continue;
+      for (size_t pos = 0; pos < ggs[btch]->maxDeg() + 1; pos++) {
+        SettledPos p;
 
-          p[a] = n;
+        auto n = ggs[btch]->neigh(drawing.getGrNd(a), pos);
+        if (!n) continue;
 
-          if (restrLocSearch) {
-            // dont try positions outside the move radius for consistency with
-            // ILP approach
-            double gridD = dist(*a->pl().getGeom(), *n->pl().getGeom());
-            double maxDis = ggs[btch]->getCellSize() * maxGrDist;
-            if (gridD >= maxDis) continue;
-          }
+        p[a] = n;
+
+        if (restrLocSearch) {
+          // dont try positions outside the move radius for consistency with
+          // ILP approach
+          double gridD = dist(*a->pl().getGeom(), *n->pl().getGeom());
+          double maxDis = ggs[btch]->getCellSize() * maxGrDist;
+          if (gridD >= maxDis) continue;
+        }
 
-          Drawing run = drawingCp;
+        auto unplaced = drawingCp.checkpoint();
 
-          // we can use bestFromIter.score() as the limit for the shortest
-          // path computation, as we can already do at least as good.
-          auto error =
-              draw(test, p, ggs[btch], &run, bestFrIters[btch].score(),
-                   maxGrDist, geoPens, std::numeric_limits<size_t>::max());
+        // we can use bestFromIter.score() as the limit for the shortest
+        // path computation, as we can already do at least as good. Moves
+        // with an equal score are kept for the tie break below, otherwise
+        // the chosen move would depend on which job tried it first.
+        double cutoff = bestFrIters[btch].score();
+        cutoff += (std::fabs(cutoff) + 1) * TIE_SLACK;
 
-          if (!error && bestFrIters[btch].score() > run.score()) {
-            bestFrIters[btch] = run;
-          }
+        auto error = draw(test, p, ggs[btch], &drawingCp, cutoff, maxGrDist,
+                          geoPens, std::numeric_limits<size_t>::max());
 
-          // reset grid
-          for (auto ce : a->getAdjList()) run.eraseFromGrid(ce, ggs[btch]);
-          if (ggs[btch]->isSettled(a)) ggs[btch]->unSettleNd(a);
+        if (!error && (bestFrIters[btch].score() > drawingCp.score() ||
+                       (bestFrIters[btch].score() == drawingCp.score() &&
+                        i < bestFrItersNd[btch]))) {
+          bestFrIters[btch] = drawingCp;
+          bestFrItersNd[btch] = i;
         }
 
-        ggs[btch]->settleNd(const_cast<GridNode*>(ggs[btch]->getGrNdById(
-                                drawing.getGrNd(a)->pl().getId())),
-                            a);
+        // reset grid
+        for (auto ce : a->getAdjList()) drawingCp.eraseFromGrid(ce, ggs[btch]);
+        if (ggs[btch]->isSettled(a)) ggs[btch]->unSettleNd(a);
 
-        // re-settle edges
-        for (auto ce : a->getAdjList()) drawing.applyToGrid(ce, ggs[btch]);
+        drawingCp.rollback(unplaced);
       }
+
+      drawingCp.rollback(unmoved);
+
+      ggs[btch]->settleNd(const_cast<GridNode*>(ggs[btch]->getGrNdById(
+                              drawing.getGrNd(a)->pl().getId())),
+                          a);
+
+      // re-settle edges
+      for (auto ce : a->getAdjList()) drawing.applyToGrid(ce, ggs[btch]);
     }
 
     size_t bestCore = 0;
     double bestScore = std::numeric_limits<double>::infinity();
+    size_t bestNd = locNds.size();
     for (size_t i = 0; i < jobs; i++) {
-      if (bestFrIters[i].score() < bestScore) {
+      if (bestFrIters[i].score() < bestScore ||
+          (bestFrIters[i].score() == bestScore && bestFrItersNd[i] < bestNd)) {
         bestScore = bestFrIters[i].score();
+        bestNd = bestFrItersNd[i];
         bestCore = i;
       }
     }
@@ -346,6 +393,9 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
                           << ", mv costs: " << fullScore.move
                           << ", dense costs: " << fullScore.dense;
 
+  // only the first grid graph is handed out
+  for (size_t i = 1; i < jobs; i++) delete ggs[i];
+
   *retGg = ggs[0];
   *dOut = drawing;
 
@@ -481,15 +531,16 @@ Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& ord,
     GridNode* frGrNd = 0;
 
     auto heur = gg->getHeur(toGrNds);
+    auto& aStar = _aStars[omp_get_thread_num()];
 
     if (geoPensMap) {
       // init cost function with geo distance penalties
       auto cost = GridCostGeoPen(cutoff + costOffsetTo + costOffsetFrom,
                                  &geoPensMap->find(cmbEdg)->second);
-      Dijkstra::shortestPath(frGrNds, toGrNds, cost, *heur, &eL, &nL);
+      route(&aStar, gg, frGrNds, toGrNds, cost, heur, &eL, &nL);
     } else {
       auto cost = GridCost(cutoff + costOffsetTo + costOffsetFrom);
-      Dijkstra::shortestPath(frGrNds, toGrNds, cost, *heur, &eL, &nL);
+      route(&aStar, gg, frGrNds, toGrNds, cost, heur, &eL, &nL);
     }
 
     delete heur;
@@ -709,3 +760,32 @@ size_t Octilinearizer::maxNodeDeg() const {
       return 8;
   }
 }
+
+// _____________________________________________________________________________
+size_t Octilinearizer::numJobs() const {
+  if (_jobs) return _jobs;
+  return std::max(1, omp_get_max_threads());
+}
+
+// _____________________________________________________________________________
+template <typename C>
+bool Octilinearizer::route(
+    GridAStar* aStar, const BaseGraph* gg, const std::set<GridNode*>& from,
+    const std::set<GridNode*>& to, const C& costFunc,
+    const Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>* heur,
+    GrEdgList* resEdges, GrNdList* resNodes) {
+  if (auto h = dynamic_cast<const GridGraphHeur<OctiGridGraph>*>(heur)) {
+    return aStar->shortestPath(gg, from, to, costFunc, *h, resEdges, resNodes);
+  }
+
+  if (auto h = dynamic_cast<const GridGraphHeur<GridGraph>*>(heur)) {
+    return aStar->shortestPath(gg, from, to, costFunc, *h, resEdges, resNodes);
+  }
+
+  if (auto h = dynamic_cast<const PseudoOrthoRadialGraphHeur*>(heur)) {
+    return aStar->shortestPath(gg, from, to, costFunc, *h, resEdges, resNodes);
+  }
+
+  return aStar->shortestPath(gg, from, to, costFunc, *heur, resEdges,
+                             resNodes);
+}
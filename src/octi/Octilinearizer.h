@@ -10,6 +10,7 @@
 
 #include "ilp/ILPGridOptimizer.h"
 #include "octi/basegraph/BaseGraph.h"
+#include "octi/basegraph/GridAStar.h"
 #include "octi/basegraph/GridGraph.h"
 #include "octi/combgraph/CombGraph.h"
 #include "octi/combgraph/Drawing.h"
@@ -130,7 +131,8 @@ struct GraphMeasures {
   size_t maxDeg;
 };
 
-struct GridCost
+// final, to allow inlining the calls in GridAStar
+struct GridCost final
     : public util::graph::Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
   GridCost(float inf) : _inf(inf) {}
   virtual float operator()(const GridNode* from, const GridEdge* e,
@@ -145,7 +147,7 @@ struct GridCost
   virtual float inf() const { return _inf; }
 };
 
-struct GridCostGeoPen
+struct GridCostGeoPen final
     : public Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
   GridCostGeoPen(float inf, const GeoPens* geoPens)
       : _inf(inf), _geoPens(geoPens) {}
@@ -157,11 +159,8 @@ struct GridCostGeoPen
     // ignore geopens for secondary edges
     if (e->pl().isSecondary()) return e->pl().cost();
 
-    auto i = (*_geoPens).find(e->pl().getId());
-    if (i != _geoPens->end()) return e->pl().cost() + i->second;
-
-    // if no geopen was present for grid edge, we assume SOFT_INF penalty
-    return e->pl().cost() + octi::basegraph::SOFT_INF;
+    // if no geopen was present for grid edge, this is a SOFT_INF penalty
+    return e->pl().cost() + _geoPens->get(e->pl().getId());
   }
 
   float _inf;
@@ -173,7 +172,12 @@ struct GridCostGeoPen
 class Octilinearizer {
  public:
   Octilinearizer(basegraph::BaseGraphType baseGraphType)
-      : _baseGraphType(baseGraphType) {}
+      : _baseGraphType(baseGraphType), _jobs(0) {}
+
+  // jobs is the number of parallel jobs used by the heuristic, 0 means one
+  // per processor
+  Octilinearizer(basegraph::BaseGraphType baseGraphType, size_t jobs)
+      : _baseGraphType(baseGraphType), _jobs(jobs) {}
 
   Score draw(const CombGraph& cg, const util::geo::DBox& box, LineGraph* out,
              basegraph::BaseGraph** gg, Drawing* d, const Penalties& pens,
@@ -196,6 +200,23 @@ class Octilinearizer {
 
  private:
   basegraph::BaseGraphType _baseGraphType;
+  size_t _jobs;
+
+  // edge routing searches, one per job
+  std::vector<basegraph::GridAStar> _aStars;
+
+  size_t numJobs() const;
+
+  // calls aStar with the concrete type of heur, so that the heuristic is not
+  // evaluated through the virtual HeurFunc interface
+  template <typename C>
+  static bool route(
+      basegraph::GridAStar* aStar, const basegraph::BaseGraph* gg,
+      const std::set<GridNode*>& from, const std::set<GridNode*>& to,
+      const C& costFunc,
+      const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
+          heur,
+      GrEdgList* resEdges, GrNdList* resNodes);
 
   basegraph::BaseGraph* newBaseGraph(const util::geo::DBox& bbox,
                                      const CombGraph& cg, double cellSize,
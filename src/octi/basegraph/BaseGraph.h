@@ -4,9 +4,11 @@
 #ifndef OCTI_BASEGRAPH_BASEGRAPH_H_
 #define OCTI_BASEGRAPH_BASEGRAPH_H_
 
+#include <algorithm>
 #include <queue>
 #include <set>
 #include <unordered_map>
+#include <vector>
 #include "octi/basegraph/GridEdgePL.h"
 #include "octi/basegraph/GridNodePL.h"
 #include "octi/basegraph/NodeCost.h"
@@ -49,8 +51,55 @@ typedef util::graph::Edge<GridNodePL, GridEdgePL> GridEdge;
 typedef std::pair<const GridEdge*, const GridEdge*> EdgPair;
 typedef std::vector<std::pair<EdgPair, EdgPair>> CrossEdgPairs;
 
-// edge-id -> pen
-typedef std::unordered_map<uint32_t, float> GeoPens;
+// edge-id -> pen, all edges which were not written have a pen of SOFT_INF.
+// Grid edge ids run row by row over the whole grid, so the id range written
+// for a comb edge spans about (box width / grid width) * the grid's edge count
+// if the comb edge's padded box is narrow. The pens are stored densely over
+// that range only if it is at most MAX_SPARSITY times the number of pens,
+// otherwise in a hash map.
+class GeoPens {
+ public:
+  const static uint32_t MAX_SPARSITY = 8;
+
+  GeoPens() : _first(0) {}
+  explicit GeoPens(const std::vector<std::pair<uint32_t, float>>& pens)
+      : _first(0) {
+    if (pens.empty()) return;
+    uint32_t last = pens.front().first;
+    _first = last;
+    for (const auto& p : pens) {
+      _first = std::min(_first, p.first);
+      last = std::max(last, p.first);
+    }
+
+    if (last - _first >= MAX_SPARSITY * pens.size()) {
+      _sparse.insert(pens.begin(), pens.end());
+      return;
+    }
+
+    _pens.resize(last - _first + 1, SOFT_INF);
+    for (const auto& p : pens) _pens[p.first - _first] = p.second;
+  }
+
+  float get(uint32_t edgeId) const {
+    if (_sparse.size()) {
+      auto i = _sparse.find(edgeId);
+      if (i != _sparse.end()) return i->second;
+      return SOFT_INF;
+    }
+
+    // ids below _first wrap around
+    uint32_t i = edgeId - _first;
+    if (i < _pens.size()) return _pens[i];
+    return SOFT_INF;
+  }
+
+ private:
+  uint32_t _first;
+  std::vector<float> _pens;
+  std::unordered_map<uint32_t, float> _sparse;
+};
+
 typedef std::map<const CombEdge*, GeoPens> GeoPensMap;
 
 struct Candidate {
@@ -146,6 +195,10 @@ class BaseGraph : public DirGraph<GridNodePL, GridEdgePL> {
   virtual void addObstacle(const util::geo::Polygon<double>& obst) = 0;
   virtual PolyLine<double> geomFromPath(
       const std::vector<std::pair<size_t, size_t>>& res) const = 0;
+
+  // bend costs between ports i and j of all grid nodes at i * maxDeg() + j,
+  // 0 if they differ between grid nodes and have to be read from the edges
+  virtual const float* getPortBendCosts() const = 0;
 };
 }  // namespace basegraph
 }  // namespace octi
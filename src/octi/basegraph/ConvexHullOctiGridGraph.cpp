@@ -52,6 +52,7 @@ void ConvexHullOctiGridGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -75,6 +76,7 @@ GridNode* ConvexHullOctiGridGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   _ndIdx[x * _grid.getYHeight() + y] = _nds.size();
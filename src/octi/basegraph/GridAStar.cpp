@@ -0,0 +1,83 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cstring>
+#include "octi/basegraph/GridAStar.h"
+
+using octi::basegraph::GridAStar;
+using octi::basegraph::GridNode;
+using octi::basegraph::GridEdge;
+
+// _____________________________________________________________________________
+void GridAStar::newSearch() {
+  for (auto& b : _buckets) b.clear();
+  _size = 0;
+  _last = 0;
+  _gen++;
+
+  if (_gen == 0) {
+    // the generation counter wrapped, old states would look current
+    for (auto& st : _nds) st.reached = st.settled = st.target = 0;
+    _gen = 1;
+  }
+}
+
+// _____________________________________________________________________________
+GridAStar::NdState& GridAStar::state(const GridNode* n) {
+  size_t id = n->pl().getId();
+  if (id >= _nds.size()) _nds.resize(id + 1, NdState{0, 0, 0, 0, 0, 0});
+  return _nds[id];
+}
+
+// _____________________________________________________________________________
+GridEdge* GridAStar::edg(const GridNode* a, const GridNode* b) {
+  for (auto e : a->getAdjListOut()) {
+    if (e->getTo() == b) return e;
+  }
+  return 0;
+}
+
+// _____________________________________________________________________________
+size_t GridAStar::bucket(uint32_t key) const {
+  if (key == _last) return 0;
+  return 32 - __builtin_clz(key ^ _last);
+}
+
+// _____________________________________________________________________________
+void GridAStar::push(GridNode* n, GridNode* pred, float d, float f) {
+  // for non-negative floats, the order of the bit patterns is the order of
+  // the values
+  uint32_t key = 0;
+  if (f > 0) std::memcpy(&key, &f, sizeof(key));
+
+  // with an inconsistent heuristic, f may drop below the last popped value,
+  // the entry is then due next anyway
+  if (key < _last) key = _last;
+
+  _buckets[bucket(key)].push_back({key, f, d, n, pred});
+  _size++;
+}
+
+// _____________________________________________________________________________
+GridAStar::QueueEntry GridAStar::pop() {
+  if (_buckets[0].empty()) {
+    size_t i = 1;
+    while (_buckets[i].empty()) i++;
+
+    uint32_t min = _buckets[i].front().key;
+    for (const auto& e : _buckets[i]) {
+      if (e.key < min) min = e.key;
+    }
+
+    // all entries of bucket i now differ from _last in a lower bit
+    _last = min;
+    for (const auto& e : _buckets[i]) _buckets[bucket(e.key)].push_back(e);
+    _buckets[i].clear();
+  }
+
+  auto ret = _buckets[0].back();
+  _buckets[0].pop_back();
+  _size--;
+  return ret;
+}
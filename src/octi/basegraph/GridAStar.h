@@ -0,0 +1,200 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_BASEGRAPH_GRIDASTAR_H_
+#define OCTI_BASEGRAPH_GRIDASTAR_H_
+
+#include <cstdint>
+#include <set>
+#include <vector>
+#include "octi/basegraph/BaseGraph.h"
+
+namespace octi {
+namespace basegraph {
+
+typedef util::graph::EList<GridNodePL, GridEdgePL> GridEdgList;
+typedef util::graph::NList<GridNodePL, GridEdgePL> GridNdList;
+
+// A* search for routing comb edges through a base graph. Finds paths of the
+// same cost as util::graph::Dijkstra::shortestPath() if the heuristic is
+// consistent (ties may be broken differently), but the cost and
+// heuristic functions are template parameters, the per node search state is
+// kept in arrays indexed by the node id which are invalidated by a generation
+// counter instead of being cleared, and the queue is a radix heap over the
+// bit patterns of the (non-negative) float costs.
+//
+// The sink and bend edges of a port are not read from its adjacency list.
+// Bends are taken from the ports of its grid node and the bend costs shared
+// by all grid nodes, the sink edge is only followed into a target. The cost
+// function is thus only evaluated for edges between grid nodes and for
+// sink edges.
+//
+// An instance keeps its arrays between searches, and must not be used by
+// more than one thread at a time.
+class GridAStar {
+ public:
+  GridAStar() : _gen(0), _last(0), _size(0) {}
+
+  // returns true if a path was found, resNodes then starts with the target
+  // node, resEdges with the edge leading to it (as in util's Dijkstra)
+  template <typename C, typename H>
+  bool shortestPath(const BaseGraph* gg, const std::set<GridNode*>& from,
+                    const std::set<GridNode*>& to, const C& costFunc,
+                    const H& heurFunc, GridEdgList* resEdges,
+                    GridNdList* resNodes);
+
+ private:
+  struct NdState {
+    // generation in which the node was last reached, settled and marked as
+    // a target
+    uint32_t reached, settled, target;
+    float d, h;
+    GridNode* pred;
+  };
+
+  struct QueueEntry {
+    // key is the bit pattern of f, never below the last popped key
+    uint32_t key;
+    float f, d;
+    GridNode* n;
+    GridNode* pred;
+  };
+
+  uint32_t _gen;
+  std::vector<NdState> _nds;
+
+  // radix heap, bucket i > 0 holds keys whose highest bit differing from
+  // _last is bit i - 1, bucket 0 those equal to _last
+  std::vector<QueueEntry> _buckets[33];
+  uint32_t _last;
+  size_t _size;
+
+  void newSearch();
+  NdState& state(const GridNode* n);
+
+  // the edge from a to b
+  static GridEdge* edg(const GridNode* a, const GridNode* b);
+
+  void push(GridNode* n, GridNode* pred, float d, float f);
+  QueueEntry pop();
+  size_t bucket(uint32_t key) const;
+};
+
+// _____________________________________________________________________________
+template <typename C, typename H>
+bool GridAStar::shortestPath(const BaseGraph* gg,
+                             const std::set<GridNode*>& from,
+                             const std::set<GridNode*>& to, const C& costFunc,
+                             const H& heurFunc, GridEdgList* resEdges,
+                             GridNdList* resNodes) {
+  if (from.size() == 0 || to.size() == 0) return false;
+
+  newSearch();
+
+  const float inf = costFunc.inf();
+  const float* bendCosts = gg->getPortBendCosts();
+  const size_t deg = gg->maxDeg();
+
+  for (auto n : to) state(n).target = _gen;
+
+  for (auto n : from) {
+    auto& st = state(n);
+    if (st.reached == _gen) continue;
+    st.reached = _gen;
+    st.d = 0;
+    st.h = 0;
+    push(n, 0, 0, 0);
+  }
+
+  QueueEntry cur;
+
+  auto relax = [&](GridNode* toNd, float d) {
+    if (inf <= d) return;
+
+    auto& st = state(toNd);
+    if (st.settled == _gen) return;
+
+    if (st.reached == _gen) {
+      // an equal or shorter distance is already queued for this node
+      if (st.d <= d) return;
+    } else {
+      // the heuristic only depends on the node, evaluate it once
+      st.reached = _gen;
+      st.h = heurFunc(toNd, to);
+    }
+
+    st.d = d;
+    float f = d + st.h;
+
+    // would only be popped once the cutoff has been reached
+    if (inf <= f) return;
+
+    push(toNd, cur.n, d, f);
+  };
+
+  while (_size) {
+    cur = pop();
+
+    if (inf <= cur.f) return false;
+
+    auto& curSt = state(cur.n);
+    if (curSt.settled == _gen) continue;
+    curSt.settled = _gen;
+    curSt.pred = cur.pred;
+
+    if (curSt.target == _gen) {
+      GridNode* n = cur.n;
+      while (true) {
+        if (resNodes) resNodes->push_back(n);
+        GridNode* pred = state(n).pred;
+        if (!pred) break;
+        if (resEdges) resEdges->push_back(edg(pred, n));
+        n = pred;
+      }
+      return true;
+    }
+
+    GridNode* par = cur.n->pl().getParent();
+
+    if (!bendCosts || par == cur.n) {
+      // grid nodes are only expanded as sources
+      for (auto e : cur.n->getAdjListOut()) {
+        relax(e->getTo(), cur.d + costFunc(cur.n, e, e->getTo()));
+      }
+      continue;
+    }
+
+    const GridPorts* ports = par->pl().getPorts();
+    size_t i = 0;
+    while (ports->ports[i] != cur.n) i++;
+
+    // the sink edges of all other grid nodes are closed
+    if (state(par).target == _gen) {
+      relax(par, cur.d + costFunc(cur.n, edg(cur.n, par), par));
+    }
+
+    // bends are soft closed together with their grid node
+    bool closed = par->pl().isClosed();
+
+    for (size_t j = 0; j < deg; j++) {
+      GridNode* port = ports->ports[j];
+      if (!port || (ports->noBend >> (i * 8 + j)) & 1) continue;
+      double c = bendCosts[i * deg + j];
+      if (closed) c += SOFT_INF;
+      relax(port, cur.d + static_cast<float>(c));
+    }
+
+    if (ports->out[i]) {
+      GridEdge* e = ports->out[i];
+      relax(e->getTo(), cur.d + costFunc(cur.n, e, e->getTo()));
+    }
+  }
+
+  return false;
+}
+
+}  // namespace basegraph
+}  // namespace octi
+
+#endif  // OCTI_BASEGRAPH_GRIDASTAR_H_
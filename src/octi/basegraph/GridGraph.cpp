@@ -50,6 +50,9 @@ GridGraph::GridGraph(const DBox& bbox, double cellSize, double spacer,
 
 // _____________________________________________________________________________
 void GridGraph::init() {
+  // each cell is a grid node plus its ports
+  _nds.reserve(_grid.getXWidth() * _grid.getYHeight() * (maxDeg() + 1));
+
   // write nodes
   for (size_t x = 0; x < _grid.getXWidth(); x++) {
     for (size_t y = 0; y < _grid.getYHeight(); y++) {
@@ -77,6 +80,7 @@ void GridGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -199,6 +203,8 @@ void GridGraph::writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
   box = util::geo::pad(box, sqrt(SOFT_INF / pen) * getCellSize());
   _grid.get(box, &neighs);
 
+  std::vector<std::pair<uint32_t, float>> pens;
+
   for (auto grNdA : neighs) {
     for (size_t i = 0; i < maxDeg(); i++) {
       auto grNeigh = neigh(grNdA->pl().getX(), grNdA->pl().getY(), i);
@@ -221,9 +227,11 @@ void GridGraph::writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
 
       d *= pen * d;
 
-      if (d <= SOFT_INF) (*target)[ce][ge->pl().getId()] = d;
+      if (d <= SOFT_INF) pens.emplace_back(ge->pl().getId(), d);
     }
   }
+
+  (*target)[ce] = GeoPens(pens);
 }
 
 // _____________________________________________________________________________
@@ -584,7 +592,7 @@ double GridGraph::heurCost(int64_t xa, int64_t ya, int64_t xb,
 // _____________________________________________________________________________
 const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
 GridGraph::getHeur(const std::set<GridNode*>& to) const {
-  return new GridGraphHeur(this, to);
+  return new GridGraphHeur<GridGraph>(this, to);
 }
 
 // _____________________________________________________________________________
@@ -728,6 +736,7 @@ GridNode* GridGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   n->pl().setSink();
@@ -792,6 +801,74 @@ GridNode* GridGraph::writeNd(size_t x, size_t y) {
   return n;
 }
 
+// _____________________________________________________________________________
+GridPorts* GridGraph::newPorts() {
+  _ports.push_back(GridPorts());
+  return &_ports.back();
+}
+
+// _____________________________________________________________________________
+void GridGraph::indexPorts() {
+  size_t deg = maxDeg();
+  std::vector<bool> known(deg * deg, false);
+  _portBendCosts.assign(deg * deg, INF);
+
+  bool shared = true;
+
+  for (auto& ports : _ports) {
+    ports.noBend = 0;
+    for (size_t i = 0; i < deg; i++) {
+      ports.out[i] = 0;
+      auto port = ports.ports[i];
+      if (!port) continue;
+
+      uint64_t bends = 0;
+
+      for (auto e : port->getAdjListOut()) {
+        auto to = e->getTo();
+        if (to == port->pl().getParent()) continue;
+
+        if (to->pl().getParent() != port->pl().getParent()) {
+          // more than one edge leaving a port is not indexed
+          if (ports.out[i]) shared = false;
+          ports.out[i] = e;
+          continue;
+        }
+
+        size_t j = 0;
+        while (j < deg && ports.ports[j] != to) j++;
+        if (j == deg) {
+          shared = false;
+          continue;
+        }
+
+        float c = e->pl().rawCost();
+        if (c == INF) continue;
+
+        bends |= uint64_t(1) << (i * 8 + j);
+
+        if (!known[i * deg + j]) {
+          known[i * deg + j] = true;
+          _portBendCosts[i * deg + j] = c;
+        } else if (_portBendCosts[i * deg + j] != c) {
+          shared = false;
+        }
+      }
+
+      // bends without an edge or with an infinite cost
+      ports.noBend |= ~bends & (uint64_t(0xff) << (i * 8));
+    }
+  }
+
+  if (!shared) _portBendCosts.clear();
+}
+
+// _____________________________________________________________________________
+const float* GridGraph::getPortBendCosts() const {
+  if (_portBendCosts.empty()) return 0;
+  return _portBendCosts.data();
+}
+
 // _____________________________________________________________________________
 double GridGraph::ndMovePen(const CombNode* cbNd, const GridNode* grNd) const {
   // the move penalty has to be at least the max cost of saving a single
@@ -5,6 +5,7 @@
 #ifndef OCTI_BASEGRAPH_GRIDGRAPH_H_
 #define OCTI_BASEGRAPH_GRIDGRAPH_H_
 
+#include <deque>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -100,6 +101,8 @@ class GridGraph : public BaseGraph {
 
   virtual void prunePorts();
 
+  virtual const float* getPortBendCosts() const;
+
  protected:
   util::geo::DBox _bbox;
   Penalties _c;
@@ -113,6 +116,12 @@ class GridGraph : public BaseGraph {
   // encoding portable IDs for each node
   std::vector<GridNode*> _nds;
 
+  // ports of all grid nodes, a deque does not move them when growing
+  std::deque<GridPorts> _ports;
+
+  // bend costs shared by all grid nodes, empty if there are none
+  std::vector<float> _portBendCosts;
+
   // edge id counter
   size_t _edgeCount;
 
@@ -134,6 +143,13 @@ class GridGraph : public BaseGraph {
 
   virtual GridNode* writeNd(size_t x, size_t y);
 
+  // empty ports for a grid node
+  GridPorts* newPorts();
+
+  // write the outgoing edge of each port and the impossible bends into the
+  // ports of all grid nodes, called once the base graph is complete
+  void indexPorts();
+
   virtual GridNode* neigh(size_t cx, size_t cy, size_t i) const;
 
   virtual void getSettledAdjEdgs(GridNode* n, CombNode* origNd,
@@ -163,10 +179,12 @@ struct GridCost
   virtual float inf() const { return _inf; }
 };
 
-struct GridGraphHeur
+// G is the graph type whose heurCost() is used, it is called without a
+// virtual dispatch
+template <typename G>
+struct GridGraphHeur final
     : public util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float> {
-  GridGraphHeur(const basegraph::GridGraph* g, const std::set<GridNode*>& to)
-      : g(g) {
+  GridGraphHeur(const G* g, const std::set<GridNode*>& to) : g(g) {
     cheapestSink = std::numeric_limits<float>::infinity();
 
     for (auto n : to) {
@@ -197,16 +215,16 @@ struct GridGraphHeur
     float ret = std::numeric_limits<float>::infinity();
 
     for (size_t i = 0; i < hull.size(); i += 2) {
-      float tmp = g->heurCost(from->pl().getParent()->pl().getX(),
-                              from->pl().getParent()->pl().getY(), hull[i],
-                              hull[i + 1]);
+      float tmp = g->G::heurCost(from->pl().getParent()->pl().getX(),
+                                 from->pl().getParent()->pl().getY(), hull[i],
+                                 hull[i + 1]);
       if (tmp < ret) ret = tmp;
     }
 
     return ret + cheapestSink;
   }
 
-  const octi::basegraph::BaseGraph* g;
+  const G* g;
   std::vector<size_t> hull;
   float cheapestSink;
 };
@@ -2,6 +2,8 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <cassert>
+
 #include "octi/basegraph/GridNodePL.h"
 
 using util::geo::Point;
@@ -9,7 +11,12 @@ using namespace octi::basegraph;
 
 // _____________________________________________________________________________
 GridNodePL::GridNodePL(Point<double> pos)
-    : _pos(pos), _parent(0), _closed(false), _sink(false), _settled(false) {}
+    : _pos(pos),
+      _parent(0),
+      _ports(0),
+      _closed(false),
+      _sink(false),
+      _settled(false) {}
 
 // _____________________________________________________________________________
 const Point<double>* GridNodePL::getGeom() const { return &_pos; }
@@ -34,10 +41,22 @@ GridNode* GridNodePL::getParent() const { return _parent; }
 void GridNodePL::setParent(GridNode* n) { _parent = n; }
 
 // _____________________________________________________________________________
-GridNode* GridNodePL::getPort(size_t i) const { return _ports[i]; }
+GridNode* GridNodePL::getPort(size_t i) const {
+  if (!_ports) return 0;
+  return _ports->ports[i];
+}
+
+// _____________________________________________________________________________
+void GridNodePL::setPort(size_t p, GridNode* n) {
+  assert(_ports);
+  _ports->ports[p] = n;
+}
+
+// _____________________________________________________________________________
+const GridPorts* GridNodePL::getPorts() const { return _ports; }
 
 // _____________________________________________________________________________
-void GridNodePL::setPort(size_t p, GridNode* n) { _ports[p] = n; }
+void GridNodePL::setPorts(GridPorts* ports) { _ports = ports; }
 
 // _____________________________________________________________________________
 void GridNodePL::setXY(size_t x, size_t y) {
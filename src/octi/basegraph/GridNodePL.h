@@ -5,6 +5,7 @@
 #ifndef OCTI_BASEGRAPH_GRIDNODEPL_H_
 #define OCTI_BASEGRAPH_GRIDNODEPL_H_
 
+#include <cstdint>
 #include "octi/basegraph/GridEdgePL.h"
 #include "util/geo/Geo.h"
 #include "util/geo/GeoGraph.h"
@@ -20,9 +21,20 @@ class GridNodePL;
 typedef util::graph::Node<GridNodePL, GridEdgePL> GridNode;
 typedef util::graph::Edge<GridNodePL, GridEdgePL> GridEdge;
 
+// the ports of a grid node, owned by the grid graph
+struct GridPorts {
+  GridNode* ports[8];
+
+  // the edge leaving each port towards another grid node
+  GridEdge* out[8];
+
+  // bit i * 8 + j is set if there is no bend from port i to port j
+  uint64_t noBend;
+};
+
 class GridNodePL : util::geograph::GeoNodePL<double> {
  public:
-  GridNodePL(){};
+  GridNodePL() : _ports(0){};
   GridNodePL(Point<double> pos);
 
   const Point<double>* getGeom() const;
@@ -34,6 +46,9 @@ class GridNodePL : util::geograph::GeoNodePL<double> {
   GridNode* getPort(size_t i) const;
   void setPort(size_t p, GridNode* n);
 
+  const GridPorts* getPorts() const;
+  void setPorts(GridPorts* ports);
+
   void setXY(size_t x, size_t y);
   size_t getX() const;
   size_t getY() const;
@@ -54,7 +69,9 @@ class GridNodePL : util::geograph::GeoNodePL<double> {
   Point<double> _pos;
 
   GridNode* _parent;
-  GridNode* _ports[8];
+
+  // only grid nodes have ports, port nodes do not carry a block of their own
+  GridPorts* _ports;
 
   uint32_t _x, _y;
   uint32_t _id;
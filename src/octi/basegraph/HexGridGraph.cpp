@@ -46,6 +46,7 @@ void HexGridGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -184,6 +185,7 @@ GridNode* HexGridGraph::writeNd(size_t x, size_t y) {
 
   auto pos = DPoint(xPos, yPos);
   GridNode* n = addNd(pos);
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   n->pl().setSink();
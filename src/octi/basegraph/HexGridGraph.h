@@ -47,7 +47,7 @@ class HexGridGraph : public GridGraph {
   double _bendCosts[4];
 };
 
-struct HexGridGraphHeur
+struct HexGridGraphHeur final
     : public util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float> {
   HexGridGraphHeur(const basegraph::GridGraph* g, const std::set<GridNode*>& to)
       : g(g), to(0) {UNUSED(to);}
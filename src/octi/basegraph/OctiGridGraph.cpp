@@ -236,6 +236,7 @@ GridNode* OctiGridGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   n->pl().setSink();
@@ -299,6 +300,13 @@ GridNode* OctiGridGraph::getNode(size_t x, size_t y) const {
   return _nds[_grid.getYHeight() * 9 * x + y * 9];
 }
 
+// _____________________________________________________________________________
+const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
+OctiGridGraph::getHeur(const std::set<GridNode*>& to) const {
+  // the derived grids do not change heurCost()
+  return new GridGraphHeur<OctiGridGraph>(this, to);
+}
+
 // _____________________________________________________________________________
 double OctiGridGraph::heurCost(int64_t xa, int64_t ya, int64_t xb,
                                int64_t yb) const {
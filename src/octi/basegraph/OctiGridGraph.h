@@ -59,6 +59,9 @@ class OctiGridGraph : public GridGraph {
   virtual double ndMovePen(const CombNode* cbNd, const GridNode* grNd) const;
   virtual size_t getDir(const GridNode* a, const GridNode* b) const;
   virtual std::vector<double> getCosts() const;
+  virtual const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
+  getHeur(const std::set<GridNode*>& to) const;
+  virtual double heurCost(int64_t xa, int64_t ya, int64_t xb, int64_t yb) const;
 
  protected:
   virtual void writeInitialCosts();
@@ -67,7 +70,6 @@ class OctiGridGraph : public GridGraph {
   virtual GridNode* getNode(size_t x, size_t y) const;
   virtual double getBendPen(size_t i, size_t j) const;
   virtual size_t ang(size_t i, size_t j) const;
-  virtual double heurCost(int64_t xa, int64_t ya, int64_t xb, int64_t yb) const;
 
   double _heurDiagSave;
   double _heurXCost;
@@ -347,6 +347,7 @@ void OctiHananGraph::init() {
 
   prunePorts();
   writeInitialCosts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -405,6 +406,7 @@ GridNode* OctiHananGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   _ndIdx[x * _grid.getYHeight() + y] = _nds.size();
@@ -289,6 +289,7 @@ struct SplitFunc : util::geo::SplitFunc<const CombNode*, double> {
 
   prunePorts();
   writeInitialCosts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -52,6 +52,7 @@ void OrthoRadialGraph::init() {
   }
 
   writeInitialCosts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -188,6 +189,7 @@ GridNode* OrthoRadialGraph::writeNd(size_t x, size_t y) {
   double c_90 = _c.p_45 - _c.p_135 + _c.p_90;
 
   GridNode* n = addNd(pos);
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   n->pl().setSink();
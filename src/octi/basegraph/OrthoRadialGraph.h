@@ -42,7 +42,7 @@ class OrthoRadialGraph : public GridGraph {
   size_t _numBeams;
 };
 
-struct OrthoRadialGraphHeur
+struct OrthoRadialGraphHeur final
     : public util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float> {
   OrthoRadialGraphHeur(const basegraph::GridGraph* g,
                        const std::set<GridNode*>& to)
@@ -75,6 +75,8 @@ void PseudoOrthoRadialGraph::writeGeoCoursePens(const CombEdge* ce,
   box = util::geo::pad(box, sqrt(SOFT_INF / pen) * getCellSize());
   _grid.get(box, &neighs);
 
+  std::vector<std::pair<uint32_t, float>> pens;
+
   for (auto grNdA : neighs) {
     for (size_t i = 0; i < maxDeg(); i++) {
       auto grNeigh = neigh(grNdA->pl().getX(), grNdA->pl().getY(), i);
@@ -97,9 +99,11 @@ void PseudoOrthoRadialGraph::writeGeoCoursePens(const CombEdge* ce,
 
       d *= pen * d;
 
-      if (d <= SOFT_INF) (*target)[ce][ge->pl().getId()] = d;
+      if (d <= SOFT_INF) pens.emplace_back(ge->pl().getId(), d);
     }
   }
+
+  (*target)[ce] = GeoPens(pens);
 }
 
 // _____________________________________________________________________________
@@ -140,6 +144,7 @@ void PseudoOrthoRadialGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  indexPorts();
 }
 
 // _____________________________________________________________________________
@@ -363,6 +368,7 @@ GridNode* PseudoOrthoRadialGraph::writeNd(size_t x, size_t y) {
   double c_90 = _c.p_45 - _c.p_135 + _c.p_90;
 
   GridNode* n = addNd(pos);
+  n->pl().setPorts(newPorts());
   n->pl().setId(_nds.size());
   _nds.push_back(n);
   n->pl().setSink();
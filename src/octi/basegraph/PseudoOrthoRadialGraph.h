@@ -50,9 +50,9 @@ class PseudoOrthoRadialGraph : public GridGraph {
   size_t _numBeams;
 };
 
-struct PseudoOrthoRadialGraphHeur
+struct PseudoOrthoRadialGraphHeur final
     : public util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float> {
-  PseudoOrthoRadialGraphHeur(const basegraph::GridGraph* g,
+  PseudoOrthoRadialGraphHeur(const PseudoOrthoRadialGraph* g,
                              const std::set<GridNode*>& to)
       : g(g), to(0) {
     cheapestSink = std::numeric_limits<float>::infinity();
@@ -85,16 +85,16 @@ struct PseudoOrthoRadialGraphHeur
     float ret = std::numeric_limits<float>::infinity();
 
     for (size_t i = 0; i < hull.size(); i += 2) {
-      float tmp = g->heurCost(from->pl().getParent()->pl().getX(),
-                              from->pl().getParent()->pl().getY(), hull[i],
-                              hull[i + 1]);
+      float tmp = g->PseudoOrthoRadialGraph::heurCost(
+          from->pl().getParent()->pl().getX(),
+          from->pl().getParent()->pl().getY(), hull[i], hull[i + 1]);
       if (tmp < ret) ret = tmp;
     }
 
     return ret + cheapestSink;
   }
 
-  const octi::basegraph::BaseGraph* g;
+  const PseudoOrthoRadialGraph* g;
   GridNode* to;
   std::vector<size_t> hull;
   float cheapestSink;
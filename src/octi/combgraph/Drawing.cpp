@@ -16,8 +16,10 @@ using octi::combgraph::CombEdge;
 using octi::combgraph::CombGraph;
 using octi::combgraph::CombNode;
 using octi::combgraph::Drawing;
+using octi::combgraph::DrawingCheckpoint;
 using octi::combgraph::GrPath;
 using octi::combgraph::Score;
+using octi::combgraph::UndoEntry;
 using shared::linegraph::LineEdge;
 using shared::linegraph::LineGraph;
 using shared::linegraph::LineNode;
@@ -57,12 +59,21 @@ Score Drawing::fullScore() const {
 // _____________________________________________________________________________
 void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
   if (_c == std::numeric_limits<double>::infinity()) _c = 0;
+  touch(&_edgs, &_log.edgs, ce);
   if (_edgs.count(ce)) _edgs[ce].clear();
 
-  int l = 0;
+  touch(&_vios, &_log.vios, ce);
+  touch(&_edgCosts, &_log.edgCosts, ce);
+  touch(&_springCosts, &_log.springCosts, ce);
 
-  for (size_t i = 0; i < ges.size(); i++) {
-    auto ge = ges[i];
+  for (auto nd : {ce->getFrom(), ce->getTo()}) {
+    touch(&_ndReachCosts, &_log.ndReachCosts, nd);
+    touch(&_ndBndCosts, &_log.ndBndCosts, nd);
+  }
+
+  if (ges.size()) {
+    touch(&_nds, &_log.nds, ce->getFrom());
+    touch(&_nds, &_log.nds, ce->getTo());
 
     if (rev) {
       _nds[ce->getFrom()] =
@@ -73,6 +84,12 @@ void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
       _nds[ce->getFrom()] =
           ges.back()->getFrom()->pl().getParent()->pl().getId();
     }
+  }
+
+  int l = 0;
+
+  for (size_t i = 0; i < ges.size(); i++) {
+    auto ge = ges[i];
 
     // there are three kinds of cost contained in a result:
     //  a) node reach costs, which model the cost it takes to move a node
@@ -165,7 +182,8 @@ void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
 
 // _____________________________________________________________________________
 const GridNode* Drawing::getGrNd(const CombNode* cn) {
-  return _gg->getGrNdById(_nds[cn]);
+  auto it = _nds.find(cn);
+  return _gg->getGrNdById(it == _nds.end() ? 0 : it->second);
 }
 
 // _____________________________________________________________________________
@@ -468,6 +486,20 @@ void Drawing::getLineGraph(LineGraph* target) const {
 }
 // _____________________________________________________________________________
 void Drawing::crumble() {
+  if (_log.depth) {
+    for (const auto& e : _nds) _log.nds.push_back({e.first, true, e.second});
+    for (const auto& e : _edgs) _log.edgs.push_back({e.first, true, e.second});
+    for (const auto& e : _ndReachCosts)
+      _log.ndReachCosts.push_back({e.first, true, e.second});
+    for (const auto& e : _ndBndCosts)
+      _log.ndBndCosts.push_back({e.first, true, e.second});
+    for (const auto& e : _edgCosts)
+      _log.edgCosts.push_back({e.first, true, e.second});
+    for (const auto& e : _vios) _log.vios.push_back({e.first, true, e.second});
+    for (const auto& e : _springCosts)
+      _log.springCosts.push_back({e.first, true, e.second});
+  }
+
   _c = std::numeric_limits<double>::infinity();
   _violations = 0;
   _nds.clear();
@@ -550,6 +582,13 @@ const std::map<const CombEdge*, GrPath>& Drawing::getEdgPaths() const {
 
 // _____________________________________________________________________________
 void Drawing::erase(CombEdge* ce) {
+  touch(&_edgs, &_log.edgs, ce);
+  touch(&_edgCosts, &_log.edgCosts, ce);
+  touch(&_springCosts, &_log.springCosts, ce);
+  touch(&_vios, &_log.vios, ce);
+  touch(&_ndBndCosts, &_log.ndBndCosts, ce->getFrom());
+  touch(&_ndBndCosts, &_log.ndBndCosts, ce->getTo());
+
   _edgs.erase(ce);
   _c -= _edgCosts[ce];
   _edgCosts.erase(ce);
@@ -573,6 +612,10 @@ void Drawing::erase(CombEdge* ce) {
 
 // _____________________________________________________________________________
 void Drawing::erase(CombNode* cn) {
+  touch(&_nds, &_log.nds, cn);
+  touch(&_ndReachCosts, &_log.ndReachCosts, cn);
+  touch(&_ndBndCosts, &_log.ndBndCosts, cn);
+
   _nds.erase(cn);
   _c -= _ndReachCosts[cn];
   _c -= _ndBndCosts[cn];
@@ -646,3 +689,55 @@ double Drawing::getNdReachCost(const CombNode* n) const {
   if (_ndReachCosts.count(n)) return _ndReachCosts.find(n)->second;
   return 0;
 }
+
+// _____________________________________________________________________________
+DrawingCheckpoint Drawing::checkpoint() {
+  _log.depth++;
+  return {_log.nds.size(),        _log.edgs.size(),     _log.ndReachCosts.size(),
+          _log.ndBndCosts.size(), _log.edgCosts.size(), _log.vios.size(),
+          _log.springCosts.size(), _c,                  _violations};
+}
+
+// _____________________________________________________________________________
+void Drawing::rollback(const DrawingCheckpoint& cp) {
+  undo(&_nds, &_log.nds, cp.nds);
+  undo(&_edgs, &_log.edgs, cp.edgs);
+  undo(&_ndReachCosts, &_log.ndReachCosts, cp.ndReachCosts);
+  undo(&_ndBndCosts, &_log.ndBndCosts, cp.ndBndCosts);
+  undo(&_edgCosts, &_log.edgCosts, cp.edgCosts);
+  undo(&_vios, &_log.vios, cp.vios);
+  undo(&_springCosts, &_log.springCosts, cp.springCosts);
+  _c = cp.c;
+  _violations = cp.violations;
+  _log.depth--;
+}
+
+// _____________________________________________________________________________
+template <typename K, typename V>
+void Drawing::touch(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log,
+                    typename std::map<K, V>::key_type k) {
+  if (!_log.depth) return;
+  auto it = m->find(k);
+  if (it == m->end()) {
+    log->push_back({k, false, V()});
+  } else {
+    log->push_back({k, true, it->second});
+  }
+}
+
+// _____________________________________________________________________________
+template <typename K, typename V>
+void Drawing::undo(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log,
+                   size_t size) {
+  // restore in reverse order, the oldest saved entry of a key is its value at
+  // the checkpoint
+  while (log->size() > size) {
+    auto& e = log->back();
+    if (e.had) {
+      (*m)[e.key] = std::move(e.val);
+    } else {
+      m->erase(e.key);
+    }
+    log->pop_back();
+  }
+}
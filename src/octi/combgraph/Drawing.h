@@ -2,6 +2,7 @@
 #define OCTI_COMBGRAPH_DRAWING_H_
 
 #include <map>
+#include <vector>
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/combgraph/CombGraph.h"
 #include "util/graph/Dijkstra.h"
@@ -71,6 +72,43 @@ struct Segment {
   std::set<CombEdge*> combEdges;
 };
 
+template <typename K, typename V>
+struct UndoEntry {
+  K key;
+  bool had;
+  V val;
+};
+
+// position in the undo log of a drawing
+struct DrawingCheckpoint {
+  size_t nds, edgs, ndReachCosts, ndBndCosts, edgCosts, vios, springCosts;
+  double c;
+  size_t violations;
+};
+
+// Previous values of all drawing entries changed since the oldest open
+// checkpoint. The log is never copied along with a drawing.
+struct DrawingLog {
+  DrawingLog() : depth(0) {}
+  DrawingLog(const DrawingLog&) : depth(0) {}
+  DrawingLog& operator=(const DrawingLog&) {
+    *this = DrawingLog();
+    return *this;
+  }
+  DrawingLog& operator=(DrawingLog&&) = default;
+
+  std::vector<UndoEntry<const CombNode*, size_t>> nds;
+  std::vector<UndoEntry<const CombEdge*, GrPath>> edgs;
+  std::vector<UndoEntry<const CombNode*, double>> ndReachCosts;
+  std::vector<UndoEntry<const CombNode*, double>> ndBndCosts;
+  std::vector<UndoEntry<const CombEdge*, double>> edgCosts;
+  std::vector<UndoEntry<const CombEdge*, int>> vios;
+  std::vector<UndoEntry<const CombEdge*, double>> springCosts;
+
+  // number of open checkpoints
+  size_t depth;
+};
+
 class Drawing {
  public:
   Drawing(const BaseGraph* gg)
@@ -110,6 +148,14 @@ class Drawing {
 
   const std::map<const CombEdge*, GrPath>& getEdgPaths() const;
 
+  // Start logging changes, which can be undone by rollback(). Cheaper than
+  // copying the drawing, as only the touched entries are saved. Checkpoints
+  // may be nested, but have to be rolled back in reverse order.
+  DrawingCheckpoint checkpoint();
+
+  // undo all changes made since cp was taken, and close it
+  void rollback(const DrawingCheckpoint& cp);
+
  private:
   std::map<const CombNode*, size_t> _nds;
   std::map<const CombEdge*, GrPath> _edgs;
@@ -124,7 +170,18 @@ class Drawing {
 
   size_t _violations;
 
+  DrawingLog _log;
+
   double recalcBends(const CombNode* nd);
+
+  // save the current entry for k in m to log, if a checkpoint is open
+  template <typename K, typename V>
+  void touch(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log,
+             typename std::map<K, V>::key_type k);
+
+  template <typename K, typename V>
+  static void undo(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log,
+                   size_t size);
 };
 }  // namespace combgraph
 }  // namespace octi
@@ -68,6 +68,10 @@ void ConfigReader::help(const char* bin) const {
             << "number of Hanan grid iterations\n"
             << std::setw(39) << "  --loc-search-max-iters arg (=100)"
             << "max local search iterations\n"
+            << std::setw(39) << "  --heur-jobs arg (=0)"
+            << "number of parallel jobs used by heur,\n"
+            << std::setw(39) << " "
+            << " 0 means one per processor\n"
             << std::setw(39) << "  --ilp-cache-threshold arg (=inf)"
             << "ILP solve cache treshold\n"
             << std::setw(39) << "  --ilp-time-limit arg (=60)"
@@ -154,6 +158,7 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"skip-on-error", no_argument, 0, 25},
                          {"retry-on-error", no_argument, 0, 26},
                          {"abort-after", required_argument, 0, 'a'},
+                         {"heur-jobs", required_argument, 0, 27},
                          {0, 0, 0, 0}};
 
   int c;
@@ -247,6 +252,9 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 26:
         cfg->retryOnError = true;
         break;
+      case 27:
+        cfg->heurJobs = atoi(optarg);
+        break;
       case 'g':
         cfg->gridSize = optarg;
         break;
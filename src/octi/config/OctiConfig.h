@@ -48,6 +48,8 @@ struct Config {
 
   int heurLocSearchIters = 100;
 
+  size_t heurJobs = 0;
+
   size_t abortAfter = -1;
 
   size_t hananIters = 1;
@@ -17,7 +17,10 @@ using octi::basegraph::GridNode;
 using octi::combgraph::Drawing;
 using octi::ilp::ILPGridOptimizer;
 using octi::ilp::ILPStats;
+using octi::ilp::ILPVars;
+using shared::optim::ColBatch;
 using shared::optim::ILPSolver;
+using shared::optim::RowBatch;
 using shared::optim::StarterSol;
 
 // _____________________________________________________________________________
@@ -30,7 +33,7 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
                                     const std::string& path) const {
   // extract first feasible solution from gridgraph
   ILPStats s{std::numeric_limits<double>::infinity(), 0, 0, 0, 0};
-  StarterSol sol = extractFeasibleSol(d, gg, cg, maxGrDist);
+  ILPVars feasible = extractFeasibleSol(d, gg, cg, maxGrDist);
   gg->reset();
 
   for (auto nd : gg->getNds()) {
@@ -48,11 +51,14 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
   // clear drawing
   d->crumble();
 
-  auto lp = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr);
+  ILPVars vars;
+  auto lp = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr,
+                          path.size(), &vars);
 
   s.cols = lp->getNumVars();
   s.rows = lp->getNumConstrs();
 
+  StarterSol sol = getStarter(feasible, vars);
   lp->setStarter(sol);
 
   if (path.size()) {
@@ -84,7 +90,7 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
           "limit)!");
     }
 
-    extractSolution(lp, gg, cg, d);
+    extractSolution(lp, vars, gg, cg, d);
     shared::linegraph::LineGraph tg;
     d->getLineGraph(&tg);
 
@@ -102,19 +108,27 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
 ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
                                            const GeoPensMap* geoPensMap,
                                            double maxGrDist,
-                                           const std::string& solverStr) const {
+                                           const std::string& solverStr,
+                                           bool names, ILPVars* vars) const {
   ILPSolver* lp = shared::optim::getSolver(solverStr, shared::optim::MIN);
 
+  ColBatch cols(lp->getNumVars());
+  RowBatch rows(lp->getNumConstrs());
+
   // grid nodes that may potentially be a position for an
   // input station
   std::map<const CombNode*, std::set<const GridNode*>> cands;
 
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
-    std::stringstream oneAssignment;
     // must sum up to 1
-    oneAssignment << "oneass(" << nd << ")";
-    int rowStat = lp->addRow(oneAssignment.str(), 1, shared::optim::FIX);
+    int rowStat = rows.add(1, shared::optim::FIX);
+
+    if (names) {
+      std::stringstream oneAssignment;
+      oneAssignment << "oneass(" << nd << ")";
+      rows.setName(rowStat, oneAssignment.str());
+    }
 
     for (const GridNode* n : gg->getNds()) {
       if (!n->pl().isSink()) continue;
@@ -138,11 +152,11 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
       gg->openSinkFr(const_cast<GridNode*>(n), 0);
       gg->openSinkTo(const_cast<GridNode*>(n), 0);
 
-      auto varName = getStatPosVar(n, nd);
+      int col = cols.add(shared::optim::BIN, gg->ndMovePen(nd, n));
+      vars->statPos[{n, nd}] = col;
+      if (names) cols.setName(col, getStatPosVar(n, nd));
 
-      int col = lp->addCol(varName, shared::optim::BIN, gg->ndMovePen(nd, n));
-
-      lp->addColToRow(rowStat, col, 1);
+      rows.addCoef(col, 1);
     }
   }
 
@@ -171,14 +185,11 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
             continue;
           }
 
-          auto edgeVarName = getEdgUseVar(e, edg);
-
           double coef;
           if (geoPensMap && !e->pl().isSecondary()) {
             // add geo pen
-            auto thisMap = geoPensMap->find(edg)->second;
-            auto i = thisMap.find(e->pl().getId());
-            if (i != thisMap.end()) coef = e->pl().cost() + i->second;
+            const auto& thisPens = geoPensMap->find(edg)->second;
+            coef = e->pl().cost() + thisPens.get(e->pl().getId());
 
             // if no geopen was present for grid edge, we assume SOFT_INF
             // penalty
@@ -186,14 +197,14 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
           } else {
             coef = e->pl().cost();
           }
-          lp->addCol(edgeVarName, shared::optim::BIN, coef);
+          int col = cols.add(shared::optim::BIN, coef);
+          vars->edgUse[{e, edg}] = col;
+          if (names) cols.setName(col, getEdgUseVar(e, edg));
         }
       }
     }
   }
 
-  lp->update();
-
   // an edge can only be used a single time
   std::set<const GridEdge*> proced;
   for (const GridNode* n : gg->getNds()) {
@@ -204,23 +215,24 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
       proced.insert(e);
       proced.insert(f);
 
-      std::stringstream constName;
-      constName << "ue(" << e->getFrom()->pl().getId() << ","
-                << e->getTo()->pl().getId() << ")";
-      int row = lp->addRow(constName.str(), 1, shared::optim::UP);
+      int row = rows.add(1, shared::optim::UP);
+
+      if (names) {
+        std::stringstream constName;
+        constName << "ue(" << e->getFrom()->pl().getId() << ","
+                  << e->getTo()->pl().getId() << ")";
+        rows.setName(row, constName.str());
+      }
 
       for (auto nd : cg.getNds()) {
         for (auto edg : nd->getAdjList()) {
           if (edg->getFrom() != nd) continue;
           if (e->pl().cost() >= basegraph::SOFT_INF) continue;
 
-          auto eVarName = getEdgUseVar(e, edg);
-          auto fVarName = getEdgUseVar(f, edg);
-
-          int eCol = lp->getVarByName(eVarName);
-          if (eCol > -1) lp->addColToRow(row, eCol, 1);
-          int fCol = lp->getVarByName(fVarName);
-          if (fCol > -1) lp->addColToRow(row, fCol, 1);
+          int eCol = getEdgUseCol(*vars, e, edg);
+          if (eCol > -1) rows.addCoef(eCol, 1);
+          int fCol = getEdgUseCol(*vars, f, edg);
+          if (fCol > -1) rows.addCoef(fCol, 1);
         }
       }
     }
@@ -234,11 +246,15 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
     for (auto nd : cg.getNds()) {
       for (auto edg : nd->getAdjList()) {
         if (edg->getFrom() != nd) continue;
-        std::stringstream constName;
-        constName << "as(" << n->pl().getId() << "," << edg << ")";
 
         // an upper bound is enough here
-        int row = lp->addRow(constName.str(), 0, shared::optim::UP);
+        int row = rows.add(0, shared::optim::UP);
+
+        if (names) {
+          std::stringstream constName;
+          constName << "as(" << n->pl().getId() << "," << edg << ")";
+          rows.setName(row, constName.str());
+        }
 
         // normally, we count an incoming edge as 1 and an outgoing edge as -1
         // later on, we make sure that each node has a some of all out and in
@@ -262,34 +278,32 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
         if (n->pl().isSink()) {
           // subtract the variable for this start node and edge, if used
           // as a candidate
-          int ndColFrom = lp->getVarByName(getStatPosVar(n, edg->getFrom()));
-          if (ndColFrom > -1) lp->addColToRow(row, ndColFrom, -2);
+          int ndColFrom = getStatPosCol(*vars, n, edg->getFrom());
+          if (ndColFrom > -1) rows.addCoef(ndColFrom, -2);
 
           // add the variable for this end node and edge, if used
           // as a candidate
-          int ndColTo = lp->getVarByName(getStatPosVar(n, edg->getTo()));
-          if (ndColTo > -1) lp->addColToRow(row, ndColTo, 1);
+          int ndColTo = getStatPosCol(*vars, n, edg->getTo());
+          if (ndColTo > -1) rows.addCoef(ndColTo, 1);
 
           outCost = 2;
         }
 
         for (auto e : n->getAdjListIn()) {
-          int edgCol = lp->getVarByName(getEdgUseVar(e, edg));
+          int edgCol = getEdgUseCol(*vars, e, edg);
           if (edgCol < 0) continue;
-          lp->addColToRow(row, edgCol, inCost);
+          rows.addCoef(edgCol, inCost);
         }
 
         for (auto e : n->getAdjListOut()) {
-          int edgCol = lp->getVarByName(getEdgUseVar(e, edg));
+          int edgCol = getEdgUseCol(*vars, e, edg);
           if (edgCol < 0) continue;
-          lp->addColToRow(row, edgCol, outCost);
+          rows.addCoef(edgCol, outCost);
         }
       }
     }
   }
 
-  lp->update();
-
   // only a single sink edge can be activated per input edge and settled grid
   // node
   // THIS RULE IS REDUNDANT AND IMPLICITELY ENFORCED BY OTHER RULES,
@@ -301,10 +315,13 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
       for (auto e : nd->getAdjList()) {
         if (e->getFrom() != nd) continue;
 
-        std::stringstream constName;
-        constName << "ss(" << n->pl().getId() << "," << e << ")";
+        int row = rows.add(0, shared::optim::FIX);
 
-        int row = lp->addRow(constName.str(), 0, shared::optim::FIX);
+        if (names) {
+          std::stringstream constName;
+          constName << "ss(" << n->pl().getId() << "," << e << ")";
+          rows.setName(row, constName.str());
+        }
 
         if (!cands[e->getFrom()].count(n) && !cands[e->getTo()].count(n)) {
           // node does not appear as start or end cand, so the number of
@@ -312,27 +329,25 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
 
         } else {
           if (cands[e->getTo()].count(n)) {
-            int ndColTo = lp->getVarByName(getStatPosVar(n, e->getTo()));
-            if (ndColTo > -1) lp->addColToRow(row, ndColTo, -1);
+            int ndColTo = getStatPosCol(*vars, n, e->getTo());
+            if (ndColTo > -1) rows.addCoef(ndColTo, -1);
           }
 
           if (cands[e->getFrom()].count(n)) {
-            int ndColFr = lp->getVarByName(getStatPosVar(n, e->getFrom()));
-            if (ndColFr > -1) lp->addColToRow(row, ndColFr, -1);
+            int ndColFr = getStatPosCol(*vars, n, e->getFrom());
+            if (ndColFr > -1) rows.addCoef(ndColFr, -1);
           }
         };
 
         for (size_t p = 0; p < gg->maxDeg(); p++) {
           auto portNd = n->pl().getPort(p);
           if (!portNd) continue;
-          auto varSinkTo = getEdgUseVar(gg->getEdg(portNd, n), e);
-          auto varSinkFr = getEdgUseVar(gg->getEdg(n, portNd), e);
 
-          int ndColTo = lp->getVarByName(varSinkTo);
-          if (ndColTo > -1) lp->addColToRow(row, ndColTo, 1);
+          int ndColTo = getEdgUseCol(*vars, gg->getEdg(portNd, n), e);
+          if (ndColTo > -1) rows.addCoef(ndColTo, 1);
 
-          int ndColFr = lp->getVarByName(varSinkFr);
-          if (ndColFr > -1) lp->addColToRow(row, ndColFr, 1);
+          int ndColFr = getEdgUseCol(*vars, gg->getEdg(n, portNd), e);
+          if (ndColFr > -1) rows.addCoef(ndColFr, 1);
         }
       }
     }
@@ -343,17 +358,20 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
   for (GridNode* n : gg->getNds()) {
     if (!n->pl().isSink()) continue;
 
-    std::stringstream constName;
-    constName << "iu(" << n->pl().getId() << ")";
+    int row = rows.add(1, shared::optim::UP);
 
-    int row = lp->addRow(constName.str(), 1, shared::optim::UP);
+    if (names) {
+      std::stringstream constName;
+      constName << "iu(" << n->pl().getId() << ")";
+      rows.setName(row, constName.str());
+    }
 
     // a meta grid node can either be a sink for a single input node, or
     // a pass-through
 
     for (auto nd : cg.getNds()) {
-      int ndcolto = lp->getVarByName(getStatPosVar(n, nd).c_str());
-      if (ndcolto > -1) lp->addColToRow(row, ndcolto, 1);
+      int ndcolto = getStatPosCol(*vars, n, nd);
+      if (ndcolto > -1) rows.addCoef(ndcolto, 1);
     }
 
     // go over all ports
@@ -369,70 +387,75 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
           for (auto edg : nd->getAdjList()) {
             if (edg->getFrom() != nd) continue;
 
-            int edgCol = lp->getVarByName(getEdgUseVar(innerE, edg));
+            int edgCol = getEdgUseCol(*vars, innerE, edg);
             if (edgCol < 0) continue;
-            lp->addColToRow(row, edgCol, 1);
+            rows.addCoef(edgCol, 1);
           }
         }
       }
     }
   }
 
-  lp->update();
-
   // dont allow crossing edges
   size_t rowId = 0;
   for (auto edgPair : gg->getCrossEdgPairs()) {
-    std::stringstream constName;
-    constName << "nc(" << rowId << ")";
-    rowId++;
+    int row = rows.add(1, shared::optim::UP);
 
-    int row = lp->addRow(constName.str(), 1, shared::optim::UP);
+    if (names) {
+      std::stringstream constName;
+      constName << "nc(" << rowId << ")";
+      rows.setName(row, constName.str());
+    }
+    rowId++;
 
     for (auto nd : cg.getNds()) {
       for (auto edg : nd->getAdjList()) {
         if (edg->getFrom() != nd) continue;
 
-        int col = lp->getVarByName(getEdgUseVar(edgPair.first.first, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+        int col = getEdgUseCol(*vars, edgPair.first.first, edg);
+        if (col > -1) rows.addCoef(col, 1);
 
-        col = lp->getVarByName(getEdgUseVar(edgPair.first.second, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+        col = getEdgUseCol(*vars, edgPair.first.second, edg);
+        if (col > -1) rows.addCoef(col, 1);
 
-        col = lp->getVarByName(getEdgUseVar(edgPair.second.first, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+        col = getEdgUseCol(*vars, edgPair.second.first, edg);
+        if (col > -1) rows.addCoef(col, 1);
 
-        col = lp->getVarByName(getEdgUseVar(edgPair.second.second, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+        col = getEdgUseCol(*vars, edgPair.second.second, edg);
+        if (col > -1) rows.addCoef(col, 1);
       }
     }
   }
 
-  lp->update();
-
   // for each input node N, define a var x_dirNE which tells the direction of
   // E at N
+  std::map<std::pair<const CombNode*, const CombEdge*>, int> dirCols;
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() < 2) continue;  // we don't need this for deg 1 nodes
     for (auto edg : nd->getAdjList()) {
-      std::stringstream dirName;
-      dirName << "d(" << nd << "," << edg << ")";
-      int col =
-          lp->addCol(dirName.str(), shared::optim::INT, 0, 0, gg->maxDeg() - 1);
+      int col = cols.add(shared::optim::INT, 0, 0, gg->maxDeg() - 1);
+      dirCols[{nd, edg}] = col;
 
-      std::stringstream constName;
-      constName << "dc(" << nd << "," << edg << ")";
+      int row = rows.add(0, shared::optim::FIX);
+
+      if (names) {
+        std::stringstream dirName;
+        dirName << "d(" << nd << "," << edg << ")";
+        cols.setName(col, dirName.str());
 
-      int row = lp->addRow(constName.str(), 0, shared::optim::FIX);
+        std::stringstream constName;
+        constName << "dc(" << nd << "," << edg << ")";
+        rows.setName(row, constName.str());
+      }
 
-      lp->addColToRow(row, col, -1);
+      rows.addCoef(col, -1);
 
       for (GridNode* n : gg->getNds()) {
         if (!n->pl().isSink()) continue;
 
         // check if this grid node is used as a candidate for comb node
         // if not, we don't have to add the constraints
-        int ndColFrom = lp->getVarByName(getStatPosVar(n, nd));
+        int ndColFrom = getStatPosCol(*vars, n, nd);
         if (ndColFrom == -1) continue;
 
         if (edg->getFrom() == nd) {
@@ -441,8 +464,8 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
             auto portNd = n->pl().getPort(i);
             if (!portNd) continue;
             auto e = gg->getEdg(n, portNd);
-            int col = lp->getVarByName(getEdgUseVar(e, edg));
-            if (col > -1) lp->addColToRow(row, col, i);
+            int col = getEdgUseCol(*vars, e, edg);
+            if (col > -1) rows.addCoef(col, i);
           }
         } else {
           // the 0 can be skipped here
@@ -450,16 +473,14 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
             auto portNd = n->pl().getPort(i);
             if (!portNd) continue;
             auto e = gg->getEdg(portNd, n);
-            int col = lp->getVarByName(getEdgUseVar(e, edg));
-            if (col > -1) lp->addColToRow(row, col, i);
+            int col = getEdgUseCol(*vars, e, edg);
+            if (col > -1) rows.addCoef(col, i);
           }
         }
       }
     }
   }
 
-  lp->update();
-
   // for each input node N, make sure that the circular ordering of the final
   // drawing matches the input ordering
   int M = gg->maxDeg();
@@ -467,21 +488,29 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
     // for degree < 3, the circular ordering cannot be violated
     if (nd->getDeg() < 3) continue;
 
-    std::stringstream vulnConstName;
-    vulnConstName << "vc(" << nd << ")";
     // an upper bound would also work here, at most one
     // of the vuln vars may be 1
 
-    int vulnRow = lp->addRow(vulnConstName.str(), 1, shared::optim::FIX);
+    int vulnRow = rows.add(1, shared::optim::FIX);
 
-    for (size_t i = 0; i < nd->getDeg(); i++) {
-      std::stringstream n;
-      n << "vuln(" << nd << "," << i << ")";
-      int col = lp->addCol(n.str(), shared::optim::BIN, 0);
-      lp->addColToRow(vulnRow, col, 1);
+    if (names) {
+      std::stringstream vulnConstName;
+      vulnConstName << "vc(" << nd << ")";
+      rows.setName(vulnRow, vulnConstName.str());
     }
 
-    lp->update();
+    int firstVulnCol = cols.getFirstId() + cols.size();
+
+    for (size_t i = 0; i < nd->getDeg(); i++) {
+      int col = cols.add(shared::optim::BIN, 0);
+      rows.addCoef(col, 1);
+
+      if (names) {
+        std::stringstream n;
+        n << "vuln(" << nd << "," << i << ")";
+        cols.setName(col, n.str());
+      }
+    }
 
     auto order = nd->pl().getEdgeOrdering().getOrderedSet();
     assert(order.size() > 2);
@@ -496,33 +525,24 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
 
       assert(edgA != edgB);
 
-      std::stringstream colNameA;
-      colNameA << "d(" << nd << "," << edgA << ")";
-      int colA = lp->getVarByName(colNameA.str());
-      assert(colA > -1);
+      int colA = dirCols[{nd, edgA}];
+      int colB = dirCols[{nd, edgB}];
+      int vulnCol = firstVulnCol + i;
 
-      std::stringstream colNameB;
-      colNameB << "d(" << nd << "," << edgB << ")";
-      int colB = lp->getVarByName(colNameB.str());
-      assert(colB > -1);
-
-      std::stringstream constName;
-      constName << "oc(" << nd << "," << i << ")";
-      int row = lp->addRow(constName.str(), 1, shared::optim::LO);
+      int row = rows.add(1, shared::optim::LO);
 
-      std::stringstream vulnColName;
-      vulnColName << "vuln(" << nd << "," << i << ")";
-      int vulnCol = lp->getVarByName(vulnColName.str());
-      assert(vulnCol > -1);
+      if (names) {
+        std::stringstream constName;
+        constName << "oc(" << nd << "," << i << ")";
+        rows.setName(row, constName.str());
+      }
 
-      lp->addColToRow(row, colB, 1);
-      lp->addColToRow(row, colA, -1);
-      lp->addColToRow(row, vulnCol, M);
+      rows.addCoef(colB, 1);
+      rows.addCoef(colA, -1);
+      rows.addCoef(vulnCol, M);
     }
   }
 
-  lp->update();
-
   std::vector<double> pens = gg->getCosts();
 
   // for each adjacent edge pair, add variables telling the accuteness of the
@@ -548,73 +568,78 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
 
         if (!sharedLines) continue;
 
-        std::stringstream negVar;
-        negVar << "negdist(" << edgA << "," << edgB << ")";
-
-        int colNeg = lp->addCol(negVar.str(), shared::optim::BIN, 0);
-
-        std::stringstream constName;
-        constName << "nc(" << edgA << "," << edgB << ")";
-
-        int row1 = lp->addRow(constName.str() + "lo", 0, shared::optim::LO);
-        int row2 = lp->addRow(constName.str() + "up", gg->maxDeg() - 1,
-                              shared::optim::UP);
-
-        std::stringstream dirNameA;
-        dirNameA << "d(" << nd << "," << edgA << ")";
-        std::stringstream dirNameB;
-        dirNameB << "d(" << nd << "," << edgB << ")";
-
-        int colA = lp->getVarByName(dirNameA.str());
-        assert(colA > -1);
-        lp->addColToRow(row1, colA, 1);
-        lp->addColToRow(row2, colA, 1);
-
-        int colB = lp->getVarByName(dirNameB.str());
-        assert(colB > -1);
-        lp->addColToRow(row1, colB, -1);
-        lp->addColToRow(row2, colB, -1);
+        int colNeg = cols.add(shared::optim::BIN, 0);
 
-        lp->addColToRow(row1, colNeg, gg->maxDeg());
-        lp->addColToRow(row2, colNeg, gg->maxDeg());
+        int colA = dirCols[{nd, edgA}];
+        int colB = dirCols[{nd, edgB}];
 
-        std::stringstream angConst;
-        angConst << "ac(" << edgA << "," << edgB << ")";
-        int rowAng = lp->addRow(angConst.str(), 0, shared::optim::FIX);
+        int row1 = rows.add(0, shared::optim::LO);
+        rows.addCoef(colA, 1);
+        rows.addCoef(colB, -1);
+        rows.addCoef(colNeg, gg->maxDeg());
 
-        lp->addColToRow(rowAng, colA, 1);
-        lp->addColToRow(rowAng, colB, -1);
-        lp->addColToRow(rowAng, colNeg, gg->maxDeg());
-
-        std::stringstream sumConst;
-        sumConst << "asc(" << edgA << "," << edgB << ")";
-
-        int rowSum = lp->addRow(sumConst.str(), 1, shared::optim::UP);
+        int row2 = rows.add(gg->maxDeg() - 1, shared::optim::UP);
+        rows.addCoef(colA, 1);
+        rows.addCoef(colB, -1);
+        rows.addCoef(colNeg, gg->maxDeg());
 
         int N = gg->maxDeg() - 1;
         int M = pens.size();
 
+        int firstDistCol = cols.getFirstId() + cols.size();
+
         for (int k = 0; k < N; k++) {
-          std::stringstream var;
           size_t pp = pens.size() - 1 - k;
-          if (k >= M) {
-            pp = k + 1 - pens.size();
-            var << "d" << pp << "'(" << edgA << "," << edgB << ")";
-          } else {
-            var << "d" << pp << "(" << edgA << "," << edgB << ")";
-          }
+          if (k >= M) pp = k + 1 - pens.size();
 
           // TODO: maybe multiply per shared lines - but this actually
           // makes the drawings look worse.
-          int col = lp->addCol(var.str(), shared::optim::BIN, pens[pp]);
+          int col = cols.add(shared::optim::BIN, pens[pp]);
+
+          if (names) {
+            std::stringstream var;
+            if (k >= M) {
+              var << "d" << pp << "'(" << edgA << "," << edgB << ")";
+            } else {
+              var << "d" << pp << "(" << edgA << "," << edgB << ")";
+            }
+            cols.setName(col, var.str());
+          }
+        }
+
+        int rowAng = rows.add(0, shared::optim::FIX);
+        rows.addCoef(colA, 1);
+        rows.addCoef(colB, -1);
+        rows.addCoef(colNeg, gg->maxDeg());
+        for (int k = 0; k < N; k++) rows.addCoef(firstDistCol + k, -(k + 1));
+
+        int rowSum = rows.add(1, shared::optim::UP);
+        for (int k = 0; k < N; k++) rows.addCoef(firstDistCol + k, 1);
+
+        if (names) {
+          std::stringstream negVar;
+          negVar << "negdist(" << edgA << "," << edgB << ")";
+          cols.setName(colNeg, negVar.str());
 
-          lp->addColToRow(rowAng, col, -(k + 1));
-          lp->addColToRow(rowSum, col, 1);
+          std::stringstream constName;
+          constName << "nc(" << edgA << "," << edgB << ")";
+          rows.setName(row1, constName.str() + "lo");
+          rows.setName(row2, constName.str() + "up");
+
+          std::stringstream angConst;
+          angConst << "ac(" << edgA << "," << edgB << ")";
+          rows.setName(rowAng, angConst.str());
+
+          std::stringstream sumConst;
+          sumConst << "asc(" << edgA << "," << edgB << ")";
+          rows.setName(rowSum, sumConst.str());
         }
       }
     }
   }
 
+  lp->addCols(cols);
+  lp->addRows(rows);
   lp->update();
 
   return lp;
@@ -640,12 +665,31 @@ std::string ILPGridOptimizer::getStatPosVar(const GridNode* n,
 }
 
 // _____________________________________________________________________________
-void ILPGridOptimizer::extractSolution(ILPSolver* lp, BaseGraph* gg,
-                                       const CombGraph& cg,
+int ILPGridOptimizer::getEdgUseCol(const ILPVars& vars, const GridEdge* e,
+                                   const CombEdge* cg) {
+  auto i = vars.edgUse.find({e, cg});
+  if (i == vars.edgUse.end()) return -1;
+  return i->second;
+}
+
+// _____________________________________________________________________________
+int ILPGridOptimizer::getStatPosCol(const ILPVars& vars, const GridNode* n,
+                                    const CombNode* cg) {
+  auto i = vars.statPos.find({n, cg});
+  if (i == vars.statPos.end()) return -1;
+  return i->second;
+}
+
+// _____________________________________________________________________________
+void ILPGridOptimizer::extractSolution(ILPSolver* lp, const ILPVars& vars,
+                                       BaseGraph* gg, const CombGraph& cg,
                                        combgraph::Drawing* d) const {
   std::map<const CombNode*, const GridNode*> gridNds;
   std::map<const CombEdge*, std::set<const GridEdge*>> gridEdgs;
 
+  std::vector<double> vals;
+  lp->getVarVals(&vals);
+
   // write solution to grid graph
   for (GridNode* n : gg->getNds()) {
     for (GridEdge* e : n->getAdjList()) {
@@ -654,11 +698,10 @@ void ILPGridOptimizer::extractSolution(ILPSolver* lp, BaseGraph* gg,
       for (auto nd : cg.getNds()) {
         for (auto edg : nd->getAdjList()) {
           if (edg->getFrom() != nd) continue;
-          auto varName = getEdgUseVar(e, edg);
 
-          int i = lp->getVarByName(varName);
+          int i = getEdgUseCol(vars, e, edg);
           if (i > -1) {
-            double val = lp->getVarVal(i);
+            double val = vals[i];
             if (val > 0.5) {
               gg->addResEdg(e, edg);
               gridEdgs[edg].insert(e);
@@ -672,11 +715,9 @@ void ILPGridOptimizer::extractSolution(ILPSolver* lp, BaseGraph* gg,
   for (GridNode* n : gg->getNds()) {
     if (!n->pl().isSink()) continue;
     for (auto nd : cg.getNds()) {
-      auto varName = getStatPosVar(n, nd);
-
-      int i = lp->getVarByName(varName);
+      int i = getStatPosCol(vars, n, nd);
       if (i > -1) {
-        double val = lp->getVarVal(i);
+        double val = vals[i];
         if (val > 0.5) {
           gridNds[nd] = n;
         }
@@ -744,10 +785,10 @@ size_t ILPGridOptimizer::nonInfDeg(const GridNode* g) const {
 }
 
 // _____________________________________________________________________________
-StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
-                                                const CombGraph& cg,
-                                                double maxGrDist) const {
-  StarterSol sol;
+ILPVars ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
+                                             const CombGraph& cg,
+                                             double maxGrDist) const {
+  ILPVars sol;
 
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
@@ -761,9 +802,8 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
       double maxDis = gg->getCellSize() * maxGrDist;
       if (gridD >= maxDis) continue;
 
-      auto varName = getStatPosVar(gnd, nd);
       if (gnd == settled) {
-        sol[varName] = 1;
+        sol.statPos[{gnd, nd}] = 1;
 
         // if settled, all bend edges are unused
         for (size_t p = 0; p < gg->maxDeg(); p++) {
@@ -773,13 +813,12 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
             if (!bendEdg->pl().isSecondary()) continue;
             for (auto cEdg : nd->getAdjList()) {
               if (cEdg->getFrom() != nd) continue;
-              auto varName = getEdgUseVar(bendEdg, cEdg);
-              sol[varName] = 0;
+              sol.edgUse[{bendEdg, cEdg}] = 0;
             }
           }
         }
       } else {
-        sol[varName] = 0;
+        sol.statPos[{gnd, nd}] = 0;
 
         // if not settled, all sink edges are unused
         // for all input edges
@@ -787,8 +826,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
           assert(sinkEdg->pl().isSecondary());
           for (auto cEdg : nd->getAdjList()) {
             if (cEdg->getFrom() != nd) continue;
-            auto varName = getEdgUseVar(sinkEdg, cEdg);
-            sol[varName] = 0;
+            sol.edgUse[{sinkEdg, cEdg}] = 0;
           }
         }
       }
@@ -803,8 +841,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
       for (auto cNd : cg.getNds()) {
         for (auto cEdg : cNd->getAdjList()) {
           if (cEdg->getFrom() != cNd) continue;
-          auto varName = getEdgUseVar(grEdg, cEdg);
-          sol[varName] = 0;
+          sol.edgUse[{grEdg, cEdg}] = 0;
         }
       }
     }
@@ -816,8 +853,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
     const auto& grEdgList = a.second;
     for (auto xy : grEdgList) {
       auto grEdg = gg->getGrEdgById(xy);
-      auto varName = getEdgUseVar(grEdg, cEdg);
-      sol[varName] = 1;
+      sol.edgUse[{grEdg, cEdg}] = 1;
     }
   }
 
@@ -825,3 +861,22 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
   // typically be filled by the solver using the information given above
   return sol;
 }
+
+// _____________________________________________________________________________
+StarterSol ILPGridOptimizer::getStarter(const ILPVars& feasible,
+                                        const ILPVars& vars) const {
+  StarterSol sol;
+
+  // variables which were not added to the problem are skipped
+  for (const auto& v : feasible.statPos) {
+    int col = getStatPosCol(vars, v.first.first, v.first.second);
+    if (col > -1) sol[col] = v.second;
+  }
+
+  for (const auto& v : feasible.edgUse) {
+    int col = getEdgUseCol(vars, v.first.first, v.first.second);
+    if (col > -1) sol[col] = v.second;
+  }
+
+  return sol;
+}
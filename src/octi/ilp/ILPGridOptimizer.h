@@ -5,6 +5,8 @@
 #ifndef OCTI_ILP_ILPGRIDOPTIMIZER_H_
 #define OCTI_ILP_ILPGRIDOPTIMIZER_H_
 
+#include <map>
+#include <utility>
 #include <vector>
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/combgraph/CombGraph.h"
@@ -43,6 +45,13 @@ inline ILPStats operator+(const ILPStats& lh, const ILPStats& rh) {
   return ret;
 }
 
+// edge use and station position variables, identified by the grid graph and
+// combination graph entities they belong to
+struct ILPVars {
+  std::map<std::pair<const GridEdge*, const CombEdge*>, int> edgUse;
+  std::map<std::pair<const GridNode*, const CombNode*>, int> statPos;
+};
+
 class ILPGridOptimizer {
  public:
   ILPGridOptimizer() {}
@@ -55,21 +64,34 @@ class ILPGridOptimizer {
                     const std::string& path) const;
 
  protected:
+  // the column ids of the edge use and station position variables are
+  // written to vars, variables and constraints are only named if names is
+  // true
   shared::optim::ILPSolver* createProblem(
       BaseGraph* gg, const CombGraph& cg,
       const basegraph::GeoPensMap* geoPensMap, double maxGrDist,
-      const std::string& solverStr) const;
+      const std::string& solverStr, bool names, ILPVars* vars) const;
 
   std::string getEdgUseVar(const GridEdge* e, const CombEdge* cg) const;
   std::string getStatPosVar(const GridNode* e, const CombNode* cg) const;
 
-  void extractSolution(shared::optim::ILPSolver* lp, BaseGraph* gg,
-                       const CombGraph& cg, combgraph::Drawing* d) const;
+  // column ids of variables, -1 if the variable does not exist
+  static int getEdgUseCol(const ILPVars& vars, const GridEdge* e,
+                          const CombEdge* cg);
+  static int getStatPosCol(const ILPVars& vars, const GridNode* n,
+                           const CombNode* cg);
+
+  void extractSolution(shared::optim::ILPSolver* lp, const ILPVars& vars,
+                       BaseGraph* gg, const CombGraph& cg,
+                       combgraph::Drawing* d) const;
+
+  // the values of the variables in the heuristic drawing d
+  ILPVars extractFeasibleSol(combgraph::Drawing* d, BaseGraph* gg,
+                             const CombGraph& cg, double maxGrDist) const;
 
-  shared::optim::StarterSol extractFeasibleSol(combgraph::Drawing* d,
-                                               BaseGraph* gg,
-                                               const CombGraph& cg,
-                                               double maxGrDist) const;
+  // map the values in feasible to the columns of vars
+  shared::optim::StarterSol getStarter(const ILPVars& feasible,
+                                       const ILPVars& vars) const;
 
   size_t nonInfDeg(const GridNode* g) const;
 };
@@ -1,12 +1,202 @@
 // Copyright 2016
 // Author: Patrick Brosi
 
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "octi/Octilinearizer.h"
+#include "octi/basegraph/GridAStar.h"
+#include "octi/basegraph/GridGraph.h"
+#include "octi/basegraph/HexGridGraph.h"
+#include "octi/basegraph/OctiGridGraph.h"
 #include "util/Misc.h"
+#include "util/graph/Dijkstra.h"
+
+using octi::GridCost;
+using octi::basegraph::BaseGraph;
+using octi::basegraph::GeoPens;
+using octi::basegraph::GridAStar;
+using octi::basegraph::GridEdgList;
+using octi::basegraph::GridGraph;
+using octi::basegraph::GridNdList;
+using octi::basegraph::GridNode;
+using octi::basegraph::HexGridGraph;
+using octi::basegraph::NodeCost;
+using octi::basegraph::OctiGridGraph;
+using octi::basegraph::Penalties;
+using octi::basegraph::SOFT_INF;
+using util::graph::Dijkstra;
+
+struct ZeroHeur
+    : public Dijkstra::HeurFunc<octi::basegraph::GridNodePL,
+                                octi::basegraph::GridEdgePL, float> {
+  float operator()(const GridNode* from,
+                   const std::set<GridNode*>& to) const {
+    UNUSED(from);
+    UNUSED(to);
+    return 0;
+  }
+};
+
+// _____________________________________________________________________________
+double pathCost(const GridEdgList& res) {
+  double ret = 0;
+  for (auto e : res) ret += static_cast<float>(e->pl().cost());
+  return ret;
+}
+
+// _____________________________________________________________________________
+void testAStar(BaseGraph* gg, std::mt19937* rng) {
+  gg->init();
+
+  std::vector<GridNode*> grNds;
+  for (auto n : gg->getNds()) {
+    if (n->pl().getParent() == n) grNds.push_back(n);
+  }
+
+  GridAStar aStar;
+  size_t found = 0;
+
+  for (size_t round = 0; round < 200; round++) {
+    gg->reset();
+
+    // random additional grid edge costs and closed turns
+    for (auto n : gg->getNds()) {
+      for (auto e : n->getAdjListOut()) {
+        if (e->pl().isSecondary() || (*rng)() % 3) continue;
+        e->pl().setCost(e->pl().cost() + ((*rng)() % 20) * 0.25);
+      }
+    }
+
+    for (size_t i = 0; i < 10; i++) {
+      gg->closeTurns(grNds[(*rng)() % grNds.size()]);
+    }
+
+    std::set<GridNode*> from, to;
+    size_t numFrom = 1 + (*rng)() % 3, numTo = 1 + (*rng)() % 3;
+    for (size_t i = 0; i < numFrom; i++) {
+      from.insert(grNds[(*rng)() % grNds.size()]);
+    }
+    for (size_t i = 0; i < numTo; i++) {
+      auto n = grNds[(*rng)() % grNds.size()];
+      if (!from.count(n)) to.insert(n);
+    }
+    if (to.empty()) continue;
+
+    for (auto n : from) gg->openSinkFr(n, ((*rng)() % 4) * 0.5);
+    for (auto n : to) gg->openSinkTo(n, ((*rng)() % 4) * 0.5);
+
+    for (auto n : to) {
+      if ((*rng)() % 2) continue;
+      NodeCost c;
+      for (size_t i = 0; i < gg->maxDeg(); i++) {
+        // costs below -1 soft close the port
+        c[i] = (*rng)() % 5 ? ((*rng)() % 3) * 0.5 : -2;
+      }
+      gg->addCostVec(n, c);
+    }
+
+    // every fourth search with a cutoff
+    float inf = round % 4 ? std::numeric_limits<float>::infinity() : 8.1;
+
+    GridEdgList dEdgs, aEdgs;
+    GridNdList dNds, aNds;
+
+    Dijkstra::shortestPath(from, to, GridCost(inf), ZeroHeur(), &dEdgs,
+                           &dNds);
+    bool aFound = aStar.shortestPath(gg, from, to, GridCost(inf), ZeroHeur(),
+                                     &aEdgs, &aNds);
+
+    TEST(aFound, ==, (dNds.size() > 0));
+
+    if (aFound) {
+      found++;
+
+      TEST(std::fabs(pathCost(aEdgs) - pathCost(dEdgs)), <, 1e-3);
+
+      // the path runs from a source to a target, as in util's Dijkstra
+      TEST(aNds.size(), ==, aEdgs.size() + 1);
+      TEST(to.count(aNds.front()), ==, 1);
+      TEST(from.count(aNds.back()), ==, 1);
+      for (size_t i = 0; i < aEdgs.size(); i++) {
+        TEST(aEdgs[i]->getTo(), ==, aNds[i]);
+        TEST(aEdgs[i]->getFrom(), ==, aNds[i + 1]);
+      }
+
+      // the heuristic of the base graph only guides the search, without a
+      // cutoff it must find a path as well
+      aEdgs.clear();
+      aNds.clear();
+      auto heur = gg->getHeur(to);
+      bool hFound = aStar.shortestPath(gg, from, to, GridCost(inf), *heur,
+                                       &aEdgs, &aNds);
+      delete heur;
+
+      if (inf == std::numeric_limits<float>::infinity()) {
+        TEST(hFound, ==, true);
+      }
+      if (hFound) {
+        TEST(to.count(aNds.front()), ==, 1);
+
+        // the grid heuristics are admissible, but not consistent, and settled
+        // nodes are never reopened: the path may be longer than the optimum,
+        // but not by much
+        double hCost = pathCost(aEdgs), dCost = pathCost(dEdgs);
+        TEST(hCost, >=, dCost - 1e-3);
+        TEST(hCost, <=, 2 * dCost + 1e-3);
+      }
+    }
+
+    for (auto n : from) gg->closeSinkFr(n);
+    for (auto n : to) gg->closeSinkTo(n);
+  }
+
+  TEST(found, >, 0);
+}
+
+// _____________________________________________________________________________
+void testGeoPens() {
+  // a dense and a sparse id range
+  for (uint32_t step : {1, 100}) {
+    std::vector<std::pair<uint32_t, float>> pens;
+    for (uint32_t i = 0; i < 50; i++) pens.emplace_back(1000 + i * step, i);
+    GeoPens geoPens(pens);
+
+    for (uint32_t i = 0; i < 50; i++) {
+      TEST(geoPens.get(1000 + i * step), ==, i);
+    }
+    TEST(geoPens.get(0), ==, SOFT_INF);
+    TEST(geoPens.get(999), ==, SOFT_INF);
+    TEST(geoPens.get(1001 + 49 * step), ==, SOFT_INF);
+    if (step > 1) TEST(geoPens.get(1001), ==, SOFT_INF);
+  }
+
+  TEST(GeoPens().get(0), ==, SOFT_INF);
+}
 
 // _____________________________________________________________________________
 int main(int argc, char** argv) {
   UNUSED(argc);
   UNUSED(argv);
 
+  testGeoPens();
+
+  Penalties pens;
+  util::geo::DBox box(util::geo::DPoint(0, 0), util::geo::DPoint(100, 80));
+
+  std::mt19937 rng(1);
+
+  OctiGridGraph octiGrid(box, 10, 2, pens);
+  testAStar(&octiGrid, &rng);
+
+  HexGridGraph hexGrid(box, 10, 2, pens);
+  testAStar(&hexGrid, &rng);
+
+  GridGraph orthoGrid(box, 10, 2, pens);
+  testAStar(&orthoGrid, &rng);
+
   return 0;
 }
@@ -4,6 +4,7 @@
 
 #ifdef COIN_FOUND
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
@@ -165,9 +166,67 @@ void COINSolver::addColToRow(int rowId, int colId, double coef) {
   _model.setElement(rowId, colId, coef);
 }
 
+// _____________________________________________________________________________
+void COINSolver::addCols(const ColBatch& cols) {
+  assert(cols.getFirstId() == getNumVars());
+
+  for (size_t i = 0; i < cols.size(); i++) {
+    const char* name = 0;
+    if (cols.getNames().size() && cols.getNames()[i].size())
+      name = cols.getNames()[i].c_str();
+
+    double lowBnd = std::max(cols.getLowBnds()[i], -COIN_DBL_MAX);
+    double upBnd = std::min(cols.getUpBnds()[i], COIN_DBL_MAX);
+
+    if (cols.getTypes()[i] == BIN) {
+      lowBnd = 0;
+      upBnd = 1;
+    }
+
+    _model.addCol(0, 0, 0, lowBnd, upBnd, cols.getObjCoefs()[i], name,
+                  cols.getTypes()[i] != CONT);
+  }
+}
+
+// _____________________________________________________________________________
+void COINSolver::addRows(const RowBatch& rows) {
+  assert(rows.getFirstId() == getNumConstrs());
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    const char* name = 0;
+    if (rows.getNames().size() && rows.getNames()[i].size())
+      name = rows.getNames()[i].c_str();
+
+    double lowBnd = -COIN_DBL_MAX;
+    double upBnd = COIN_DBL_MAX;
+
+    switch (rows.getTypes()[i]) {
+      case FIX:
+        lowBnd = upBnd = rows.getBnds()[i];
+        break;
+      case UP:
+        upBnd = rows.getBnds()[i];
+        break;
+      case LO:
+        lowBnd = rows.getBnds()[i];
+        break;
+    }
+
+    size_t start = rows.getStarts()[i];
+    size_t num = rows.getStarts()[i + 1] - start;
+    _model.addRow(num, rows.getCols().data() + start,
+                  rows.getCoefs().data() + start, lowBnd, upBnd, name);
+  }
+}
+
 // _____________________________________________________________________________
 double COINSolver::getObjVal() const { return _solver->getObjValue(); }
 
+// _____________________________________________________________________________
+double COINSolver::getBestBound() const {
+  return _cbcModel.getBestPossibleObjValue();
+}
+
 // _____________________________________________________________________________
 SolveType COINSolver::solve() {
   _solver->loadFromCoinModel(_model);
@@ -236,6 +295,22 @@ double COINSolver::getVarVal(const std::string& colName) const {
   return getVarVal(getVarByName(colName));
 }
 
+// _____________________________________________________________________________
+void COINSolver::getVarVals(std::vector<double>* vals) const {
+  vals->assign(_solver->getColSolution(),
+               _solver->getColSolution() + getNumVars());
+}
+
+// _____________________________________________________________________________
+std::string COINSolver::getVarName(int colId) const {
+  const char* name = _model.getColumnName(colId);
+  if (name) return name;
+
+  std::stringstream ss;
+  ss << "C" << colId;
+  return ss.str();
+}
+
 // _____________________________________________________________________________
 void COINSolver::setObjCoef(const std::string& colName, double coef) const {
   setObjCoef(getVarByName(colName), coef);
@@ -35,11 +35,16 @@ class COINSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void addCols(const ColBatch& cols);
+  void addRows(const RowBatch& rows);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
   double getVarVal(int colId) const;
   double getVarVal(const std::string& name) const;
+  void getVarVals(std::vector<double>* vals) const;
+  std::string getVarName(int colId) const;
 
   void setObjCoef(const std::string& name, double coef) const;
   void setObjCoef(int colId, double coef) const;
@@ -49,6 +54,7 @@ class COINSolver : public ILPSolver {
   void update();
 
   double getObjVal() const;
+  double getBestBound() const;
 
   int getNumConstrs() const;
   int getNumVars() const;
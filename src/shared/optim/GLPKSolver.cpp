@@ -17,11 +17,16 @@ using shared::optim::GLPKSolver;
 using shared::optim::SolveType;
 using shared::optim::VariableMatrix;
 
+// _____________________________________________________________________________
+static std::mutex glpkEnvMutex;
+
 // _____________________________________________________________________________
 GLPKSolver::GLPKSolver(DirType dir)
-    : _starterArr(0),
+    : _envLock(glpkEnvMutex),
+      _starterArr(0),
       _status(INF),
-      _timeLimit(std::numeric_limits<int>::max()) {
+      _timeLimit(std::numeric_limits<int>::max()),
+      _bestBnd(0) {
   const char* ver = glp_version();
   LOGTO(DEBUG, std::cerr) << "Creating GLPK solver v" << ver << " instance...";
 
@@ -129,7 +134,84 @@ void GLPKSolver::addColToRow(const std::string& rowName,
     LOGTO(ERROR, std::cerr) << "Could not find constraint " << rowName;
   }
 
-  addColToRow(col, row, coef);
+  addColToRow(row, col, coef);
+}
+
+// _____________________________________________________________________________
+void GLPKSolver::addCols(const ColBatch& cols) {
+  assert(cols.getFirstId() == getNumVars());
+  if (cols.size() == 0) return;
+
+  int first = glp_add_cols(_prob, cols.size());
+
+  for (size_t i = 0; i < cols.size(); i++) {
+    int col = first + i;
+    switch (cols.getTypes()[i]) {
+      case INT:
+        glp_set_col_kind(_prob, col, GLP_IV);
+        break;
+      case BIN:
+        glp_set_col_kind(_prob, col, GLP_BV);
+        break;
+      case CONT:
+        glp_set_col_kind(_prob, col, GLP_CV);
+        break;
+    }
+
+    glp_set_obj_coef(_prob, col, cols.getObjCoefs()[i]);
+    if (cols.getNames().size() && cols.getNames()[i].size())
+      glp_set_col_name(_prob, col, cols.getNames()[i].c_str());
+
+    double lowBnd = cols.getLowBnds()[i];
+    double upBnd = cols.getUpBnds()[i];
+    bool noLow = lowBnd <= -std::numeric_limits<double>::max();
+    bool noUp = upBnd >= std::numeric_limits<double>::max();
+
+    // binary columns are already bounded by their kind
+    if (noLow && noUp && cols.getTypes()[i] == BIN) continue;
+
+    if (noLow && noUp) {
+      glp_set_col_bnds(_prob, col, GLP_FR, 0, 0);
+    } else if (noLow) {
+      glp_set_col_bnds(_prob, col, GLP_UP, 0, upBnd);
+    } else if (noUp) {
+      glp_set_col_bnds(_prob, col, GLP_LO, lowBnd, 0);
+    } else if (lowBnd == upBnd) {
+      glp_set_col_bnds(_prob, col, GLP_FX, lowBnd, upBnd);
+    } else {
+      glp_set_col_bnds(_prob, col, GLP_DB, lowBnd, upBnd);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void GLPKSolver::addRows(const RowBatch& rows) {
+  assert(rows.getFirstId() == getNumConstrs());
+  if (rows.size() == 0) return;
+
+  int first = glp_add_rows(_prob, rows.size());
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    int row = first + i;
+    double bnd = rows.getBnds()[i];
+    switch (rows.getTypes()[i]) {
+      case FIX:
+        glp_set_row_bnds(_prob, row, GLP_FX, bnd, bnd);
+        break;
+      case UP:
+        glp_set_row_bnds(_prob, row, GLP_UP, bnd, bnd);
+        break;
+      case LO:
+        glp_set_row_bnds(_prob, row, GLP_LO, bnd, bnd);
+        break;
+    }
+
+    if (rows.getNames().size() && rows.getNames()[i].size())
+      glp_set_row_name(_prob, row, rows.getNames()[i].c_str());
+
+    for (size_t j = rows.getStarts()[i]; j < rows.getStarts()[i + 1]; j++)
+      _vm.addVar(row, rows.getCols()[j] + 1, rows.getCoefs()[j]);
+  }
 }
 
 // _____________________________________________________________________________
@@ -154,6 +236,12 @@ void GLPKSolver::addColToRow(int rowId, int colId, double coef) {
 // _____________________________________________________________________________
 double GLPKSolver::getObjVal() const { return glp_mip_obj_val(_prob); }
 
+// _____________________________________________________________________________
+double GLPKSolver::getBestBound() const {
+  if (_status == OPTIM) return getObjVal();
+  return _bestBnd;
+}
+
 // _____________________________________________________________________________
 SolveType GLPKSolver::solve() {
   update();
@@ -186,6 +274,10 @@ SolveType GLPKSolver::solve() {
   // params.ps_heur = GLP_ON;
 
   glp_simplex(_prob, &sparams);
+
+  // the LP relaxation bounds the objective until branching improves it
+  if (glp_get_status(_prob) == GLP_OPT) _bestBnd = glp_get_obj_val(_prob);
+
   glp_intopt(_prob, &params);
 
   int optimStat = glp_mip_status(_prob);
@@ -238,6 +330,11 @@ void GLPKSolver::optCb(glp_tree* tree, void* solver) {
         glp_ios_heur_sol(tree, _this->getStarterArr());
       }
       break;
+    case GLP_ISELECT: {
+      int p = glp_ios_best_node(tree);
+      if (p) _this->_bestBnd = glp_ios_node_bound(tree, p);
+      break;
+    }
     default:
       break;
   }
@@ -281,6 +378,24 @@ double GLPKSolver::getVarVal(const std::string& colName) const {
   return getVarVal(col);
 }
 
+// _____________________________________________________________________________
+void GLPKSolver::getVarVals(std::vector<double>* vals) const {
+  vals->resize(getNumVars());
+  for (size_t i = 0; i < vals->size(); i++)
+    (*vals)[i] = glp_mip_col_val(_prob, i + 1);
+}
+
+// _____________________________________________________________________________
+std::string GLPKSolver::getVarName(int colId) const {
+  const char* name = glp_get_col_name(_prob, colId + 1);
+  if (name) return name;
+
+  // GLPK's MPS writer uses the same default names
+  std::stringstream ss;
+  ss << "C" << colId + 1;
+  return ss.str();
+}
+
 // _____________________________________________________________________________
 void GLPKSolver::setObjCoef(const std::string& colName, double coef) const {
   int col = getVarByName(colName);
@@ -307,12 +422,12 @@ int GLPKSolver::getNumVars() const { return glp_get_num_cols(_prob); }
 
 // _____________________________________________________________________________
 void GLPKSolver::setStarter(const StarterSol& starterSol) {
-  _starterArr = new double[getNumVars() + 1];
+  // GLPK expects a value for every variable, default to 0
+  _starterArr = new double[getNumVars() + 1]();
 
   for (const auto& varVal : starterSol) {
-    int colId = getVarByName(varVal.first);
-    if (colId < 0) continue;
-    _starterArr[colId + 1] = varVal.second;
+    if (varVal.first < 0 || varVal.first >= getNumVars()) continue;
+    _starterArr[varVal.first + 1] = varVal.second;
   }
 }
 
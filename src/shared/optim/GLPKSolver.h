@@ -8,6 +8,7 @@
 #ifdef GLPK_FOUND
 
 #include <glpk.h>
+#include <mutex>
 #include <vector>
 #include "shared/optim/ILPSolver.h"
 #include "util/Misc.h"
@@ -39,11 +40,16 @@ class GLPKSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void addCols(const ColBatch& cols);
+  void addRows(const RowBatch& rows);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
   double getVarVal(int colId) const;
   double getVarVal(const std::string& name) const;
+  void getVarVals(std::vector<double>* vals) const;
+  std::string getVarName(int colId) const;
 
   void setObjCoef(const std::string& name, double coef) const;
   void setObjCoef(int colId, double coef) const;
@@ -53,6 +59,7 @@ class GLPKSolver : public ILPSolver {
   void update();
 
   double getObjVal() const;
+  double getBestBound() const;
 
   int getNumConstrs() const;
   int getNumVars() const;
@@ -75,6 +82,11 @@ class GLPKSolver : public ILPSolver {
   double* getStarterArr() const;
 
  private:
+  // GLPK keeps its environment in global state, so an instance holds this
+  // lock for its whole lifetime. Declared first to be acquired before and
+  // released after anything else is done with GLPK.
+  std::unique_lock<std::mutex> _envLock;
+
   glp_prob* _prob;
   VariableMatrix _vm;
 
@@ -84,6 +96,9 @@ class GLPKSolver : public ILPSolver {
 
   int _timeLimit;
 
+  // best bound of the open branch and bound nodes
+  double _bestBnd;
+
   std::string _termBuf;
 
   static void optCb(glp_tree* tree, void* solver);
@@ -4,8 +4,11 @@
 
 #ifdef GUROBI_FOUND
 
+#include <algorithm>
+#include <cassert>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 #include "gurobi_c.h"
 #include "shared/optim/GurobiSolver.h"
 #include "util/Misc.h"
@@ -135,7 +138,83 @@ void GurobiSolver::addColToRow(const std::string& rowName,
     LOGTO(ERROR, std::cerr) << "Could not find constraint " << rowName;
   }
 
-  addColToRow(col, row, coef);
+  addColToRow(row, col, coef);
+}
+
+// _____________________________________________________________________________
+void GurobiSolver::addCols(const ColBatch& cols) {
+  assert(cols.getFirstId() == _numVars);
+  if (cols.size() == 0) return;
+
+  std::vector<char> vtypes(cols.size());
+  std::vector<double> lowBnds(cols.size()), upBnds(cols.size());
+  std::vector<const char*> names;
+
+  for (size_t i = 0; i < cols.size(); i++) {
+    switch (cols.getTypes()[i]) {
+      case INT:
+        vtypes[i] = GRB_INTEGER;
+        break;
+      case BIN:
+        vtypes[i] = GRB_BINARY;
+        break;
+      case CONT:
+        vtypes[i] = GRB_CONTINUOUS;
+        break;
+    }
+    lowBnds[i] = std::max(cols.getLowBnds()[i], -GRB_INFINITY);
+    upBnds[i] = std::min(cols.getUpBnds()[i], GRB_INFINITY);
+  }
+
+  for (const auto& name : cols.getNames()) names.push_back(name.c_str());
+
+  int error = GRBaddvars(_model, cols.size(), 0, 0, 0, 0,
+                         const_cast<double*>(cols.getObjCoefs().data()),
+                         lowBnds.data(), upBnds.data(), vtypes.data(),
+                         names.size() ? const_cast<char**>(names.data()) : 0);
+  if (error) {
+    throw std::runtime_error("Could not add variables");
+  }
+
+  _numVars += cols.size();
+}
+
+// _____________________________________________________________________________
+void GurobiSolver::addRows(const RowBatch& rows) {
+  assert(rows.getFirstId() == _numRows);
+  if (rows.size() == 0) return;
+
+  std::vector<char> senses(rows.size());
+  std::vector<const char*> names;
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    switch (rows.getTypes()[i]) {
+      case FIX:
+        senses[i] = GRB_EQUAL;
+        break;
+      case UP:
+        senses[i] = GRB_LESS_EQUAL;
+        break;
+      case LO:
+        senses[i] = GRB_GREATER_EQUAL;
+        break;
+    }
+  }
+
+  for (const auto& name : rows.getNames()) names.push_back(name.c_str());
+
+  int error = GRBXaddconstrs(
+      _model, rows.size(), rows.getCols().size(),
+      const_cast<size_t*>(rows.getStarts().data()),
+      const_cast<int*>(rows.getCols().data()),
+      const_cast<double*>(rows.getCoefs().data()), senses.data(),
+      const_cast<double*>(rows.getBnds().data()),
+      names.size() ? const_cast<char**>(names.data()) : 0);
+  if (error) {
+    throw std::runtime_error("Could not add rows");
+  }
+
+  _numRows += rows.size();
 }
 
 // _____________________________________________________________________________
@@ -181,15 +260,26 @@ double GurobiSolver::getObjVal() const {
   return objVal;
 }
 
+// _____________________________________________________________________________
+double GurobiSolver::getBestBound() const {
+  double objBound;
+
+  int error = GRBgetdblattr(_model, GRB_DBL_ATTR_OBJBOUND, &objBound);
+  if (error) {
+    throw std::runtime_error("Could not retrieve objective bound.");
+  }
+
+  return objBound;
+}
+
 // _____________________________________________________________________________
 void GurobiSolver::setStarter(const StarterSol& starterSol) {
   _starterArr = new double[getNumVars()];
   std::fill_n(_starterArr, getNumVars(), GRB_UNDEFINED);
 
   for (const auto& varVal : starterSol) {
-    int colId = getVarByName(varVal.first);
-    if (colId < 0) continue;
-    _starterArr[colId] = varVal.second;
+    if (varVal.first < 0 || varVal.first >= getNumVars()) continue;
+    _starterArr[varVal.first] = varVal.second;
   }
 }
 
@@ -371,6 +461,31 @@ double GurobiSolver::getVarVal(const std::string& colName) const {
   return getVarVal(col);
 }
 
+// _____________________________________________________________________________
+void GurobiSolver::getVarVals(std::vector<double>* vals) const {
+  vals->resize(_numVars);
+  if (_numVars == 0) return;
+
+  int error =
+      GRBgetdblattrarray(_model, GRB_DBL_ATTR_X, 0, _numVars, vals->data());
+  if (error) {
+    throw std::runtime_error("Could not retrieve variable values");
+  }
+}
+
+// _____________________________________________________________________________
+std::string GurobiSolver::getVarName(int colId) const {
+  char* name;
+  int error =
+      GRBgetstrattrelement(_model, GRB_STR_ATTR_VARNAME, colId, &name);
+  if (error) {
+    std::stringstream ss;
+    ss << "Could not retrieve name of variable " << colId;
+    throw std::runtime_error(ss.str());
+  }
+  return name;
+}
+
 // _____________________________________________________________________________
 void GurobiSolver::setObjCoef(const std::string& colName, double coef) const {
   int col = getVarByName(colName);
@@ -27,11 +27,16 @@ class GurobiSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void addCols(const ColBatch& cols);
+  void addRows(const RowBatch& rows);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
   double getVarVal(int colId) const;
   double getVarVal(const std::string& name) const;
+  void getVarVals(std::vector<double>* vals) const;
+  std::string getVarName(int colId) const;
 
   void setObjCoef(const std::string& name, double coef) const;
   void setObjCoef(int colId, double coef) const;
@@ -41,6 +46,7 @@ class GurobiSolver : public ILPSolver {
   void update();
 
   double getObjVal() const;
+  double getBestBound() const;
 
   int getNumConstrs() const;
   int getNumVars() const;
@@ -66,7 +72,6 @@ class GurobiSolver : public ILPSolver {
   GRBmodel* _model;
 
   double* _starterArr;
-  StarterSol murr;
 
   SolveType _status;
 
@@ -6,8 +6,10 @@
 #define SHARED_OPTIM_ILPSOLVER_H_
 
 #include <fstream>
+#include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace shared {
 namespace optim {
@@ -17,7 +19,113 @@ enum RowType { FIX, UP, LO };
 enum DirType { MAX, MIN };
 enum SolveType { OPTIM, INF, NON_OPTIM };
 
-typedef std::map<std::string, int> StarterSol;
+// starting solution, column id -> value, columns not contained are left
+// to the solver
+typedef std::map<int, double> StarterSol;
+
+// Batch of columns which is added to a solver at once. Columns are referenced
+// by the id they will have in the solver, names are optional and should only
+// be set if they are needed (e.g. for MPS output).
+class ColBatch {
+ public:
+  // firstId is the id the first column of the batch will have in the solver
+  explicit ColBatch(int firstId) : _firstId(firstId) {}
+
+  int add(ColType colType, double objCoef) {
+    return add(colType, objCoef, -std::numeric_limits<double>::max(),
+               std::numeric_limits<double>::max());
+  }
+
+  int add(ColType colType, double objCoef, double lowBnd, double upBnd) {
+    _types.push_back(colType);
+    _objCoefs.push_back(objCoef);
+    _lowBnds.push_back(lowBnd);
+    _upBnds.push_back(upBnd);
+    if (_names.size()) _names.push_back("");
+    return _firstId + _types.size() - 1;
+  }
+
+  void setName(int colId, const std::string& name) {
+    if (_names.empty()) _names.resize(size());
+    _names[colId - _firstId] = name;
+  }
+
+  void setObjCoef(int colId, double coef) {
+    _objCoefs[colId - _firstId] = coef;
+  }
+
+  bool has(int colId) const {
+    return colId >= _firstId && colId < _firstId + static_cast<int>(size());
+  }
+
+  int getFirstId() const { return _firstId; }
+  size_t size() const { return _types.size(); }
+
+  const std::vector<ColType>& getTypes() const { return _types; }
+  const std::vector<double>& getObjCoefs() const { return _objCoefs; }
+  const std::vector<double>& getLowBnds() const { return _lowBnds; }
+  const std::vector<double>& getUpBnds() const { return _upBnds; }
+
+  // empty if no column was named
+  const std::vector<std::string>& getNames() const { return _names; }
+
+ private:
+  int _firstId;
+  std::vector<ColType> _types;
+  std::vector<double> _objCoefs, _lowBnds, _upBnds;
+  std::vector<std::string> _names;
+};
+
+// Batch of rows which is added to a solver at once, with the coefficients
+// in compressed sparse row format: the coefficients of the i-th row of the
+// batch are getCoefs()[getStarts()[i]] ... getCoefs()[getStarts()[i+1]-1],
+// for the columns at the same positions in getCols().
+class RowBatch {
+ public:
+  // firstId is the id the first row of the batch will have in the solver
+  explicit RowBatch(int firstId) : _firstId(firstId), _starts(1, 0) {}
+
+  // start a new row, coefficients are always added to the last row
+  int add(double bnd, RowType rowType) {
+    _bnds.push_back(bnd);
+    _types.push_back(rowType);
+    _starts.push_back(_cols.size());
+    if (_names.size()) _names.push_back("");
+    return _firstId + _types.size() - 1;
+  }
+
+  void addCoef(int colId, double coef) {
+    _cols.push_back(colId);
+    _coefs.push_back(coef);
+    _starts.back() = _cols.size();
+  }
+
+  void setName(int rowId, const std::string& name) {
+    if (_names.empty()) _names.resize(size());
+    _names[rowId - _firstId] = name;
+  }
+
+  int getFirstId() const { return _firstId; }
+  size_t size() const { return _types.size(); }
+
+  const std::vector<double>& getBnds() const { return _bnds; }
+  const std::vector<RowType>& getTypes() const { return _types; }
+  const std::vector<size_t>& getStarts() const { return _starts; }
+  const std::vector<int>& getCols() const { return _cols; }
+  const std::vector<double>& getCoefs() const { return _coefs; }
+
+  // empty if no row was named
+  const std::vector<std::string>& getNames() const { return _names; }
+
+ private:
+  int _firstId;
+  std::vector<double> _bnds;
+  std::vector<RowType> _types;
+  std::vector<size_t> _starts;
+  std::vector<int> _cols;
+  std::vector<double> _coefs;
+  std::vector<std::string> _names;
+};
 
 class ILPSolver {
  public:
@@ -34,6 +142,11 @@ class ILPSolver {
                            const std::string& colName, double coef) = 0;
   virtual void addColToRow(int rowId, int colId, double coef) = 0;
 
+  // add all columns/rows of a batch, the first id of the batch must be
+  // getNumVars() / getNumConstrs()
+  virtual void addCols(const ColBatch& cols) = 0;
+  virtual void addRows(const RowBatch& rows) = 0;
+
   virtual int getVarByName(const std::string& name) const = 0;
   virtual int getConstrByName(const std::string& name) const = 0;
 
@@ -43,6 +156,11 @@ class ILPSolver {
   virtual double getVarVal(int colId) const = 0;
   virtual double getVarVal(const std::string& name) const = 0;
 
+  // write the values of all columns, indexed by column id, into vals
+  virtual void getVarVals(std::vector<double>* vals) const = 0;
+
+  virtual std::string getVarName(int colId) const = 0;
+
   virtual void setTimeLim(int s) = 0;
   virtual int getTimeLim() const = 0;
 
@@ -61,6 +179,10 @@ class ILPSolver {
 
   virtual double getObjVal() const = 0;
 
+  // best bound on the objective value proven by the last solve, equals
+  // getObjVal() if the solution is optimal
+  virtual double getBestBound() const = 0;
+
   virtual void setStarter(const StarterSol& starterSol) = 0;
 
   virtual int getNumConstrs() const = 0;
@@ -71,7 +193,7 @@ class ILPSolver {
     std::ofstream fo;
     fo.open(path);
 
-    for (auto kv : sol) fo << kv.first << "\t" << kv.second << "\n";
+    for (auto kv : sol) fo << getVarName(kv.first) << "\t" << kv.second << "\n";
   }
 };
 
@@ -91,6 +91,7 @@ void ILPSolverTest::run() {
       TEST(s->getVarVal("z"), ==, approx(1));
 
       TEST(s->getObjVal(), ==, approx(3));
+      TEST(s->getBestBound(), ==, approx(3));
     }
   }
   {
@@ -145,6 +146,71 @@ void ILPSolverTest::run() {
       TEST(s->getVarVal("y"), ==, approx(0));
       TEST(s->getVarVal("z"), ==, approx(1));
 
+      TEST(s->getObjVal(), ==, approx(3));
+    }
+  }
+  {
+    std::vector<ILPSolver*> solvers;
+
+#ifdef GUROBI_FOUND
+    try {
+      solvers.push_back(new GurobiSolver(shared::optim::MAX));
+    } catch (const std::exception& e) {
+    }
+#endif
+
+#ifdef GLPK_FOUND
+    solvers.push_back(new GLPKSolver(shared::optim::MAX));
+#endif
+
+#ifdef COIN_FOUND
+    solvers.push_back(new COINSolver(shared::optim::MAX));
+#endif
+
+    for (auto s : solvers) {
+      shared::optim::ColBatch cols(s->getNumVars());
+      int col1 = cols.add(shared::optim::BIN, 1);
+      int col2 = cols.add(shared::optim::BIN, 1);
+      int col3 = cols.add(shared::optim::INT, 0, 0, 1);
+      cols.setObjCoef(col3, 2);
+      cols.setName(col1, "x");
+
+      TEST(col1, ==, 0);
+      TEST(col2, ==, 1);
+      TEST(col3, ==, 2);
+
+      s->addCols(cols);
+
+      shared::optim::RowBatch rows(s->getNumConstrs());
+      rows.add(4, shared::optim::UP);
+      rows.addCoef(col1, 1);
+      rows.addCoef(col2, 2);
+      rows.addCoef(col3, 3);
+
+      rows.add(1, shared::optim::LO);
+      rows.addCoef(col1, 1);
+      rows.addCoef(col2, 1);
+
+      s->addRows(rows);
+      s->update();
+
+      TEST(s->getNumVars(), ==, 3);
+      TEST(s->getNumConstrs(), ==, 2);
+      TEST(s->getVarByName("x"), ==, 0);
+      TEST(s->getVarName(col1), ==, "x");
+
+      auto ret = s->solve();
+
+      TEST(ret, ==, shared::optim::OPTIM);
+
+      std::vector<double> vals;
+      s->getVarVals(&vals);
+
+      TEST(vals.size(), ==, 3);
+      TEST(vals[col1], ==, approx(1));
+      TEST(vals[col2], ==, approx(0));
+      TEST(vals[col3], ==, approx(1));
+
       TEST(s->getObjVal(), ==, approx(3));
     }
   }